@@ -5,9 +5,9 @@
  */ 
 
 #include "buttons.h"
-#include <avr/io.h>
-#include <avr/interrupt.h>
 #include "timer0.h"
+#include "hal.h"
+#include "trace.h"
 
 // Global variable to keep track of the last button state so that we 
 // can detect changes when an interrupt fires. The lower 4 bits (0 to 3)
@@ -24,32 +24,30 @@ static volatile uint8_t last_button_state;
 static volatile uint8_t button_queue[BUTTON_QUEUE_SIZE];
 static volatile int8_t queue_length;
 
+// button pushes lost because the queue was full
+static volatile uint8_t queue_drops;
+
 // These buttons are not hardware debounced, instead they must be software
 // debounced. The approach to this will be a simple one, rejecting any button
 // pushes within a short period of time after the most recent one
 static volatile uint32_t last_button_time[4];
 #define DEBOUNCE_TIME 30
 
-// Setup interrupt if any of pins C0 to C3 change. We do this
-// using a pin change interrupt. These pins correspond to pin
-// change interrupts PCINT8 to PCINT11 which are covered by
-// Pin change interrupt 1.
+// Auto-repeat of held buttons: the milliseconds to the next repeat (0 if
+// the button isn't held), the gap to the one after, and the repeats not
+// yet collected by button_repeats()
+static volatile uint16_t repeat_wait[NUM_BUTTONS];
+static volatile uint16_t repeat_interval[NUM_BUTTONS];
+static volatile uint8_t repeat_count[NUM_BUTTONS];
+
+// Setup interrupt if any of pins C0 to C3 change (see hal_buttons_init()).
 void init_button_interrupts(void) {
-	cli();
-	// Enable the interrupt (see datasheet page 82)
-	PCICR |= (1<<PCIE1);
-	
-	// Make sure the interrupt flag is cleared (by writing a 
-	// 1 to it) (see datasheet page 82)
-	PCIFR |= (1<<PCIF1);
-	
-	// Choose which pins we're interested in by setting
-	// the relevant bits in the mask register (see datasheet page 83)
-	PCMSK1 |= (1<<PCINT8)|(1<<PCINT9)|(1<<PCINT10)|(1<<PCINT11);	
+	hal_disable_interrupts();
+	hal_buttons_init();
 	
 	// Empty the button push queue
 	queue_length = 0;
-	sei();
+	hal_enable_interrupts();
 	
 	// Set the last button pressed time for all pins to be zero
 	// This is not the current time as that would enforce an ordering
@@ -60,8 +58,43 @@ void init_button_interrupts(void) {
 	}
 }
 
+uint8_t button_drops(void) {
+	return queue_drops;
+}
+
+void button_reset_drops(void) {
+	queue_drops = 0;
+}
+
+uint8_t button_repeats(uint8_t button) {
+	int8_t interrupts_were_enabled = hal_disable_interrupts();
+	uint8_t count = repeat_count[button];
+	repeat_count[button] = 0;
+	hal_restore_interrupts(interrupts_were_enabled);
+	return count;
+}
+
+void button_tick(void) {
+	for(uint8_t pin = 0; pin < NUM_BUTTONS; pin++) {
+		if(repeat_wait[pin] && --repeat_wait[pin] == 0) {
+			if(repeat_count[pin] < 255) {
+				repeat_count[pin]++;
+			}
+			trace(TRACE_BUTTON, pin);
+			repeat_wait[pin] = repeat_interval[pin];
+			// speed up
+			if(repeat_interval[pin] >= BUTTON_REPEAT_FASTEST + BUTTON_REPEAT_STEP) {
+				repeat_interval[pin] -= BUTTON_REPEAT_STEP;
+			} else {
+				repeat_interval[pin] = BUTTON_REPEAT_FASTEST;
+			}
+		}
+	}
+}
+
 int8_t button_pushed(void) {
 	int8_t return_value = NO_BUTTON_PUSHED;	// Assume no button pushed
+	hal_idle();	// this is polled in busy-wait loops
 	if(queue_length > 0) {
 		// Remove the first element off the queue and move all the other
 		// entries closer to the front of the queue. We turn off interrupts (if on)
@@ -70,27 +103,24 @@ int8_t button_pushed(void) {
 		return_value = button_queue[0];
 		
 		// Save whether interrupts were enabled and turn them off
-		int8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
-		cli();
+		int8_t interrupts_were_enabled = hal_disable_interrupts();
 		
 		for(uint8_t i = 1; i < queue_length; i++) {
 			button_queue[i-1] = button_queue[i];
 		}
 		queue_length--;
 		
-		if(interrupts_were_enabled) {
-			// Turn them back on again
-			sei();
-		}
+		// Turn them back on again if they were on
+		hal_restore_interrupts(interrupts_were_enabled);
 	}
 	return return_value;
 }
 
 // Interrupt handler for a change on buttons
-ISR(PCINT1_vect) {
+HAL_ISR(PCINT1_vect) {
 	// Get the current state of the buttons. We'll compare this with
 	// the last state to see what has changed.
-	uint8_t button_state = PINC & 0x0F;
+	uint8_t button_state = hal_button_pins();
 	
 	uint32_t press_time = get_current_time();
 	// Get the time this button press occurred
@@ -103,19 +133,27 @@ ISR(PCINT1_vect) {
 	for(uint8_t pin = 0; pin < NUM_BUTTONS; pin++) {
 		if (button_state & (1<<pin) && !(last_button_state & (1<<pin))) {
 			// This is a transition from 0 to 1 on this pin
-			if (queue_length < BUTTON_QUEUE_SIZE && 
-					press_time >= last_button_time[pin] + DEBOUNCE_TIME) {
-				// Add the button push to the queue (and update the
-				// length of the queue
-				button_queue[queue_length++] = pin;	
+			if (press_time >= last_button_time[pin] + DEBOUNCE_TIME) {
+				if (queue_length < BUTTON_QUEUE_SIZE) {
+					// Add the button push to the queue (and update the
+					// length of the queue
+					button_queue[queue_length++] = pin;
+					trace(TRACE_BUTTON, pin);
+				} else if (queue_drops < 255) {
+					queue_drops++;
+				}
 			}
 			// Any button press, even if it is not added to the queue should
 			// be registered for debouncing
 			last_button_time[pin] = get_current_time();
+			// and starts the wait for it to repeat (again, if it bounced)
+			repeat_wait[pin] = BUTTON_REPEAT_DELAY;
+			repeat_interval[pin] = BUTTON_REPEAT_START;
 		} else if (!(button_state & (1<<pin)) && last_button_state & (1<<pin)) {
 			// This is a transition from 1 to 0 on this pin.
 			// Update the debounce timer anyway because it can bounce on release
 			last_button_time[pin] = get_current_time();
+			repeat_wait[pin] = 0;
 		}
 	}
 	
@@ -36,5 +36,47 @@ void init_button_interrupts(void);
 
 int8_t button_pushed(void);
 
+/* A button held down repeats, after BUTTON_REPEAT_DELAY milliseconds and
+ * then every BUTTON_REPEAT_START, each repeat BUTTON_REPEAT_STEP sooner
+ * than the last down to BUTTON_REPEAT_FASTEST (all can be set at build
+ * time, and a delay of 0 turns repeating off). Repeats are counted rather
+ * than queued, so all of those since the last call can be acted on at
+ * once. Returns the number of repeats (up to 255) of button since the
+ * last call.
+ */
+#ifndef BUTTON_REPEAT_DELAY
+#define BUTTON_REPEAT_DELAY 400
+#endif
+#ifndef BUTTON_REPEAT_START
+#define BUTTON_REPEAT_START 150
+#endif
+#ifndef BUTTON_REPEAT_STEP
+#define BUTTON_REPEAT_STEP 15
+#endif
+#ifndef BUTTON_REPEAT_FASTEST
+#define BUTTON_REPEAT_FASTEST 40
+#endif
+
+// the countdowns are 16 bits, and one of 0 means the button isn't held
+#if BUTTON_REPEAT_DELAY > 65535 || BUTTON_REPEAT_START > 65535
+#error "BUTTON_REPEAT_DELAY and BUTTON_REPEAT_START must be at most 65535"
+#endif
+#if BUTTON_REPEAT_FASTEST < 1 || BUTTON_REPEAT_FASTEST > BUTTON_REPEAT_START
+#error "BUTTON_REPEAT_FASTEST must be from 1 to BUTTON_REPEAT_START"
+#endif
+
+uint8_t button_repeats(uint8_t button);
+
+/* Count down to the next repeats, called every millisecond by the timer
+ * interrupt
+ */
+void button_tick(void);
+
+/* Return the number of button pushes (up to 255) discarded because the
+ * queue was full, since start up or button_reset_drops()
+ */
+uint8_t button_drops(void);
+void button_reset_drops(void);
+
 
 #endif /* BUTTONS_H_ */
\ No newline at end of file
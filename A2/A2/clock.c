@@ -0,0 +1,179 @@
+/*
+ * clock.c
+ *
+ * Game clocks (see clock.h)
+ */
+
+#include <stdio.h>
+#include "clock.h"
+#include "display.h"
+#include "hal.h"
+#include "terminalio.h"
+
+// most time a clock can show, 99:59
+#define MAX_SECONDS 5999
+
+typedef struct {
+	uint8_t minutes;	// each player's time, 0 for an untimed game
+	uint8_t increment;	// seconds added after each move
+} TimeControl;
+
+static const TimeControl time_controls[] PROGMEM = {
+	{0, 0}, {1, 0}, {5, 0}, {1, 1}, {3, 2}, {10, 5}
+};
+#define NUM_TIME_CONTROLS (sizeof(time_controls) / sizeof(TimeControl))
+
+static uint8_t control;			// index into time_controls
+static uint8_t timed;			// the game in progress is timed
+static uint8_t increment;
+
+// Each clock is kept as whole seconds and the milliseconds over, so the
+// interrupt knows when a second passes without dividing.
+static volatile uint16_t seconds[2];
+static volatile uint16_t millis[2];
+static volatile uint8_t running;	// the player whose clock runs, or 0
+static volatile uint8_t flagged;	// the player who ran out of time
+static volatile uint8_t changed;	// a second has passed since draw_clocks()
+
+// what is on the terminal, "MM:SS" with a leading space for one digit of
+// minutes
+#define CLOCK_CHARS 5
+static char shown[2][CLOCK_CHARS];
+
+void clock_next_control(void) {
+	control = (control + 1) % NUM_TIME_CONTROLS;
+}
+
+void clock_print_control(void) {
+	uint8_t minutes = pgm_read_byte(&time_controls[control].minutes);
+	uint8_t extra = pgm_read_byte(&time_controls[control].increment);
+	if(minutes == 0) {
+		printf_P(PSTR("untimed "));
+	} else {
+		printf_P(PSTR("%u+%u   "), minutes, extra);
+	}
+}
+
+void clock_new_game(void) {
+	uint8_t minutes = pgm_read_byte(&time_controls[control].minutes);
+	uint8_t interrupts_were_on = hal_disable_interrupts();
+	for(uint8_t i = 0; i < 2; i++) {
+		seconds[i] = minutes * 60;
+		millis[i] = 0;
+	}
+	running = 0;
+	flagged = 0;
+	changed = 1;
+	hal_restore_interrupts(interrupts_were_on);
+	timed = minutes != 0;
+	increment = pgm_read_byte(&time_controls[control].increment);
+	// the terminal has been cleared, so everything is drawn afresh
+	for(uint8_t i = 0; i < 2; i++) {
+		for(uint8_t c = 0; c < CLOCK_CHARS; c++) {
+			shown[i][c] = 0;
+		}
+	}
+	draw_clocks();
+}
+
+void clock_start(uint8_t player) {
+	if(timed && !flagged) {
+		running = player;
+	}
+}
+
+void clock_stop(void) {
+	running = 0;
+}
+
+void clock_switch(uint8_t player, uint8_t moved) {
+	if(!running) {
+		return;
+	}
+	uint8_t interrupts_were_on = hal_disable_interrupts();
+	if(moved && increment) {
+		uint8_t mover = 3 - player;
+		seconds[mover - 1] += increment;
+		if(seconds[mover - 1] > MAX_SECONDS) {
+			seconds[mover - 1] = MAX_SECONDS;
+		}
+		changed = 1;
+	}
+	running = player;
+	hal_restore_interrupts(interrupts_were_on);
+}
+
+uint8_t clock_flagged(void) {
+	return flagged;
+}
+
+void draw_clocks(void) {
+	if(!timed || !changed) {
+		return;
+	}
+	uint8_t drawn = 0;
+	// whole seconds left, rounded up so 0:00 means out of time, both read
+	// as changed is cleared so that a tick between them isn't missed
+	uint16_t seconds_left[2];
+	uint8_t interrupts_were_on = hal_disable_interrupts();
+	for(uint8_t i = 0; i < 2; i++) {
+		seconds_left[i] = seconds[i] + (millis[i] != 0);
+	}
+	changed = 0;
+	hal_restore_interrupts(interrupts_were_on);
+
+	for(uint8_t i = 0; i < 2; i++) {
+		uint16_t left = seconds_left[i];
+		uint8_t minutes = left / 60;
+		uint8_t secs = left % 60;
+		char text[CLOCK_CHARS] = {
+			minutes >= 10 ? '0' + minutes / 10 : ' ', '0' + minutes % 10,
+			':', '0' + secs / 10, '0' + secs % 10
+		};
+
+		// send only the characters which differ, moving the terminal
+		// cursor only where the one before was left alone
+		uint8_t cursor_here = 0;
+		for(uint8_t c = 0; c < CLOCK_CHARS; c++) {
+			if(text[c] == shown[i][c]) {
+				cursor_here = 0;
+				continue;
+			}
+			if(!cursor_here) {
+				if(i == 0) {
+					set_display_attribute(FG_GREEN);
+					move_terminal_cursor(TERMINAL_BOARD_X - 15 + c, TERMINAL_BOARD_Y + 7);
+				} else {
+					set_display_attribute(FG_RED);
+					move_terminal_cursor(TERMINAL_BOARD_X + 18 + c, TERMINAL_BOARD_Y + 7);
+				}
+				cursor_here = 1;
+			}
+			putchar(text[c]);
+			shown[i][c] = text[c];
+			drawn = 1;
+		}
+	}
+	if(drawn) {
+		normal_display_mode();
+	}
+}
+
+void clock_tick(void) {
+	if(!running) {
+		return;
+	}
+	uint8_t i = running - 1;
+	if(millis[i] == 0) {
+		seconds[i]--;
+		millis[i] = 999;
+	} else if(--millis[i] == 0) {
+		// the time shown (rounded up) goes down a second
+		changed = 1;
+	}
+	if(seconds[i] == 0 && millis[i] == 0) {
+		// out of time, which ends the game
+		flagged = running;
+		running = 0;
+	}
+}
@@ -0,0 +1,47 @@
+/*
+ * clock.h
+ *
+ * Game clocks for timed games. Each player has a clock which counts down
+ * while it is their turn, either sudden death or with a few seconds added
+ * after each of their moves. The clock of the player to move is counted
+ * down by the timer 0 interrupt, which also notices the moment it runs
+ * out, so the game loop does no timing of its own: is_game_over() just
+ * asks clock_flagged().
+ *
+ * The clocks are shown as M:SS beside the board. The interrupt marks them
+ * changed only when a second passes, and draw_clocks() then sends just the
+ * characters which differ from what is on the terminal, which is usually
+ * one digit a second.
+ */
+
+#ifndef CLOCK_H_
+#define CLOCK_H_
+
+#include <stdint.h>
+
+// choose the next time control (untimed is the first), for the start
+// screen, and print the chosen one at the terminal cursor
+void clock_next_control(void);
+void clock_print_control(void);
+
+// set both clocks to the chosen time, stopped, and draw them
+void clock_new_game(void);
+
+// start the clock of the player to move, or stop both clocks
+void clock_start(uint8_t player);
+void clock_stop(void);
+
+// the turn has passed to player. If the other player has just moved
+// (rather than a move being taken back) they get the increment.
+void clock_switch(uint8_t player, uint8_t moved);
+
+// the player whose time has run out, or 0
+uint8_t clock_flagged(void);
+
+// redraw the digits which have changed since they were last drawn
+void draw_clocks(void);
+
+// called by the timer 0 interrupt every millisecond
+void clock_tick(void);
+
+#endif /* CLOCK_H_ */
@@ -0,0 +1,175 @@
+/*
+ * computer.c
+ *
+ * The computer player in the firmware (see computer.h)
+ */
+
+#include "computer.h"
+#include "engine.h"
+#include "game.h"
+#include "mcts.h"
+#include "timer0.h"
+
+// longest slice of searching in each call of computer_service() (ms)
+#define SLICE_TIME 2
+// positions searched between looks at the clock during a slice
+#define SLICE_NODES 16
+
+// how hard the computer thinks about its own move, and when guessing
+// the human's
+#define THINK_DEPTH 6
+#define THINK_TIME 3000
+#define PREDICT_DEPTH 2
+
+static uint8_t computer_player;
+
+uint8_t computer_playing(void) {
+	return computer_player != 0;
+}
+
+uint8_t computer_to_move(void) {
+	return computer_player && game_position()->to_move == computer_player;
+}
+
+#ifdef COMPUTER_MCTS
+/*
+ * Monte Carlo tree search. The tree follows the game, so it searches all
+ * the human's moves while they think and keeps the part under the move
+ * they make.
+ */
+#ifndef COMPUTER_MCTS_NODES
+#define COMPUTER_MCTS_NODES 32
+#endif
+
+static MctsNode pool[COMPUTER_MCTS_NODES];
+static MctsTree tree;
+static uint8_t thinking;	// on its own move, since think_start
+static uint32_t think_start;
+
+void computer_new_game(uint8_t player) {
+	computer_player = player;
+	mcts_init(&tree, pool, COMPUTER_MCTS_NODES, get_current_time() + 1);
+	thinking = 0;
+}
+
+void computer_service(void) {
+	const Position* position = game_position();
+	if(!computer_player || teeko_winner(position)) {
+		return;
+	}
+
+	SearchLimits slice = { .max_time = SLICE_TIME, .clock = get_current_time };
+	mcts_start(&tree, position, &slice);
+	uint8_t finished = mcts_run(&tree, &slice, UINT16_MAX) &&
+			get_current_time() - tree.start_time < SLICE_TIME;
+	if(position->to_move != computer_player) {
+		return;
+	}
+	if(!thinking) {
+		thinking = 1;
+		think_start = get_current_time();
+	}
+	if(finished || get_current_time() - think_start >= THINK_TIME) {
+		SearchResult result;
+		mcts_result(&tree, &result);
+		thinking = 0;
+		play_move(result.move);
+	}
+}
+
+#else
+
+// The one search task. It is kept after it finishes, until a search of
+// another position is needed.
+static SearchTask task;
+static uint8_t have_task;
+static uint8_t task_running;
+static uint8_t task_predicting;	// guessing the human's move
+static uint32_t task_root;		// hash of the position it searches
+
+// the move the human is expected to make from the position with hash
+// predicted_root, or MOVE_NONE
+static Move predicted;
+static uint32_t predicted_root;
+
+static void start_task(const Position* position, uint8_t predicting) {
+	SearchLimits limits = {
+		.max_depth = predicting ? PREDICT_DEPTH : THINK_DEPTH,
+		.max_time = predicting ? 0 : THINK_TIME,
+		.clock = get_current_time
+	};
+	engine_task_start(&task, position, &limits);
+	have_task = 1;
+	task_running = 1;
+	task_predicting = predicting;
+	task_root = position->hash;
+}
+
+// returns 1 if the task is (or was) a search of this position
+static uint8_t task_is_for(const Position* position, uint8_t predicting) {
+	return have_task && task_root == position->hash && task_predicting == predicting;
+}
+
+// search for up to SLICE_TIME ms, returns 1 once the task has finished
+static uint8_t run_slice(void) {
+	uint32_t start = get_current_time();
+	while(task_running && get_current_time() - start < SLICE_TIME) {
+		if(engine_task_run(&task, SLICE_NODES)) {
+			task_running = 0;
+		}
+	}
+	return !task_running;
+}
+
+void computer_new_game(uint8_t player) {
+	computer_player = player;
+	have_task = 0;
+	task_running = 0;
+	predicted = MOVE_NONE;
+}
+
+void computer_service(void) {
+	const Position* position = game_position();
+	SearchResult result;
+	if(!computer_player || teeko_winner(position)) {
+		return;
+	}
+
+	if(position->to_move == computer_player) {
+		if(!task_is_for(position, 0)) {
+			// not the move we pondered on
+			start_task(position, 0);
+		}
+		if(run_slice()) {
+			engine_task_result(&task, &result);
+			have_task = 0;
+			play_move(result.move);
+			predicted = result.reply;
+			predicted_root = game_position()->hash;
+		}
+		return;
+	}
+
+	// The human's turn. Guess their move first if our last search didn't.
+	if(predicted == MOVE_NONE || predicted_root != position->hash) {
+		predicted = MOVE_NONE;
+		if(!task_is_for(position, 1)) {
+			start_task(position, 1);
+		}
+		if(run_slice()) {
+			engine_task_result(&task, &result);
+			predicted = result.move;
+			predicted_root = position->hash;
+		}
+		return;
+	}
+
+	// then ponder our answer to it
+	Position guess = *position;
+	teeko_make(&guess, predicted);
+	if(!task_is_for(&guess, 0)) {
+		start_task(&guess, 0);
+	}
+	run_slice();
+}
+#endif
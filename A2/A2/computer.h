@@ -0,0 +1,38 @@
+/*
+ * computer.h
+ *
+ * The computer player in the firmware. Its search (engine.h) runs as a
+ * background task in slices of a few milliseconds from the main loop, so
+ * the cursor and input stay responsive while it thinks.
+ *
+ * While the human is thinking the computer ponders: it guesses the
+ * human's move (the reply its own last search expected, or else the
+ * result of a quick search from the human's side) and searches its answer
+ * to that. If the human makes the guessed move the search carries on, or
+ * if it has already finished the computer answers straight away.
+ *
+ * Built with COMPUTER_MCTS defined, the computer searches by Monte Carlo
+ * tree search (mcts.h) instead, with a pool of COMPUTER_MCTS_NODES nodes.
+ * Its tree follows the game, so it ponders every reply of the human's.
+ */
+
+#ifndef COMPUTER_H_
+#define COMPUTER_H_
+
+#include <stdint.h>
+
+// set which player (PLAYER_1 or PLAYER_2) the computer plays in the new
+// game, or 0 for a game between two humans
+void computer_new_game(uint8_t player);
+
+// returns 1 while it is the computer's turn (the human can't move)
+uint8_t computer_to_move(void);
+
+// returns 1 if the computer is playing in this game
+uint8_t computer_playing(void);
+
+// think for a slice of time, and move when the search is done. Call this
+// regularly from the main loop.
+void computer_service(void);
+
+#endif /* COMPUTER_H_ */
@@ -2,41 +2,103 @@
  * display.c
  *
  * Authors: Luke Kamols, Jarrod Bennett
- */ 
+ *
+ * The board is drawn through display backends (see display.h). The
+ * terminal and null backends are here, the LED matrix is in ledmatrix.c.
+ */
 
 #include "display.h"
 #include <stdio.h>
-#include <avr/pgmspace.h>
+#include <string.h>
+#include "hal.h"
 #include "terminalio.h"
+#include "trace.h"
+
+// a frame which doesn't match anything, so every cell is repainted
+#define UNKNOWN_OBJECT 0xFF
+
+static const DisplayBackend* const default_backends[] = {
+	&terminal_display,
+	&led_matrix_display,
+	NULL
+};
+static const DisplayBackend* const* backends = default_backends;
+
+void display_set_backends(const DisplayBackend* const* list) {
+	backends = list;
+}
 
 void initialise_display(void) {
+	for (const DisplayBackend* const* backend = backends; *backend; backend++) {
+		(*backend)->init();
+	}
+}
+
+void start_display(void) {
+	move_terminal_cursor(TERMINAL_BOARD_X, TERMINAL_BOARD_Y);
+	set_display_attribute(FG_GREEN);
+	printf_P(PSTR("TEEKO"));
+}
+
+void update_square_colour(uint8_t x, uint8_t y, uint8_t object) {
+	for (const DisplayBackend* const* backend = backends; *backend; backend++) {
+		(*backend)->set_cell(x, y, object);
+	}
+}
+
+void display_flush(void) {
+	for (const DisplayBackend* const* backend = backends; *backend; backend++) {
+		(*backend)->flush();
+	}
+}
+
+/*
+ * Terminal backend. Cells are drawn as two spaces in a background colour
+ * between the lines of the grid.
+ */
+static uint8_t terminal_frame[HEIGHT][WIDTH];	// to be shown
+static uint8_t terminal_shown[HEIGHT][WIDTH];	// on the terminal now
+
+static void terminal_init(void) {
 	// first turn off the cursor
 	hide_cursor();
 
 	// next build an empty board
 	set_display_attribute(FG_YELLOW);
-	for (uint8_t row = 0; row < HEIGHT; row++) {
+	for (uint8_t row = 0; row <= HEIGHT; row++) {
 		move_terminal_cursor(TERMINAL_BOARD_X, TERMINAL_BOARD_Y+2*row);
-		printf_P(PSTR("+--+--+--+--+--+"));
+		for (uint8_t column = 0; column < WIDTH; column++) {
+			printf_P(PSTR("+--"));
+		}
+		printf_P(PSTR("+"));
+		if (row == HEIGHT) {
+			break;
+		}
 		move_terminal_cursor(TERMINAL_BOARD_X, TERMINAL_BOARD_Y+2*row+1);
-		printf_P(PSTR("|  |  |  |  |  |"));
+		for (uint8_t column = 0; column < WIDTH; column++) {
+			printf_P(PSTR("|  "));
+		}
+		printf_P(PSTR("|"));
 	}
-	move_terminal_cursor(TERMINAL_BOARD_X, TERMINAL_BOARD_Y+2*HEIGHT);
-	printf_P(PSTR("+--+--+--+--+--+"));
 
 	// clear the colour settings so we don't print other things in yellow
 	normal_display_mode();
+
+	// the grid has blanked every cell
+	memset(terminal_frame, EMPTY_SQUARE, sizeof(terminal_frame));
+	memset(terminal_shown, UNKNOWN_OBJECT, sizeof(terminal_shown));
 }
 
-void start_display(void) {
-	move_terminal_cursor(TERMINAL_BOARD_X, TERMINAL_BOARD_Y);
-	set_display_attribute(FG_GREEN);
-	printf_P(PSTR("TEEKO"));
+static void terminal_set_cell(uint8_t x, uint8_t y, uint8_t object) {
+	terminal_frame[y][x] = object;
 }
 
-void update_square_colour(uint8_t x, uint8_t y, uint8_t object) {
+static void terminal_paint(uint8_t x, uint8_t y, uint8_t object) {
 	// determine which colour corresponds to this object
 	DisplayParameter backgroundColour;
+	uint8_t hint_piece = object & HINT_PIECE;
+	uint8_t cursor_mark = object & (CURSOR_MARK | CURSOR_PICKER_MARK);
+	object = OBJECT(object);
 	if (object == PLAYER_1) {
 		backgroundColour = TERMINAL_COLOUR_P1;
 	} else if (object == PLAYER_2) {
@@ -46,9 +108,13 @@ void update_square_colour(uint8_t x, uint8_t y, uint8_t object) {
 
 	} else if (object == CURSOR_PICKER) {
 		backgroundColour = TERMINAL_COLOUR_CURSOR_PICKER;
-		
+
 	} else if (object == SQUARE_PICKER) {
 		backgroundColour = TERMINAL_COLOUR_SQUARE_PICKER;
+	} else if (object == THREAT_SQUARE) {
+		backgroundColour = TERMINAL_COLOUR_THREAT;
+	} else if (object == HINT_SQUARE) {
+		backgroundColour = TERMINAL_COLOUR_HINT;
 	} else {
 		// anything unexpected will be black
 		backgroundColour = TERMINAL_COLOUR_EMPTY;
@@ -64,7 +130,81 @@ void update_square_colour(uint8_t x, uint8_t y, uint8_t object) {
 	// but our referencing counts from the bottom, so the y position is inverted
 	move_terminal_cursor(TERMINAL_BOARD_X + 1 + 3 * x,
 	TERMINAL_BOARD_Y + 1 + 2 * (HEIGHT - y - 1));
-	printf_P(PSTR("  ")); // print two spaces, since we set the background colour
+	if (cursor_mark) {
+		// the terminal flashes the mark, over the colour of the square
+		set_display_attribute(TERM_BLINK);
+		set_display_attribute(cursor_mark == CURSOR_MARK ? FG_YELLOW : FG_CYAN);
+		printf_P(PSTR("[]"));
+	} else if (hint_piece) {
+		// mark the piece in the hint colour
+		set_display_attribute(FG_BLUE);
+		printf_P(PSTR("<>"));
+	} else {
+		printf_P(PSTR("  ")); // print two spaces, since we set the background colour
+	}
 
 	normal_display_mode(); // remove the display attribute
-}
\ No newline at end of file
+}
+
+static void terminal_flush(void) {
+	uint8_t painted = 0;
+	for (uint8_t y = 0; y < HEIGHT; y++) {
+		for (uint8_t x = 0; x < WIDTH; x++) {
+			if (terminal_frame[y][x] != terminal_shown[y][x]) {
+				if (!painted) {
+					trace(TRACE_BEGIN + STAGE_REPAINT, 0);
+					painted = 1;
+				}
+				terminal_paint(x, y, terminal_frame[y][x]);
+				terminal_shown[y][x] = terminal_frame[y][x];
+			}
+		}
+	}
+	if (painted) {
+		trace(TRACE_END + STAGE_REPAINT, 0);
+	}
+}
+
+const DisplayBackend terminal_display = {
+	terminal_init, terminal_set_cell, terminal_flush
+};
+
+/*
+ * Null backend, which keeps the frame in memory and counts the cells
+ * it would have repainted
+ */
+static uint8_t null_frame[HEIGHT][WIDTH];
+static uint8_t null_shown[HEIGHT][WIDTH];
+static uint32_t null_repaints;
+
+static void null_init(void) {
+	memset(null_frame, EMPTY_SQUARE, sizeof(null_frame));
+	memset(null_shown, UNKNOWN_OBJECT, sizeof(null_shown));
+}
+
+static void null_set_cell(uint8_t x, uint8_t y, uint8_t object) {
+	null_frame[y][x] = object;
+}
+
+static void null_flush(void) {
+	for (uint8_t y = 0; y < HEIGHT; y++) {
+		for (uint8_t x = 0; x < WIDTH; x++) {
+			if (null_frame[y][x] != null_shown[y][x]) {
+				null_shown[y][x] = null_frame[y][x];
+				null_repaints++;
+			}
+		}
+	}
+}
+
+const DisplayBackend null_display = {
+	null_init, null_set_cell, null_flush
+};
+
+uint8_t null_display_cell(uint8_t x, uint8_t y) {
+	return null_shown[y][x];
+}
+
+uint32_t null_display_repaints(void) {
+	return null_repaints;
+}
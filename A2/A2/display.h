@@ -10,9 +10,9 @@
 
 #include <stdint.h>
 
-// display dimensions, these match the size of the board
-#define WIDTH  5
-#define HEIGHT 5
+// display dimensions (WIDTH and HEIGHT), these match the size of the
+// board chosen at build time
+#include "teeko_tables.h"
 
 // positioning of the top left corner of the board on the terminal
 #define TERMINAL_BOARD_X 45
@@ -26,6 +26,20 @@
 /*. The cursor should flash a different colour while a piece is picked up. */
 #define CURSOR_PICKER   4
 #define SQUARE_PICKER   5
+// the hint overlay: empty squares where the other player could win next
+// move, and where the player to move can win
+#define THREAT_SQUARE   6
+#define HINT_SQUARE     7
+// or'd with PLAYER_1 or PLAYER_2 for a piece which can move to win
+#define HINT_PIECE      0x80
+// In CURSOR_BLINK builds the cursor isn't an object of its own but one of
+// these or'd with whatever is under it. The terminal shows a mark which
+// it flashes itself (the blink attribute), the LED matrix the cursor's
+// colour.
+#define CURSOR_MARK         0x40
+#define CURSOR_PICKER_MARK  0x20
+// the object without the marks above
+#define OBJECT(object)  ((object) & 0x1F)
 
 // terminal colour definitions
 #define TERMINAL_COLOUR_EMPTY			BG_BLACK
@@ -35,6 +49,29 @@
 
 #define TERMINAL_COLOUR_CURSOR_PICKER	BG_CYAN
 #define TERMINAL_COLOUR_SQUARE_PICKER	BG_WHITE
+#define TERMINAL_COLOUR_THREAT			BG_MAGENTA
+#define TERMINAL_COLOUR_HINT			BG_BLUE
+
+// A display backend shows the board on one device. set_cell() records
+// what a square should show, and flush() sends the squares which differ
+// from what the device showed after the last flush, so drawing the same
+// thing twice costs nothing. init() clears the device to an empty board.
+typedef struct {
+	void (*init)(void);
+	void (*set_cell)(uint8_t x, uint8_t y, uint8_t object);
+	void (*flush)(void);
+} DisplayBackend;
+
+// the serial terminal
+extern const DisplayBackend terminal_display;
+// the LED matrix on the SPI bus (ledmatrix.c)
+extern const DisplayBackend led_matrix_display;
+// a frame in memory only, for tests and benchmarks
+extern const DisplayBackend null_display;
+
+// choose the backends to draw on, a NULL terminated list. By default the
+// board is drawn on the terminal and the LED matrix.
+void display_set_backends(const DisplayBackend* const* list);
 
 // initialise the display for the board, this creates the display
 // for an empty board
@@ -46,8 +83,17 @@ void start_display(void);
 // updates the colour at square (x, y) to be the colour
 // of the object 'object'
 // 'object' is expected to be EMPTY_SQUARE, PLAYER_1, PLAYER_2 or 
-// CURSOR
+// CURSOR (or one of the other objects above)
+// The change is shown by the next display_flush().
 void update_square_colour(uint8_t x, uint8_t y, uint8_t object);
 
+// show the squares which have changed since the last flush
+void display_flush(void);
+
+// what the null backend shows at (x, y), and the number of squares it
+// has repainted
+uint8_t null_display_cell(uint8_t x, uint8_t y);
+uint32_t null_display_repaints(void);
+
 
 #endif /* DISPLAY_H_ */
\ No newline at end of file
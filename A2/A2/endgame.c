@@ -0,0 +1,223 @@
+/*
+ * endgame.c
+ *
+ * Endgame table probes (see endgame.h)
+ *
+ * A set of squares s1 < s2 < ... < sk is numbered C(s1, 1) + C(s2, 2) +
+ * ... + C(sk, k), which counts the sets of k squares which come before it
+ * (the combinatorial number system), with the binomial coefficients from
+ * set_numbers[] in flash. A position is numbered by the set of the mover's
+ * squares, then the set of the other player's among the squares left.
+ * Positions are probed at the root and the shallow leaves of the search,
+ * so this works on the squares of the 8 pieces rather than on whole
+ * boards, and first checks a filter of the positions' signatures
+ * (endgame_signature()).
+ */
+
+#include "endgame.h"
+#include "endgame_table.h"
+
+#if PIECES_PER_PLAYER > WIN_SHAPE_SQUARES
+#error "set_numbers[] only numbers sets of up to WIN_SHAPE_SQUARES squares"
+#endif
+
+// a table made for another variant is left out
+#if ENDGAME_TABLE_WIDTH == WIDTH && ENDGAME_TABLE_HEIGHT == HEIGHT && \
+		ENDGAME_TABLE_SQUARE_WINS == SQUARE_WINS
+#define ENTRIES ENDGAME_TABLE_ENTRIES
+#else
+#define ENTRIES 0
+#endif
+
+// the square a symmetry moves square to
+static uint8_t transform(uint8_t square, uint8_t symmetry) {
+	uint8_t x = pgm_read_byte(&square_x[square]);
+	uint8_t y = pgm_read_byte(&square_y[square]);
+	if(symmetry & 4) {
+		uint8_t swap = x;
+		x = y;
+		y = swap;
+	}
+	if(symmetry & 1) {
+		x = WIDTH - 1 - x;
+	}
+	if(symmetry & 2) {
+		y = HEIGHT - 1 - y;
+	}
+	return y * WIDTH + x;
+}
+
+// the squares of a player's pieces, lowest first
+static void piece_squares(Bitboard pieces, uint8_t* squares) {
+	uint8_t count = 0;
+	for(uint8_t square = 0; pieces; square++, pieces >>= 1) {
+		if(pieces & 1) {
+			squares[count++] = square;
+		}
+	}
+}
+
+// the squares of a player's pieces after a symmetry, lowest first
+static void transform_squares(const uint8_t* squares, uint8_t symmetry, uint8_t* moved) {
+	for(uint8_t i = 0; i < PIECES_PER_PLAYER; i++) {
+		uint8_t square = transform(squares[i], symmetry);
+		uint8_t j = i;
+		for(; j > 0 && moved[j - 1] > square; j--) {
+			moved[j] = moved[j - 1];
+		}
+		moved[j] = square;
+	}
+}
+
+static uint32_t set_number(uint8_t k, uint8_t square) {
+	return pgm_read_dword(&set_numbers[k][square]);
+}
+
+static uint32_t mine_number(const uint8_t* mine) {
+	uint32_t number = 0;
+	for(uint8_t k = 0; k < PIECES_PER_PLAYER; k++) {
+		number += set_number(k, mine[k]);
+	}
+	return number;
+}
+
+// their squares numbered among those left by mine
+static uint32_t theirs_number(const uint8_t* mine, const uint8_t* theirs) {
+	uint32_t number = 0;
+	for(uint8_t k = 0; k < PIECES_PER_PLAYER; k++) {
+		uint8_t below = 0;
+		for(uint8_t i = 0; i < PIECES_PER_PLAYER; i++) {
+			below += mine[i] < theirs[k];
+		}
+		number += set_number(k, theirs[k] - below);
+	}
+	return number;
+}
+
+// the number of sets of the other player's squares, C(NUM_SQUARES -
+// PIECES_PER_PLAYER, PIECES_PER_PLAYER)
+static uint32_t theirs_sets(void) {
+	return set_number(PIECES_PER_PLAYER - 1, NUM_SQUARES - PIECES_PER_PLAYER);
+}
+
+static uint16_t mix(uint16_t value) {
+	value *= 0x9E37;
+	value ^= value >> 7;
+	value *= 0x3B29;
+	return value ^ (value >> 9);
+}
+
+/*
+ * Every symmetry turns the board about its middle, so with coordinates
+ * from the middle (doubled, to keep them whole) it keeps each square's
+ * distances across and down (swapped, on a square board), the lengths of
+ * the sums of each player's squares and the product of those sums. The
+ * signature hashes the first for each piece, in no particular order, and
+ * then the others.
+ */
+static uint16_t signature(const uint8_t* mine, const uint8_t* theirs) {
+	int8_t sums[4] = { 0 };		// across and down, for each player
+	uint16_t hash = 0;
+	for(uint8_t i = 0; i < 2 * PIECES_PER_PLAYER; i++) {
+		uint8_t side = i >= PIECES_PER_PLAYER;
+		uint8_t square = side ? theirs[i - PIECES_PER_PLAYER] : mine[i];
+		int8_t x = 2 * pgm_read_byte(&square_x[square]) - (WIDTH - 1);
+		int8_t y = 2 * pgm_read_byte(&square_y[square]) - (HEIGHT - 1);
+		sums[2 * side] += x;
+		sums[2 * side + 1] += y;
+		uint8_t across = x < 0 ? -x : x;
+		uint8_t down = y < 0 ? -y : y;
+		if(WIDTH == HEIGHT && across < down) {
+			hash += mix(side << 8 | down << 4 | across);
+		} else {
+			hash += mix(side << 8 | across << 4 | down);
+		}
+	}
+	hash = mix(hash ^ (sums[0] * sums[0] + sums[1] * sums[1]));
+	hash = mix(hash ^ (sums[2] * sums[2] + sums[3] * sums[3]));
+	return mix(hash ^ (uint16_t)(sums[0] * sums[2] + sums[1] * sums[3]));
+}
+
+uint16_t endgame_signature(Bitboard mine, Bitboard theirs) {
+	uint8_t my_squares[PIECES_PER_PLAYER], their_squares[PIECES_PER_PLAYER];
+	piece_squares(mine, my_squares);
+	piece_squares(theirs, their_squares);
+	return signature(my_squares, their_squares);
+}
+
+uint32_t endgame_index(Bitboard mine, Bitboard theirs, uint8_t symmetry) {
+	uint8_t my_squares[PIECES_PER_PLAYER], their_squares[PIECES_PER_PLAYER];
+	uint8_t my_moved[PIECES_PER_PLAYER], their_moved[PIECES_PER_PLAYER];
+	piece_squares(mine, my_squares);
+	piece_squares(theirs, their_squares);
+	transform_squares(my_squares, symmetry, my_moved);
+	transform_squares(their_squares, symmetry, their_moved);
+	return mine_number(my_moved) * theirs_sets() + theirs_number(my_moved, their_moved);
+}
+
+static uint32_t key_of(const uint8_t* my_squares, const uint8_t* their_squares) {
+	uint8_t my_moved[PIECES_PER_PLAYER], their_moved[PIECES_PER_PLAYER];
+	uint32_t best_mine = UINT32_MAX, best_theirs = 0;
+	for(uint8_t symmetry = 0; symmetry < ENDGAME_SYMMETRIES; symmetry++) {
+		transform_squares(my_squares, symmetry, my_moved);
+		uint32_t number = mine_number(my_moved);
+		if(number > best_mine) {
+			// the other player's squares can't make up for it
+			continue;
+		}
+		transform_squares(their_squares, symmetry, their_moved);
+		uint32_t their_number = theirs_number(my_moved, their_moved);
+		if(number < best_mine || their_number < best_theirs) {
+			best_mine = number;
+			best_theirs = their_number;
+		}
+	}
+	return best_mine * theirs_sets() + best_theirs;
+}
+
+uint32_t endgame_key(Bitboard mine, Bitboard theirs) {
+	uint8_t my_squares[PIECES_PER_PLAYER], their_squares[PIECES_PER_PLAYER];
+	piece_squares(mine, my_squares);
+	piece_squares(theirs, their_squares);
+	return key_of(my_squares, their_squares);
+}
+
+uint8_t endgame_probe(const Position* position) {
+#if ENTRIES
+	if(teeko_placing(position)) {
+		return 0;
+	}
+	uint8_t me = position->to_move;
+	uint8_t my_squares[PIECES_PER_PLAYER], their_squares[PIECES_PER_PLAYER];
+	piece_squares(position->pieces[me - 1], my_squares);
+	piece_squares(position->pieces[2 - me], their_squares);
+	// most positions are ruled out by the filter, without the work of
+	// finding the key
+	uint16_t bit = signature(my_squares, their_squares) % ENDGAME_FILTER_BITS;
+	if(!(pgm_read_byte(&endgame_filter[bit / 8]) & (1 << (bit % 8)))) {
+		return 0;
+	}
+	uint32_t key = key_of(my_squares, their_squares);
+	uint16_t low = 0, high = ENTRIES;
+	while(low < high) {
+		uint16_t middle = (low + high) / 2;
+		uint32_t entry = pgm_read_dword(&endgame_entries[middle]);
+		uint32_t entry_key = entry / ENDGAME_PLY_LIMIT;
+		if(entry_key == key) {
+			return entry % ENDGAME_PLY_LIMIT;
+		}
+		if(entry_key < key) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+#else
+	(void)position;
+#endif
+	return 0;
+}
+
+uint16_t endgame_size(void) {
+	return ENTRIES;
+}
@@ -0,0 +1,55 @@
+/*
+ * endgame.h
+ *
+ * Exact results for some phase 2 positions (every piece on the board),
+ * looked up in a table in flash. The table holds positions which the
+ * player to move loses with best play within a few plies, and only one
+ * of each set of positions which are the same but for a rotation or
+ * reflection of the board. (A position is won in n plies if a move goes
+ * to one lost in n - 1, so wins needn't take up room as well.) It is made
+ * by host/gen_endgame.c, which fills the flash given to it with the
+ * positions furthest from the end, and written to endgame_table.h.
+ *
+ * The table is sorted by key (endgame_key()) and searched by bisection.
+ * Each entry is the key times ENDGAME_PLY_LIMIT plus the number of plies
+ * to the end of the game, in 32 bits, so there is no table for boards of
+ * more than 2^32 / ENDGAME_PLY_LIMIT positions (6x6 and larger). In
+ * front of it is a filter, a bit for each value of a hash of the
+ * positions' signatures (endgame_signature()) set if a position in the
+ * table has it, so that most positions aren't looked for at all.
+ */
+
+#ifndef ENDGAME_H_
+#define ENDGAME_H_
+
+#include <stdint.h>
+#include "teeko.h"
+
+// entries hold plies to the end below this
+#define ENDGAME_PLY_LIMIT 32
+
+// 8 symmetries of a square board (reflections in x, y and the diagonal),
+// 4 of any other
+#define ENDGAME_SYMMETRIES (WIDTH == HEIGHT ? 8 : 4)
+
+// A phase 2 position as the player to move sees it, numbered from 0 by
+// the squares of their pieces and then the squares of the other player's
+// among those left, transformed by a symmetry (0 leaves it as it is)
+uint32_t endgame_index(Bitboard mine, Bitboard theirs, uint8_t symmetry);
+
+// the smallest index of the position under any symmetry
+uint32_t endgame_key(Bitboard mine, Bitboard theirs);
+
+// A hash of the squares of the pieces which is the same under every
+// symmetry, and much quicker to find than the key
+uint16_t endgame_signature(Bitboard mine, Bitboard theirs);
+
+// Returns the number of plies to the end of the game with best play from
+// a position in the table, which the player to move loses, or 0 if the
+// position isn't in the table.
+uint8_t endgame_probe(const Position* position);
+
+// entries in the table
+uint16_t endgame_size(void);
+
+#endif /* ENDGAME_H_ */
@@ -0,0 +1,239 @@
+/*
+ * endgame_table.h
+ *
+ * The endgame table (see endgame.h), kept in flash. Included once, by
+ * endgame.c. Written by build/gen_endgame --plies 8 --bytes 4096:
+ *
+ *   lost in 2 plies: 0 of 112562
+ *   lost in 4 plies: 0 of 134959
+ *   lost in 6 plies: 0 of 93862
+ *   lost in 8 plies: 768 of 87724
+ *
+ * 732 of the 8192 bits of the filter are set.
+ */
+
+#define ENDGAME_TABLE_WIDTH 5
+#define ENDGAME_TABLE_HEIGHT 5
+#define ENDGAME_TABLE_SQUARE_WINS 0
+#define ENDGAME_TABLE_ENTRIES 768
+#define ENDGAME_FILTER_BITS 8192
+
+const uint8_t endgame_filter[ENDGAME_FILTER_BITS / 8] PROGMEM = {
+	0x00, 0x80, 0x01, 0x00, 0x00, 0x10, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00,
+	0xe0, 0x00, 0x00, 0x08, 0x00, 0x28, 0x02, 0x00, 0x00, 0x2c, 0x30, 0x90,
+	0x00, 0x80, 0x00, 0x98, 0x01, 0x02, 0x00, 0x00, 0x00, 0x40, 0x40, 0x01,
+	0x40, 0x02, 0x01, 0x00, 0x00, 0x00, 0x90, 0x14, 0x00, 0x00, 0x00, 0x00,
+	0x40, 0x14, 0x10, 0x80, 0x08, 0x12, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x82, 0x10, 0x00, 0x00, 0x08, 0x10, 0x40, 0x80, 0x10, 0x00,
+	0x02, 0x00, 0x08, 0x00, 0x00, 0x01, 0x00, 0x01, 0x30, 0x80, 0x21, 0x84,
+	0x02, 0x08, 0x01, 0x00, 0x08, 0x40, 0x00, 0x02, 0x00, 0x00, 0x00, 0x24,
+	0x21, 0x00, 0x00, 0x00, 0x28, 0x01, 0x41, 0x00, 0x00, 0x00, 0x02, 0xa8,
+	0x20, 0x00, 0x00, 0x04, 0x20, 0x00, 0x00, 0x40, 0x00, 0x00, 0x80, 0x20,
+	0x80, 0x00, 0x40, 0x88, 0x08, 0x08, 0x26, 0x40, 0x00, 0x00, 0x00, 0x04,
+	0x04, 0x10, 0x00, 0x08, 0x00, 0x08, 0x00, 0x00, 0x00, 0x02, 0x40, 0x48,
+	0x00, 0x00, 0x10, 0x08, 0x01, 0x00, 0x00, 0x00, 0x00, 0x80, 0x10, 0x00,
+	0x00, 0x02, 0x82, 0x08, 0x80, 0x04, 0x40, 0x00, 0x88, 0x81, 0x00, 0x01,
+	0x08, 0x01, 0x20, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x00,
+	0x00, 0x20, 0x20, 0x20, 0x00, 0x06, 0x00, 0x00, 0x02, 0x04, 0x04, 0x00,
+	0x04, 0x02, 0x00, 0x10, 0x80, 0x00, 0x44, 0x00, 0x40, 0x00, 0x00, 0x00,
+	0x84, 0x00, 0x01, 0x04, 0x10, 0x80, 0x20, 0x00, 0x00, 0x00, 0x04, 0x40,
+	0x00, 0x00, 0x00, 0x1a, 0x00, 0x01, 0x80, 0x20, 0x40, 0x00, 0x00, 0x00,
+	0x02, 0x00, 0x40, 0x20, 0x80, 0x00, 0xa0, 0x00, 0x22, 0x10, 0x00, 0x00,
+	0x10, 0x19, 0x00, 0x02, 0x00, 0x04, 0x80, 0x80, 0x68, 0x00, 0x20, 0x00,
+	0x00, 0x20, 0x00, 0x09, 0x02, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x02, 0x00, 0x48, 0x04, 0x02, 0x10, 0x04, 0xa1, 0x20, 0x81, 0x00,
+	0x40, 0x00, 0x70, 0xc0, 0x40, 0x42, 0x00, 0x00, 0x14, 0x00, 0x20, 0x00,
+	0x00, 0x00, 0x30, 0x00, 0x00, 0x60, 0x08, 0x00, 0xc0, 0x00, 0x00, 0x00,
+	0x00, 0x08, 0x30, 0x01, 0x00, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80,
+	0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x00, 0x02, 0x02, 0x00, 0x24,
+	0x00, 0x00, 0x02, 0x01, 0x10, 0x02, 0x00, 0x22, 0x00, 0xc0, 0x00, 0x20,
+	0x51, 0x00, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x08, 0x00, 0x30,
+	0x00, 0x81, 0x00, 0x01, 0x02, 0x00, 0x00, 0x04, 0x84, 0x00, 0x04, 0x80,
+	0x00, 0x58, 0x92, 0x00, 0x04, 0x80, 0x00, 0x00, 0x04, 0x00, 0x04, 0x20,
+	0x42, 0x00, 0x00, 0x20, 0x00, 0x80, 0x00, 0x10, 0x20, 0x00, 0x00, 0x05,
+	0x04, 0x00, 0x00, 0x00, 0x20, 0x40, 0x2c, 0x02, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x10, 0x00, 0x01, 0x00, 0x80, 0x01, 0x01, 0x40, 0x00, 0x00, 0x00,
+	0x20, 0x80, 0x00, 0x02, 0x01, 0x08, 0x81, 0x02, 0x45, 0x80, 0x30, 0x00,
+	0x20, 0x01, 0x00, 0x00, 0x22, 0x04, 0x00, 0x0a, 0x20, 0x06, 0x60, 0x08,
+	0x04, 0x01, 0x00, 0x08, 0x00, 0x02, 0x04, 0x08, 0x04, 0x00, 0x40, 0x04,
+	0xc0, 0x00, 0x00, 0x00, 0x10, 0x10, 0x00, 0x00, 0x41, 0x00, 0x00, 0x00,
+	0x10, 0x00, 0x00, 0x31, 0x20, 0x04, 0x00, 0x80, 0x10, 0x01, 0x00, 0x80,
+	0x82, 0x88, 0x98, 0x08, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x0c, 0x00,
+	0x00, 0x80, 0x01, 0x00, 0x00, 0x04, 0x02, 0x20, 0x00, 0x40, 0x04, 0x07,
+	0x03, 0x00, 0x01, 0x00, 0x00, 0x04, 0x00, 0x02, 0x40, 0x00, 0x00, 0x00,
+	0x40, 0x02, 0x00, 0x02, 0x02, 0x04, 0x08, 0x10, 0x00, 0x01, 0x02, 0x40,
+	0x5c, 0x20, 0x08, 0x08, 0x08, 0x00, 0x00, 0x08, 0x04, 0x00, 0x00, 0x20,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x41, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x08,
+	0x00, 0x08, 0x00, 0x08, 0x00, 0x00, 0x00, 0x02, 0x05, 0x10, 0x00, 0x00,
+	0x10, 0x00, 0x00, 0x18, 0x04, 0x08, 0x40, 0x01, 0x00, 0x20, 0x00, 0x90,
+	0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x01, 0x00, 0x02, 0x40, 0x00, 0x00,
+	0x00, 0xa0, 0x20, 0x00, 0x40, 0x00, 0x00, 0x00, 0x08, 0x01, 0x00, 0x00,
+	0x00, 0x00, 0x08, 0x60, 0x08, 0x00, 0x00, 0x00, 0x01, 0x80, 0x80, 0x01,
+	0x00, 0x04, 0x42, 0x04, 0x08, 0x00, 0x00, 0x08, 0x00, 0x05, 0x00, 0x00,
+	0x20, 0x02, 0x80, 0x02, 0x04, 0x00, 0x00, 0x00, 0x04, 0x00, 0x20, 0x00,
+	0x08, 0x30, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0x80, 0x00, 0x02,
+	0x00, 0x80, 0x80, 0x01, 0x00, 0x20, 0x08, 0x48, 0x80, 0x04, 0x01, 0x40,
+	0x0d, 0x04, 0x00, 0x10, 0x01, 0x44, 0x00, 0x40, 0xa0, 0x00, 0x05, 0x00,
+	0x00, 0x00, 0x00, 0x84, 0x00, 0x00, 0x04, 0x02, 0x02, 0x60, 0x00, 0x04,
+	0x01, 0x08, 0x09, 0x00, 0x00, 0x00, 0x08, 0x00, 0x82, 0xa8, 0x00, 0x00,
+	0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x48, 0x01, 0x00, 0x01,
+	0x40, 0x00, 0x02, 0x00, 0x00, 0x40, 0x00, 0x08, 0x0a, 0x00, 0x00, 0x49,
+	0x20, 0x00, 0x00, 0x28, 0x00, 0x06, 0xa0, 0x40, 0x00, 0x03, 0x18, 0x10,
+	0x00, 0x00, 0x40, 0x00, 0x19, 0xc0, 0x00, 0x00, 0x04, 0x25, 0x08, 0x04,
+	0x00, 0x40, 0x1a, 0x40, 0x02, 0x00, 0x80, 0x00, 0x01, 0x00, 0x00, 0xa0,
+	0x28, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x11,
+	0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x30, 0x00, 0x00, 0x04, 0x00,
+	0x40, 0x22, 0x00, 0x40, 0x01, 0x00, 0x00, 0x44, 0x21, 0x04, 0x00, 0x00,
+	0x04, 0x20, 0x10, 0x80, 0x80, 0x02, 0x02, 0x00, 0x00, 0x40, 0x00, 0x00,
+	0x40, 0x10, 0x00, 0x80, 0x41, 0x48, 0x90, 0x00, 0x00, 0x00, 0x00, 0x84,
+	0x00, 0x20, 0x00, 0x10, 0x40, 0x00, 0x01, 0x40, 0x04, 0x00, 0x01, 0x00,
+	0x0d, 0x00, 0x08, 0x00, 0x00, 0x00, 0xc0, 0x00, 0x00, 0x04, 0x00, 0x40,
+	0x00, 0x00, 0x0c, 0x00, 0x00, 0x28, 0x20, 0x8c, 0x00, 0x50, 0x00, 0x08,
+	0x00, 0x80, 0x04, 0x00, 0x00, 0x01, 0x18, 0x00, 0x84, 0x00, 0x80, 0x00,
+	0x02, 0x00, 0x00, 0x00, 0x10, 0x02, 0x00, 0x80, 0x08, 0x44, 0x40, 0x00,
+	0x20, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x01, 0x44,
+	0x00, 0x40, 0x00, 0x00, 0x02, 0x00, 0x20, 0x20, 0x0a, 0x40, 0x00, 0x00,
+	0x00, 0x04, 0x01, 0x90, 0x20, 0x08, 0x00, 0x00, 0x01, 0x02, 0x20, 0x00,
+	0x01, 0x01, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x4a, 0x04, 0x00, 0x00,
+	0x00, 0x12, 0x00, 0x20, 0x00, 0x00, 0x21, 0x81, 0x00, 0x00, 0x00, 0x31,
+	0x00, 0xa3, 0x30, 0x00, 0x20, 0x10, 0x00, 0x1c, 0x10, 0x00, 0x08, 0x00,
+	0x80, 0x00, 0x00, 0x20, 0x21, 0x20, 0x00, 0x05, 0x22, 0x20, 0x10, 0x00,
+	0x11, 0x10, 0x00, 0x00, 0x80, 0x20, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00,
+	0x00, 0x80, 0x25, 0x01, 0x12, 0x02, 0x10, 0x00, 0x00, 0x00, 0x00, 0x50,
+	0x08, 0x00, 0x00, 0x10, 0x22, 0x08, 0x01, 0x00, 0x81, 0x00, 0x00, 0x00,
+	0x08, 0x00, 0x00, 0x00, 0x10, 0x04, 0x00, 0x10, 0x00, 0x90, 0x00, 0x20,
+	0x10, 0x05, 0x82, 0x00, 0x00, 0x50, 0xc2, 0x80, 0x40, 0x80, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x10, 0x00, 0x40, 0x00, 0x00,
+	0x80, 0x00, 0x00, 0x20
+};
+
+const uint32_t endgame_entries[ENDGAME_TABLE_ENTRIES] PROGMEM = {
+	0x000f1508, 0x001008c8, 0x001a6d68, 0x001b2a88, 0x001ce7c8, 0x00237528,
+	0x002494c8, 0x002982a8, 0x003bf5e8, 0x00499b48, 0x004a79e8, 0x004c5e08,
+	0x004d7788, 0x004edfa8, 0x005aa728, 0x005bed28, 0x005d1908, 0x0061a268,
+	0x0083be28, 0x00849be8, 0x0085a828, 0x00953328, 0x00a267c8, 0x00bec908,
+	0x00c088e8, 0x00c5f5a8, 0x00ee0808, 0x00fc9fc8, 0x00fdf468, 0x00ffff88,
+	0x0118dce8, 0x015385c8, 0x018dfce8, 0x018f29c8, 0x01927088, 0x01975128,
+	0x01990348, 0x019f5a08, 0x01a05a08, 0x01c7fd68, 0x01c970e8, 0x01cb5828,
+	0x01d41f68, 0x01d5bc08, 0x02664948, 0x0267dca8, 0x02717c48, 0x02727bc8,
+	0x02733808, 0x0274a448, 0x0275f888, 0x0277efc8, 0x027a3d88, 0x027b7788,
+	0x027cf508, 0x02812dc8, 0x02898d08, 0x028c64a8, 0x028db2e8, 0x028f58e8,
+	0x02918388, 0x02936788, 0x0294ce88, 0x02957668, 0x02960448, 0x02969c48,
+	0x02975f28, 0x02987c08, 0x02996988, 0x029adbc8, 0x029c8ec8, 0x029ea628,
+	0x02a3e168, 0x02a6d488, 0x02a8e5a8, 0x02ab7a28, 0x02ae6648, 0x02b164c8,
+	0x02b2e528, 0x02b3bdc8, 0x02b49628, 0x02b6f408, 0x02b9a4e8, 0x02bc9108,
+	0x02c83d48, 0x02ca6ea8, 0x02cbf948, 0x02cdace8, 0x02cf49a8, 0x02d177a8,
+	0x02d3e468, 0x02d6d328, 0x02da35c8, 0x02dd2488, 0x02df9ee8, 0x02e30448,
+	0x02e66c08, 0x02e8dc88, 0x02ec6b88, 0x02ee5748, 0x02f84928, 0x02fb59a8,
+	0x0307cf28, 0x0309fa08, 0x030bfc68, 0x030e56c8, 0x0310f268, 0x031425c8,
+	0x03179e08, 0x031a3f88, 0x031c6f68, 0x031eaf08, 0x032163c8, 0x032409a8,
+	0x032599c8, 0x03276548, 0x032c9148, 0x0334c028, 0x0338edc8, 0x03503128,
+	0x035c4728, 0x035d4848, 0x035efc28, 0x036062a8, 0x03629488, 0x03647708,
+	0x0365b088, 0x036786c8, 0x036903e8, 0x036afd28, 0x036c53e8, 0x036d6c08,
+	0x036e5e08, 0x036fb088, 0x03715888, 0x03733768, 0x0374e2a8, 0x03762148,
+	0x037725a8, 0x03786308, 0x03798068, 0x037aa3a8, 0x037d0268, 0x037f9fa8,
+	0x03827748, 0x038479a8, 0x03858268, 0x0386b9e8, 0x0388da68, 0x038c3868,
+	0x039168e8, 0x0394fca8, 0x039824c8, 0x039d8948, 0x03ae8908, 0x03b42508,
+	0x03b8f828, 0x03babbc8, 0x03bdc748, 0x03d12108, 0x03d22528, 0x03d38f28,
+	0x03d4f588, 0x03d7dd08, 0x03daa988, 0x03dec008, 0x03ebca88, 0x03ed3108,
+	0x03ef7388, 0x03f26188, 0x03f405a8, 0x03f53ea8, 0x03f6ce28, 0x03f83668,
+	0x03fa6768, 0x03fbe548, 0x03fe3648, 0x040a5968, 0x040f61e8, 0x04124a88,
+	0x04155c28, 0x0419eda8, 0x04288fe8, 0x042eec68, 0x043656c8, 0x043e4428,
+	0x0446ad28, 0x045c4c08, 0x046bd248, 0x0470a1c8, 0x04764388, 0x047b0f28,
+	0x047fb5e8, 0x0483b5c8, 0x04930388, 0x04bb3c28, 0x04be0fe8, 0x04c080c8,
+	0x04c3f6c8, 0x04c6cb88, 0x04c8f4e8, 0x04cbc688, 0x04ce3888, 0x04d124c8,
+	0x04d363c8, 0x04d4fc48, 0x04d63aa8, 0x04d88248, 0x04dc0928, 0x04e14528,
+	0x04e4ec88, 0x04eaaf88, 0x04fd06e8, 0x05189fa8, 0x052d41e8, 0x05327f68,
+	0x053604e8, 0x053747c8, 0x053a68c8, 0x053dc568, 0x0549ea48, 0x054cb1a8,
+	0x054e48c8, 0x055d7708, 0x058c6ce8, 0x05985808, 0x05a79dc8, 0x05b3f028,
+	0x05b5d708, 0x05c4ace8, 0x05c8eb68, 0x05cbedc8, 0x05cedf48, 0x05d24dc8,
+	0x05d66f88, 0x05d95bc8, 0x05dc8848, 0x05e033a8, 0x05e39f88, 0x05e92c68,
+	0x05ef9c48, 0x05f61648, 0x05fd8908, 0x060fb748, 0x062b6fa8, 0x06baa788,
+	0x0708a528, 0x070e02e8, 0x0713c388, 0x07199da8, 0x0720b748, 0x072fdc08,
+	0x073f97a8, 0x076f9ec8, 0x079d0ca8, 0x07f358e8, 0x098a7488, 0x098fc8c8,
+	0x09953d88, 0x0999b2c8, 0x099ea548, 0x09a31c08, 0x09a5e228, 0x09a95648,
+	0x09affd08, 0x09b84528, 0x09c76b88, 0x09e756c8, 0x09faae68, 0x09fed268,
+	0x0a109108, 0x0a1f1748, 0x0a36a508, 0x0a9e1e88, 0x0ccd2188, 0x0cce5188,
+	0x0cd0f188, 0x0cd36c28, 0x0cd55a28, 0x0cd75108, 0x0cde7d08, 0x0ce980a8,
+	0x0ceabea8, 0x0cecf4c8, 0x0ceea888, 0x0cf1c788, 0x0cf54e08, 0x0cf735a8,
+	0x0cfbf7e8, 0x0d026f88, 0x0d087108, 0x0d1884c8, 0x0dd50a48, 0x0de343c8,
+	0x0f9877a8, 0x0f99ff08, 0x0f9b7208, 0x0f9ce2c8, 0x0f9f37c8, 0x0fa12068,
+	0x0fa1af28, 0x0fa27948, 0x0fa30be8, 0x0fa3fb08, 0x0fa4e828, 0x0fa5f1c8,
+	0x0fa75988, 0x0fa914c8, 0x0faa2de8, 0x0fab55c8, 0x0facb428, 0x0faeb188,
+	0x0fafc988, 0x0fb0e548, 0x0fb1d9a8, 0x0fc19fe8, 0x0fc41f28, 0x0fc519e8,
+	0x0fc5e568, 0x0fc70368, 0x0fc7ef08, 0x0fc97028, 0x0fcadd88, 0x0fccf1a8,
+	0x0fce6c68, 0x0fdb7ac8, 0x0fe17928, 0x0fe30ba8, 0x0fe492e8, 0x0fe7e668,
+	0x0febfda8, 0x0ffabf68, 0x100daf68, 0x1011d288, 0x1015ed48, 0x1022dfa8,
+	0x103a8ac8, 0x103cdea8, 0x103f3fc8, 0x1042dfa8, 0x1047afe8, 0x104ad6e8,
+	0x104df088, 0x10522068, 0x1053dbc8, 0x10566148, 0x105a8a48, 0x105f4908,
+	0x1065acc8, 0x106c72e8, 0x107865a8, 0x1083b5c8, 0x108b9ba8, 0x108c9c68,
+	0x108e2bc8, 0x108fdc68, 0x109235c8, 0x109451e8, 0x10965828, 0x10987ea8,
+	0x109a6d88, 0x109c2da8, 0x109ce688, 0x109de968, 0x109fc428, 0x10a180e8,
+	0x10a37de8, 0x10a4ea68, 0x10a550e8, 0x10a61fa8, 0x10a6c1c8, 0x10a7e308,
+	0x10a973e8, 0x10ab4148, 0x10ad4668, 0x10b07b88, 0x10b3d828, 0x10b591a8,
+	0x10b84cc8, 0x10be40e8, 0x10c43f08, 0x10cc2c88, 0x10d275a8, 0x10dd1348,
+	0x10e29fe8, 0x10e58048, 0x10e6bfc8, 0x10e87308, 0x10e9df68, 0x10f0f1e8,
+	0x11055ac8, 0x1105f1c8, 0x1106e308, 0x1107a548, 0x1108b008, 0x110a3108,
+	0x110bacc8, 0x110e06c8, 0x110e9d28, 0x11100f48, 0x111d2368, 0x111e6ee8,
+	0x112b5fc8, 0x113a1068, 0x1147a268, 0x114bf1a8, 0x11518028, 0x1154ff08,
+	0x115d5e88, 0x115eea08, 0x1161dcc8, 0x116556e8, 0x11683208, 0x11694ae8,
+	0x116a89e8, 0x116c8a08, 0x11706be8, 0x118a2bc8, 0x1191c1c8, 0x11a2aea8,
+	0x11ec4368, 0x12070d28, 0x121691c8, 0x122f50c8, 0x1272dc08, 0x12d96e68,
+	0x12e0f2c8, 0x12ec74e8, 0x12f4b1e8, 0x12fa7628, 0x130a6a88, 0x133585c8,
+	0x134ba2e8, 0x134fc468, 0x135f2f28, 0x1379dc48, 0x13be18e8, 0x13c05488,
+	0x13c3dfc8, 0x13c71408, 0x13ca8208, 0x13cd24c8, 0x13cfaa28, 0x13d1df08,
+	0x13d5d028, 0x13d7ab68, 0x13d8cd88, 0x13da35a8, 0x13dc27c8, 0x13e04fa8,
+	0x13e61da8, 0x13ea5de8, 0x13f8e528, 0x140a9fe8, 0x14183d08, 0x141b27e8,
+	0x142741c8, 0x142d20a8, 0x142f54e8, 0x1430af28, 0x1431e568, 0x1432eee8,
+	0x1433fb48, 0x143c4e08, 0x14408388, 0x14424568, 0x1446e0a8, 0x144c7028,
+	0x144f4e08, 0x145db928, 0x14a9f588, 0x14d2d1a8, 0x14d48328, 0x14d5f988,
+	0x14d832e8, 0x14db9608, 0x14ddb548, 0x14e0e8e8, 0x14e2a788, 0x14f60288,
+	0x14f7ab48, 0x14fa0968, 0x14fca028, 0x150086e8, 0x15157ec8, 0x151c1ac8,
+	0x15427e68, 0x156db408, 0x15796488, 0x158545c8, 0x15ac76c8, 0x15c163e8,
+	0x15c84be8, 0x15cd5268, 0x15d11068, 0x15d5a4a8, 0x15d77f08, 0x15df14c8,
+	0x15ebabe8, 0x16027968, 0x16141748, 0x163750c8, 0x16389ee8, 0x163a6028,
+	0x163e5088, 0x16423768, 0x164fff08, 0x165e9848, 0x1690f408, 0x169c1f08,
+	0x16bb3d68, 0x16c55128, 0x17240bc8, 0x180cc7a8, 0x18471b68, 0x18f2bbc8,
+	0x190c52a8, 0x194720e8, 0x1990de28, 0x1a0bf848, 0x1a106048, 0x1a1369a8,
+	0x1a221ac8, 0x1a533308, 0x1a6910c8, 0x1a6d9b48, 0x1a751b68, 0x1a885ba8,
+	0x1aa53968, 0x1b02d6a8, 0x1b0edf28, 0x1b394288, 0x1b5c7048, 0x1b642228,
+	0x1bbcc308, 0x1c9de368, 0x1cb54468, 0x1d2143e8, 0x2076c3e8, 0x20d1d0e8,
+	0x21729088, 0x22cef168, 0x28922cc8, 0x28cc8a88, 0x2a9185a8, 0x31715968,
+	0x31729f48, 0x317731e8, 0x317baf28, 0x318e1728, 0x318f08a8, 0x31918188,
+	0x3194b288, 0x319bfc08, 0x31ab0928, 0x31f4ed68, 0x31f75748, 0x31fb7cc8,
+	0x321419e8, 0x33d7e2e8, 0x33e498e8, 0x375ae7c8, 0x375b2f88, 0x375b79a8,
+	0x375bdbc8, 0x375c32c8, 0x375c96a8, 0x375ce728, 0x375d8128, 0x375e0d48,
+	0x375e66a8, 0x375f0068, 0x375f7328, 0x37605268, 0x37610008, 0x3761a748,
+	0x37627228, 0x37638b28, 0x3763f728, 0x376441e8, 0x3764d9c8, 0x37654768,
+	0x37661148, 0x3766d0a8, 0x376788e8, 0x376850a8, 0x37695f48, 0x3769ea08,
+	0x376a9c88, 0x376b4ac8, 0x3780c468, 0x3781a588, 0x3783c048, 0x37849c88,
+	0x378614a8, 0x37872408, 0x378823c8, 0x379b41e8, 0x379c6d28, 0x379eb548,
+	0x37a09988, 0x37a2c1a8, 0x37a4ba08, 0x37c77788, 0x37c96868, 0x37cc7fc8,
+	0x37cf0de8, 0x37d096c8, 0x37d23848, 0x380431a8, 0x3805b968, 0x3807c248,
+	0x380a46a8, 0x380bd208, 0x380d41e8, 0x380dde68, 0x380e9908, 0x381c2128,
+	0x382beb28, 0x384477c8, 0x384532c8, 0x38461aa8, 0x3846f5e8, 0x38483708,
+	0x38493648, 0x384acba8, 0x384bfba8, 0x384d6968, 0x384e9628, 0x385001c8,
+	0x38516268, 0x385293e8, 0x38539188, 0x38544988, 0x3854d4e8, 0x3855b548,
+	0x38567348, 0x38571488, 0x3857bc68, 0x3858cbe8, 0x3859ac08, 0x385ade28,
+	0x385c0708, 0x385cfa08, 0x385dd108, 0x385ec2c8, 0x385f18e8, 0x385f7448,
+	0x38608e68, 0x386223c8, 0x3862b6a8, 0x38635ea8, 0x386422c8, 0x3865f3e8,
+	0x3866eba8, 0x386938c8, 0x386c15c8, 0x386dce08, 0x386eac28, 0x386f6628,
+	0x38719748, 0x38742c48, 0x38781f48, 0x387c5b88, 0x38828628, 0x3887f788,
+	0x388b46e8, 0x388ddba8, 0x388f9908, 0x389880c8, 0x389c5f68, 0x389dde68,
+	0x389f5168, 0x38a012a8, 0x38c5a328, 0x38c84b68, 0x38c930e8, 0x38ca58c8,
+	0x390b3528, 0x390dae08, 0x39177f68, 0x391862c8, 0x3918fc28, 0x391b36a8,
+	0x391d2d88, 0x391fa5e8, 0x39217308, 0x3922f0e8, 0x39237628, 0x39243ce8,
+	0x394bd468, 0x398f64c8, 0x39a61048, 0x39e7a788, 0x3a3faa28, 0x3aaaad08,
+	0x3b025588, 0x3b773e68, 0x3b785aa8, 0x3b7a9a88, 0x3b7d2e08, 0x3b7f10c8,
+	0x3b812e48, 0x3b83b4e8, 0x3b85d728, 0x3b870c68, 0x3b88b148, 0x3b89b828,
+	0x3b8b64c8, 0x3b8d23c8, 0x3b8f3e48, 0x3b948c68, 0x3b958168, 0x3b977988,
+	0x3b9a59c8, 0x3b9ef028, 0x3ba15a88, 0x3ba4e2a8, 0x3bb4f428, 0x3bcbeea8,
+	0x3be05948, 0x3be19e88, 0x3be42648, 0x3bfacfe8, 0x3bfee088, 0x3c03efe8,
+	0x3c068ea8, 0x3c9afb88, 0x3c9be008, 0x3c9d8588, 0x3cdf3168, 0x3cea13a8,
+	0x3cea9a28, 0x3ceb6e88, 0x3cec48a8, 0x3cee5a28, 0x3cf023a8, 0x3cf22ca8,
+	0x3cf35ce8, 0x3cf4a768, 0x3cf59ee8, 0x3cf60648, 0x3cf6f068, 0x3d8fb408,
+	0x3d939308, 0x3d94fc28, 0x3e1d2c08, 0x3e24ac28, 0x41acd788, 0x425f8448,
+	0x4260c828, 0x4263a328, 0x42679948, 0x426b6d68, 0x4270e148, 0x4271bc68,
+	0x427422c8, 0x4280bf68, 0x42883748, 0x42c810c8, 0x42e59d48, 0x42eb7268,
+	0x43958888, 0x43995308, 0x439cb4a8, 0x462320a8, 0x49017e48, 0x8662d2e8
+};
@@ -0,0 +1,347 @@
+/*
+ * engine.c
+ *
+ * Computer player (see engine.h)
+ *
+ * The search is negamax with alpha-beta pruning, written with an explicit
+ * stack of frames (one per ply) instead of recursion so that it can stop
+ * after any number of nodes and carry on later from exactly where it was.
+ * Below the root, moves are generated one at a time by an iterator in the
+ * frame, so a frame is only a few bytes.
+ */
+
+#include <string.h>
+#include "engine.h"
+#include "engine_weights.h"
+#include "endgame.h"
+
+// the 3x3 squares in the middle of the board
+#define CENTRE (teeko_neighbours(SQUARE_BIT(NUM_SQUARES / 2)) | \
+		SQUARE_BIT(NUM_SQUARES / 2))
+
+// how often (in nodes) the clock is checked
+#define CLOCK_INTERVAL 256
+
+// The endgame table only holds a sample of the positions of each class,
+// so nearly every probe misses. It is looked up at the leaves of the
+// first plies, where a hit settles a root move, and not below them.
+#define TABLE_PLIES 2
+
+// task states
+#define TASK_SEARCHING 0
+#define TASK_FINISHED 1
+
+int16_t engine_evaluate(const Position* position, const EvalWeights* weights) {
+	uint8_t me = position->to_move;
+	Bitboard mine = position->pieces[me - 1];
+	Bitboard theirs = position->pieces[2 - me];
+	Bitboard empty = ALL_SQUARES & ~(mine | theirs);
+	int16_t score = 0;
+
+	for(uint8_t m = 0; m < POS_WINS; m++) {
+		uint8_t my_count = LINE_COUNT(position, m, me);
+		uint8_t their_count = LINE_COUNT(position, m, 3 - me);
+		if(their_count == 0) {
+			score += weights->line[my_count];
+		}
+		if(my_count == 0) {
+			score -= weights->line[their_count];
+		}
+	}
+
+	score += weights->centre * ((int8_t)teeko_count(mine & CENTRE) -
+			(int8_t)teeko_count(theirs & CENTRE));
+	score += weights->mobility * ((int8_t)teeko_count(teeko_neighbours(mine) & empty) -
+			(int8_t)teeko_count(teeko_neighbours(theirs) & empty));
+	return score;
+}
+
+static uint8_t out_of_time(SearchTask* task) {
+	const SearchLimits* limits = &task->limits;
+	if(limits->max_nodes && task->nodes >= limits->max_nodes) {
+		return 1;
+	}
+	if(limits->max_time && limits->clock && task->nodes >= task->next_clock_check) {
+		task->next_clock_check = task->nodes + CLOCK_INTERVAL;
+		if(limits->clock() - task->start_time >= limits->max_time) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// Returns the next move from a frame below the root, in the same order
+// as teeko_generate_moves(), or MOVE_NONE when there are no more.
+static Move next_move(const Position* position, SearchFrame* frame) {
+	Bitboard empty = ALL_SQUARES & ~(position->pieces[0] | position->pieces[1]);
+
+	if(teeko_placing(position)) {
+		for(; frame->square < NUM_SQUARES; frame->square++) {
+			if(empty & SQUARE_BIT(frame->square)) {
+				return MAKE_MOVE(MOVE_PLACE, frame->square++);
+			}
+		}
+		return MOVE_NONE;
+	}
+
+	Bitboard mine = position->pieces[position->to_move - 1];
+	while(!frame->targets) {
+		// on to the next piece
+		if(++frame->square >= NUM_SQUARES) {
+			return MOVE_NONE;
+		}
+		if(mine & SQUARE_BIT(frame->square)) {
+			frame->targets = pgm_read_bitboard(&neighbour_masks[frame->square]) & empty;
+		}
+	}
+	uint8_t to = 0;
+	while(!(frame->targets & SQUARE_BIT(to))) {
+		to++;
+	}
+	frame->targets &= ~SQUARE_BIT(to);
+	return MAKE_MOVE(frame->square, to);
+}
+
+// set up a frame to search the position below the root
+static void enter_frame(SearchTask* task, SearchFrame* frame, uint8_t depth,
+		int16_t alpha, int16_t beta) {
+	frame->depth = depth;
+	frame->alpha = alpha;
+	frame->beta = beta;
+	frame->best = -ENGINE_WIN;
+	frame->best_move = MOVE_NONE;
+	// next_move() starts placing from square 0, or moves on to the piece
+	// on square 0 first
+	frame->square = teeko_placing(&task->position) ? 0 : 0xFF;
+	frame->targets = 0;
+}
+
+// start an iteration of the given depth from the root
+static void start_iteration(SearchTask* task, uint8_t depth) {
+	task->depth = depth;
+	task->frames[0].depth = depth;
+	task->root_index = 0;
+	task->best_index = 0;
+	task->root_alpha = -ENGINE_WIN - 1;
+	task->ply = 0;
+	task->returning = 0;
+}
+
+// the root moves have all been searched to the current depth
+static void finish_iteration(SearchTask* task) {
+	SearchResult* result = &task->result;
+	uint8_t best_index = task->best_index;
+
+	// search the best move first next time
+	Move best = task->root_moves[best_index];
+	task->root_moves[best_index] = task->root_moves[0];
+	task->root_moves[0] = best;
+	result->move = best;
+	result->reply = task->best_reply;
+	result->score = task->root_alpha;
+	result->depth = task->depth;
+
+	// no point looking further once a forced result is found
+	if(task->root_alpha >= ENGINE_WIN - ENGINE_MAX_DEPTH ||
+			task->root_alpha <= -ENGINE_WIN + ENGINE_MAX_DEPTH ||
+			task->depth >= task->max_depth || out_of_time(task)) {
+		task->state = TASK_FINISHED;
+		return;
+	}
+	start_iteration(task, task->depth + 1);
+}
+
+// take the score of the move just searched from the frame at task->ply,
+// and the best reply to it if known. Returns 1 on a beta cutoff.
+static uint8_t score_move(SearchTask* task, int16_t score, Move reply) {
+	if(task->ply == 0) {
+		if(score > task->root_alpha) {
+			task->root_alpha = score;
+			task->best_index = task->root_index - 1;
+			task->best_reply = reply;
+		}
+		return 0;
+	}
+
+	SearchFrame* frame = &task->frames[task->ply];
+	if(score > frame->best) {
+		frame->best = score;
+		frame->best_move = frame->move;
+		if(score > frame->alpha) {
+			frame->alpha = score;
+			if(frame->alpha >= frame->beta) {
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+// leave the frame at task->ply, passing its score up to its parent
+static void leave_frame(SearchTask* task) {
+	if(task->ply == 0) {
+		finish_iteration(task);
+		return;
+	}
+	SearchFrame* frame = &task->frames[task->ply];
+	// no moves at all means we're blocked in, call it a draw
+	task->value = (frame->best == -ENGINE_WIN) ? 0 : frame->best;
+	task->ply--;
+	task->returning = 1;
+}
+
+// the score of a position at the bottom of the search, ply plies from
+// the root: exact if it is in the endgame table (within TABLE_PLIES of
+// the root), else the evaluation
+static int16_t leaf_score(SearchTask* task, uint8_t ply) {
+	uint8_t plies = (ply <= TABLE_PLIES) ? endgame_probe(&task->position) : 0;
+	if(plies) {
+		return -(ENGINE_WIN - ply - plies);
+	}
+	return engine_evaluate(&task->position, &task->weights);
+}
+
+// If a root move goes to a position the endgame table has as lost, the
+// one which wins soonest is the result without a search. Returns 1 if
+// there is one (and no move wins at once, which the search finds anyway).
+static uint8_t table_move(SearchTask* task) {
+	Position* position = &task->position;
+	uint8_t best = 0;
+	for(uint8_t i = 0; i < task->root_count; i++) {
+		Move move = task->root_moves[i];
+		teeko_make(position, move);
+		uint8_t won = teeko_move_won(position, move);
+		uint8_t plies = won ? 0 : endgame_probe(position);
+		teeko_unmake(position, move);
+		if(won) {
+			return 0;
+		}
+		if(plies && (!best || plies < best)) {
+			best = plies;
+			task->result.move = move;
+		}
+	}
+	if(!best) {
+		return 0;
+	}
+	task->result.score = ENGINE_WIN - (best + 1);
+	task->result.depth = best + 1;
+	return 1;
+}
+
+// one step of the search: make the next move from the current frame, or
+// take back the move whose score has just been found
+static void search_step(SearchTask* task) {
+	Position* position = &task->position;
+	uint8_t ply = task->ply;
+	SearchFrame* frame = &task->frames[ply];
+
+	if(task->returning) {
+		// the reply is only known if the move was searched in a frame
+		Move reply = (frame->depth > 1) ? task->frames[ply + 1].best_move : MOVE_NONE;
+		task->returning = 0;
+		teeko_unmake(position, frame->move);
+		if(score_move(task, -task->value, reply)) {
+			leave_frame(task);
+		}
+		return;
+	}
+
+	Move move;
+	if(ply == 0) {
+		move = (task->root_index < task->root_count) ?
+				task->root_moves[task->root_index++] : MOVE_NONE;
+	} else {
+		move = next_move(position, frame);
+	}
+	if(move == MOVE_NONE) {
+		leave_frame(task);
+		return;
+	}
+
+	teeko_make(position, move);
+	frame->move = move;
+	if(teeko_move_won(position, move)) {
+		// a winning move ends the search there
+		teeko_unmake(position, move);
+		if(score_move(task, ENGINE_WIN - (ply + 1), MOVE_NONE)) {
+			leave_frame(task);
+		}
+		return;
+	}
+
+	task->nodes++;
+	if(frame->depth == 1) {
+		task->value = leaf_score(task, ply + 1);
+		task->returning = 1;
+		return;
+	}
+	if(out_of_time(task)) {
+		// an unfinished iteration is no use (depth 1 always finishes as
+		// its children are evaluated without checking the limits)
+		task->state = TASK_FINISHED;
+		return;
+	}
+	int16_t alpha = (ply == 0) ? task->root_alpha : frame->alpha;
+	int16_t beta = (ply == 0) ? ENGINE_WIN + 1 : frame->beta;
+	task->ply = ply + 1;
+	enter_frame(task, &task->frames[ply + 1], frame->depth - 1, -beta, -alpha);
+}
+
+void engine_task_start(SearchTask* task, const Position* position,
+		const SearchLimits* limits) {
+	task->position = *position;
+	task->limits = *limits;
+	// the weights are copied so the defaults can stay in flash
+	if(limits->weights) {
+		task->weights = *limits->weights;
+	} else {
+		memcpy_P(&task->weights, &engine_default_weights, sizeof(EvalWeights));
+	}
+	task->nodes = 0;
+	task->next_clock_check = 0;
+	task->start_time = limits->clock ? limits->clock() : 0;
+
+	task->max_depth = limits->max_depth;
+	if(task->max_depth == 0 || task->max_depth > ENGINE_MAX_DEPTH) {
+		task->max_depth = ENGINE_MAX_DEPTH;
+	}
+
+	task->root_count = teeko_generate_moves(position, task->root_moves);
+	task->best_reply = MOVE_NONE;
+	task->result.move = task->root_count ? task->root_moves[0] : MOVE_NONE;
+	task->result.reply = MOVE_NONE;
+	task->result.score = 0;
+	task->result.depth = 0;
+	task->state = task->root_count ? TASK_SEARCHING : TASK_FINISHED;
+	if(task->root_count && table_move(task)) {
+		task->state = TASK_FINISHED;
+	}
+	start_iteration(task, 1);
+}
+
+uint8_t engine_task_run(SearchTask* task, uint16_t max_nodes) {
+	uint32_t stop = task->nodes + max_nodes;
+	while(task->state == TASK_SEARCHING) {
+		if(task->nodes >= stop) {
+			return 0;
+		}
+		search_step(task);
+	}
+	return 1;
+}
+
+void engine_task_result(const SearchTask* task, SearchResult* result) {
+	*result = task->result;
+	result->nodes = task->nodes;
+}
+
+void engine_search(const Position* position, const SearchLimits* limits,
+		SearchResult* result) {
+	SearchTask task;
+	engine_task_start(&task, position, limits);
+	while(!engine_task_run(&task, UINT16_MAX)) {
+		continue;
+	}
+	engine_task_result(&task, result);
+}
@@ -0,0 +1,105 @@
+/*
+ * engine.h
+ *
+ * Computer player: an iterative deepening alpha-beta search over the
+ * rules in teeko.h. All search state lives in a SearchTask owned by the
+ * caller, so several searches can run at once (e.g. on host threads), and
+ * a search can be run a few nodes at a time between other work and picked
+ * up again where it left off (engine_task_run()).
+ */
+
+#ifndef ENGINE_H_
+#define ENGINE_H_
+
+#include <stdint.h>
+#include "teeko.h"
+
+// deepest search in plies
+#define ENGINE_MAX_DEPTH 16
+
+// score of a win found at the root, a win n plies away scores
+// ENGINE_WIN - n
+#define ENGINE_WIN 10000
+
+// Evaluation weights, scores are from the point of view of the player
+// to move
+typedef struct {
+	int16_t line[4];	// a winning line holding 0 to 3 of one player's
+						// pieces and none of the other's
+	int16_t centre;		// each piece on the central 3x3 squares
+	int16_t mobility;	// each empty square next to a piece
+} EvalWeights;
+
+// in flash, see engine_search()
+extern const EvalWeights engine_default_weights PROGMEM;
+
+typedef struct {
+	uint8_t max_depth;		// plies, 1 to ENGINE_MAX_DEPTH
+	uint32_t max_nodes;		// 0 for no limit
+	uint32_t max_time;		// milliseconds, 0 for no limit
+	uint32_t (*clock)(void);	// current time in ms, needed for max_time
+	const EvalWeights* weights;	// in RAM, or NULL for engine_default_weights
+} SearchLimits;
+
+typedef struct {
+	Move move;			// best move, MOVE_NONE if there are no legal moves
+	Move reply;			// expected reply to it, MOVE_NONE if not known
+	int16_t score;		// score of the best move
+	uint8_t depth;		// depth of the last completed iteration
+	uint32_t nodes;		// positions searched
+} SearchResult;
+
+// one ply of the search below the root
+typedef struct {
+	Bitboard targets;	// squares the piece on square can still move to
+	uint8_t square;		// next square to place on, or piece being moved
+	uint8_t depth;		// plies left to search
+	int16_t alpha, beta, best;
+	Move move;			// the move being searched
+	Move best_move;
+} SearchFrame;
+
+// A search in progress. About 60 bytes plus 16 per ply of ENGINE_MAX_DEPTH
+// on the AVR.
+typedef struct {
+	Position position;	// moves are made and unmade on this copy
+	SearchLimits limits;
+	EvalWeights weights;
+	uint32_t nodes;
+	uint32_t next_clock_check;
+	uint32_t start_time;
+	uint8_t state;
+	uint8_t max_depth;
+	uint8_t depth;		// of the current iteration
+	uint8_t ply;		// frame being searched, 0 is the root
+	uint8_t returning;	// value holds the score of frames[ply].move
+	int16_t value;
+	Move root_moves[MAX_MOVES];	// best first
+	uint8_t root_count;
+	uint8_t root_index;	// next root move to search
+	uint8_t best_index;
+	int16_t root_alpha;
+	Move best_reply;
+	SearchResult result;	// from the last completed iteration
+	SearchFrame frames[ENGINE_MAX_DEPTH];
+} SearchTask;
+
+// static evaluation of a position for the player to move
+int16_t engine_evaluate(const Position* position, const EvalWeights* weights);
+
+// search for the best move for the player to move. Depth 1 is always
+// completed, after that the search stops at whichever limit comes first.
+void engine_search(const Position* position, const SearchLimits* limits,
+		SearchResult* result);
+
+// The same search as a task: start it, then call engine_task_run() until
+// it returns 1, each call searching at most max_nodes more positions (a
+// few more when finishing up). The position and limits are copied.
+void engine_task_start(SearchTask* task, const Position* position,
+		const SearchLimits* limits);
+uint8_t engine_task_run(SearchTask* task, uint16_t max_nodes);
+
+// the result of the last completed iteration
+void engine_task_result(const SearchTask* task, SearchResult* result);
+
+#endif /* ENGINE_H_ */
@@ -0,0 +1,13 @@
+/*
+ * engine_weights.h
+ *
+ * The default evaluation weights (see EvalWeights in engine.h), kept in
+ * flash. Included once, by engine.c. build/tune writes this file with
+ * weights fitted to the results of games (see host/tune.c).
+ */
+
+const EvalWeights engine_default_weights PROGMEM = {
+	.line = {0, 1, 6, 40},
+	.centre = 3,
+	.mobility = 1
+};
@@ -10,52 +10,46 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdint.h>
+#include "clock.h"
 #include "display.h"
+#include "hal.h"
 #include "terminalio.h"
+#include "journal.h"
+#include "sound.h"
+#include "teeko.h"
+#include "trace.h"
 
 // Start pieces in the middle of the board
 #define CURSOR_X_START ((int)(WIDTH/2))
 #define CURSOR_Y_START ((int)(HEIGHT/2))
 
-uint8_t board[WIDTH][HEIGHT];
 // cursor coordinates should be /* SIGNED */ to allow left and down movement.
 // All other positions should be unsigned as there are no negative coordinates.
 int8_t cursor_x;
 int8_t cursor_y;
 uint8_t cursor_visible;
-uint8_t current_player;
 /********************************/
-//===
-uint8_t player_1_piece_count = 0; // 0 --4 pieces when player 1 and 2 reach 4 pieces start game phase2
-uint8_t player_2_piece_count = 0; // 0 --4 pieces when player 1 and 2 reach 4 pieces start game phase2
-uint8_t player_1_pos[4] = {-1, -1, -1, -1}; //store location of pieces
-uint8_t player_2_pos[4] = {-1, -1, -1, -1}; //store location of pieces
+// the game in progress (pieces, player to move, line counts) and the
+// moves made so far, for undo and redo
+static Position position;
+static MoveHistory history;
+// squares the picked up piece may move to, shown as SQUARE_PICKER
+static Bitboard legal_targets;
+// The hint overlay, if it is shown: where the player to move can win
+// (and with which pieces, in phase 2), and where the other player could.
+// It is only worked out when the position changes, so moving the cursor
+// costs nothing extra.
+static uint8_t overlay_shown;
+static Bitboard hint_squares;
+static Bitboard hint_pieces;
+static Bitboard threat_squares;
 
 //===
 uint8_t piece_is_pickedup = 0; //bool to test if the piece is pickedUp by the cursor to move
-int8_t player_1_piece_pos;//this variables in range [1..4] to detect which piece we are holding for player 1
-int8_t player_2_piece_pos;//this variables in range [1..4] to detect which piece we are holding for player 2
 int8_t cursor_x_old; // this for deleting player1 or player 2 and replace it with EMPTY_SQUARE after moving
 int8_t cursor_y_old; // this for deleting player1 or player 2 and replace it with EMPTY_SQUARE after moving
 
-// all possibles wins : TODO: delete square format win, and decrement POS_WINS
-#define POS_WINS 28
-int pos_win[POS_WINS][4] = {
-	//width format
-	{0, 1, 2, 3},   {1,2,3,4} ,  {5,6,7,8} ,    {6,7,8,9}, {10,11,12,13},
-	{11,12,13,14}, {15,16,17,18}, {16,17,18,19}, {20,21,22,23},{21,22,23,24},	
-	//height format
-	{0,5,10,15}  ,  {5,10,15,20},   {1,6,11,16}, {6,11,16,21} ,{2,7,12,17},
-	{7,12,17,22},{3,8,13,18},{8,13,18,23},{4,9,14,19},{9,14,19,24},		
-	//diagonal format
-	{3,7,11,15},{8,12,16,20},{21,17,13,9},{4,8,12,16},
-	{1,7,13,19},{0,6,12,18},{6,12,18,24},{5,11,17,23},		
-	//square format , we dont need it 
-	/*						
-	{2,3,7,8}, {3,4,8,9}, {5,6,10,11}, {6,7,11,12} , {7,8,12,13},{0,1,5,6},{1,2,6,7},
-	{8,9,13,14}, {10,11,15,16}, {11,12,16,17}, {12,13,17,18} , {13,14,18,19},
-	{15,16,20,21}, {16,17,21,22},{17,18,22,23},{18,19,23,24}*/	
-};
+// all possible wins (win_masks) are generated in teeko_tables.c
 /******************************/
 
 
@@ -63,36 +57,63 @@ int pos_win[POS_WINS][4] = {
 
 
 
+// work out the hint overlay for a new position
+static void update_overlay(void) {
+	Bitboard unused;
+	if(!overlay_shown) {
+		hint_squares = hint_pieces = threat_squares = 0;
+		return;
+	}
+	hint_squares = teeko_winning_moves(&position, position.to_move, &hint_pieces);
+	threat_squares = teeko_winning_moves(&position, 3 - position.to_move, &unused);
+}
+
+void toggle_overlay(void) {
+	overlay_shown = !overlay_shown;
+	update_overlay();
+	draw_game();
+}
+
+// what to draw on a square: the piece there, or a mark for the squares
+// a picked up piece can move to, or the hint overlay
+static uint8_t get_square_object(uint8_t x, uint8_t y) {
+	uint8_t object = get_piece_at(x, y);
+	Bitboard square = SQUARE_BIT(y * WIDTH + x);
+	if (object == PLAYER_1 || object == PLAYER_2) {
+		if (hint_pieces & square) {
+			object |= HINT_PIECE;
+		}
+	} else if (object == EMPTY_SQUARE) {
+		if (hint_squares & square) {
+			object = HINT_SQUARE;
+		} else if (threat_squares & square) {
+			object = THREAT_SQUARE;
+		}
+	}
+#ifdef CURSOR_BLINK
+	if (x == cursor_x && y == cursor_y) {
+		object |= piece_is_pickedup ? CURSOR_PICKER_MARK : CURSOR_MARK;
+	}
+#endif
+	return object;
+}
+
 void initialise_game(void) {
 	
 	// initialise the display we are using
 	initialise_display();
 	
-	// initialise the board to be all empty
-	for (uint8_t x = 0; x < WIDTH; x++) {
-		for (uint8_t y = 0; y < HEIGHT; y++) {
-			board[x][y] = EMPTY_SQUARE;
-		}
-	}
-		
-	// set the starting player
-	current_player = PLAYER_1;
-	set_display_attribute(FG_GREEN);
-	move_terminal_cursor(TERMINAL_BOARD_X, TERMINAL_BOARD_Y - 1);
-	printf("Current player: 1 (green)");
+	// initialise the board to be all empty, with player 1 to start
+	teeko_init(&position);
+	history_init(&history);
+	legal_targets = 0;
+	update_overlay();
+	draw_turn_indicator();
 	// also set where the cursor starts
 	cursor_x = CURSOR_X_START;
 	cursor_y = CURSOR_Y_START;
 	cursor_visible = 0;
 	
-	
-	
-	player_1_piece_count = 0;
-	player_2_piece_count = 0;
-	for(int i =0; i<4; i++) {
-		player_2_pos[i] = player_1_pos[i] = -1;
-	}
-	
 	piece_is_pickedup = 0; // false		
 }
 
@@ -108,11 +129,141 @@ uint8_t get_piece_column(void) {
 uint8_t get_piece_at(uint8_t x, uint8_t y) {
 	// check the bounds, anything outside the bounds
 	// will be considered empty
-	if (x < 0 || x >= WIDTH || y < 0 || y >= WIDTH) {
+	if (x >= WIDTH || y >= HEIGHT) {
 		return EMPTY_SQUARE;
+	}
+	Bitboard square = SQUARE_BIT(y * WIDTH + x);
+	if (position.pieces[0] & square) {
+		return PLAYER_1;
+	} else if (position.pieces[1] & square) {
+		return PLAYER_2;
+	} else if (legal_targets & square) {
+		return SQUARE_PICKER;
+	}
+	return EMPTY_SQUARE;
+}
+
+// make a move if it is legal, recording it for undo
+static uint8_t game_make_move(Move move) {
+	if(!teeko_is_legal(&position, move)) {
+		return 0;
+	}
+	history_make(&history, &position, move);
+	update_overlay();
+	clock_switch(position.to_move, 1);
+	return 1;
+}
+
+uint8_t game_place_piece(uint8_t pos) {
+	if(pos >= NUM_SQUARES) {
+		return 0;
+	}
+	return game_make_move(MAKE_MOVE(MOVE_PLACE, pos));
+}
+
+uint8_t game_move_piece(uint8_t from, uint8_t to) {
+	if(from >= NUM_SQUARES || to >= NUM_SQUARES) {
+		return 0;
+	}
+	return game_make_move(MAKE_MOVE(from, to));
+}
+
+uint8_t game_undo(void) {
+	if(history_undo(&history, &position) == MOVE_NONE) {
+		return 0;
+	}
+	update_overlay();
+	clock_switch(position.to_move, 0);
+	return 1;
+}
+
+// put down a picked up piece where it came from
+static void cancel_pickup(void) {
+	piece_is_pickedup = 0;
+	legal_targets = 0;
+}
+
+void undo_move(void) {
+	cancel_pickup();
+	if(game_undo()) {
+		journal_undo();
+	}
+	draw_game();
+	draw_turn_indicator();
+}
+
+// journal a move which has just been made and show it
+static void show_move(Move move) {
+	if(MOVE_FROM(move) == MOVE_PLACE) {
+		journal_placement(MOVE_TO(move));
 	} else {
-		//if in the bounds, just index into the array
-		return board[x][y];
+		journal_move(MOVE_FROM(move), MOVE_TO(move));
+	}
+	draw_game();
+	draw_turn_indicator();
+}
+
+void redo_move(void) {
+	cancel_pickup();
+	Move move = history_redo(&history, &position);
+	if(move != MOVE_NONE) {
+		update_overlay();
+		clock_switch(position.to_move, 0);
+		show_move(move);
+	}
+}
+
+void play_move(Move move) {
+	cancel_pickup();
+	if(game_make_move(move)) {
+		show_move(move);
+	}
+}
+
+const Position* game_position(void) {
+	return &position;
+}
+
+// pick up the piece on a square, marking where it can move to
+static void pick_up(uint8_t square) {
+	piece_is_pickedup = 1;
+	cursor_x_old = pgm_read_byte(&square_x[square]);
+	cursor_y_old = pgm_read_byte(&square_y[square]);
+	Bitboard empty = ALL_SQUARES & ~(position.pieces[0] | position.pieces[1]);
+	legal_targets = pgm_read_bitboard(&neighbour_masks[square]) & empty;
+}
+
+void game_encode(uint8_t* code) {
+	uint8_t pickup = NO_PICKUP;
+	if(piece_is_pickedup) {
+		pickup = cursor_y_old * WIDTH + cursor_x_old;
+	}
+	teeko_encode(&position, pickup, code);
+}
+
+uint8_t game_decode(const uint8_t* code) {
+	uint8_t pickup;
+	if(!teeko_decode(code, &position, &pickup)) {
+		return 0;
+	}
+	history_init(&history);
+	cancel_pickup();
+	if(pickup != NO_PICKUP) {
+		pick_up(pickup);
+	}
+	update_overlay();
+	return 1;
+}
+
+void draw_turn_indicator(void) {
+	if(position.to_move == PLAYER_1) {
+		set_display_attribute(FG_GREEN);
+		move_terminal_cursor(TERMINAL_BOARD_X, TERMINAL_BOARD_Y - 1);
+		printf_P(PSTR("Current player: 1 (green)"));
+	} else {
+		set_display_attribute(FG_RED);
+		move_terminal_cursor(TERMINAL_BOARD_X, TERMINAL_BOARD_Y - 1);
+		printf_P(PSTR("Current player: 2 (red)  "));
 	}
 }
 
@@ -121,7 +272,7 @@ void flash_cursor(void) {
 	if (cursor_visible) {
 		// we need to flash the cursor off, it should be replaced by
 		// the colour of the piece which is at that location
-		uint8_t piece_at_cursor = get_piece_at(cursor_x, cursor_y);
+		uint8_t piece_at_cursor = get_square_object(cursor_x, cursor_y);
 		
 		//and if the cursor is picking any piece the colour should be changed		
 		if(piece_is_pickedup) {
@@ -138,6 +289,20 @@ void flash_cursor(void) {
 
 /***********************************************************/
 void move_display_cursor(int8_t dx, int8_t dy) {
+	trace(TRACE_BEGIN + STAGE_MOVE_CURSOR, 0);
+	step_display_cursor(dx, dy);
+	// only the squares which change are repainted
+	draw_game();
+	trace(TRACE_END + STAGE_MOVE_CURSOR, 0);
+}
+
+void show_display_cursor(void) {
+	trace(TRACE_BEGIN + STAGE_MOVE_CURSOR, 0);
+	draw_game();
+	trace(TRACE_END + STAGE_MOVE_CURSOR, 0);
+}
+
+void step_display_cursor(int8_t dx, int8_t dy) {
 	//test if the cursor is holding a piece
 	if(piece_is_pickedup) {
 		/*** GAME PHASE 2 ***/
@@ -160,106 +325,76 @@ void move_display_cursor(int8_t dx, int8_t dy) {
 		if(cursor_y<0) cursor_y = HEIGHT - 1;
 
 	}
-	
-	initialise_display();
-	draw_game();
 }
 /*======================================================
 9) Game Over (Level 1  12 marks)
 =======================================================*/
+uint8_t game_winner(void) {
+	// only the player who has just moved can have won
+	uint8_t winner = teeko_winner(&position);
+	uint8_t flagged = clock_flagged();
+	if (!winner && flagged) {
+		// the player who ran out of time loses
+		winner = 3 - flagged;
+	}
+	return winner;
+}
+
 uint8_t is_game_over(void) {
-	if(player_1_piece_count < 4 || player_2_piece_count< 4) return 0;
-	
-	for (int m = 0; m < POS_WINS; m++) {
-		int count_win = 0;
-		
-		if(current_player == PLAYER_2) {
-			//test if the previous player(player1) has win the game
-			for (int i = 0; i < 4; i++) {
-				for (int j = 0; j < 4; j++) {
-					if (player_1_pos[i] == pos_win[m][j]) {
-						count_win++;
-						continue;
-					}
-				}
-			}
-			if (count_win == 4){
-				//- displayed on the terminal indicating which player has won the game
-				move_terminal_cursor(0, 0);
-				set_display_attribute(FG_GREEN);
-				printf("player 1 win");
-				return PLAYER_1;
-			}
-			
-			}else if(current_player == PLAYER_1){
-			//test if the previous player(player2) has win the game
-			count_win = 0;
-			for (int i = 0; i < 4; i++) {
-				for (int j = 0; j < 4; j++) {
-					if (player_2_pos[i] == pos_win[m][j]) {
-						count_win++;
-						continue;
-					}
-				}
-			}
-			if (count_win == 4){
-				//- displayed on the terminal indicating which player has won the game
-				move_terminal_cursor(0, 0);
-				set_display_attribute(FG_RED);
-				printf("player 2 win");
-				return PLAYER_2;
-			}
-			
-		}
-		
+	uint8_t winner = game_winner();
+	uint8_t flagged = clock_flagged();
+	if (flagged && !teeko_winner(&position)) {
+		// won on time
+		move_terminal_cursor(0, 2);
+		set_display_attribute(winner == PLAYER_1 ? FG_GREEN : FG_RED);
+		printf_P(PSTR("player %u ran out of time"), flagged);
+	}
+	if (winner == PLAYER_1) {
+		//- displayed on the terminal indicating which player has won the game
+		move_terminal_cursor(0, 0);
+		set_display_attribute(FG_GREEN);
+		printf_P(PSTR("player 1 win"));
+	} else if (winner == PLAYER_2) {
+		move_terminal_cursor(0, 0);
+		set_display_attribute(FG_RED);
+		printf_P(PSTR("player 2 win"));
 	}
-	return 0;
+	return winner;
 }
 
 
-void update_piece( void ) {
+// place, pick up or put down at the cursor
+static void select_square( void ) {
     	
     /*======================================================
 	5) Game Phase 1 (Level 1  8 marks)	
 	=======================================================*/
     // ends when all 8 pieces have been placed on the board    
-	if( player_1_piece_count < 4 || player_2_piece_count< 4 ) {
+	if( teeko_placing(&position) ) {
     	    	
 		uint8_t piece_at_cursor = get_piece_at(cursor_x, cursor_y);
 		//- not allowed to place a piece on top of another piece 
 		//- reject move if that happen
     	if(piece_at_cursor == EMPTY_SQUARE) {
 			// - place piece at the current location of the cursor
-    		board[cursor_x][cursor_y] = current_player;
+    		uint8_t pos = cursor_y * WIDTH + cursor_x;
+    		game_place_piece(pos);
+    		journal_placement(pos);
+    		play_sound(SOUND_PLACE);
         		
-    		update_square_colour(cursor_x, cursor_y, current_player);
-    		int pos = cursor_y * WIDTH + cursor_x;
-    		    		
-    		if(current_player == PLAYER_1) {
-    		    player_1_pos[player_1_piece_count] = pos;
-    		    player_1_piece_count++;
-    		    
-				/*======================================================
-				6) Turn Indicator (Level 1  6 marks)
-				=======================================================*/
-    	        set_display_attribute(FG_RED);
-    	        move_terminal_cursor(TERMINAL_BOARD_X, TERMINAL_BOARD_Y - 1);
-    			printf("Current player: 2 (red)  ");
-    		}else if(current_player == PLAYER_2){    		    
-    		    player_2_pos[player_2_piece_count] = pos;
-    		    player_2_piece_count++;
-    		    
-				
-				/*======================================================
-				6) Turn Indicator (Level 1  6 marks)
-				=======================================================*/
-    			set_display_attribute(FG_GREEN);
-    			move_terminal_cursor(TERMINAL_BOARD_X, TERMINAL_BOARD_Y - 1);
-    			printf("Current player: 1 (green)");
+    		if(overlay_shown) {
+    			draw_game();
+    		} else {
+    			update_square_colour(cursor_x, cursor_y, get_square_object(cursor_x, cursor_y));
     		}
-    		// - switch player 
-    		current_player = 3 - current_player; //alternate between 1 and 2
-    	}	   
+    		
+			/*======================================================
+			6) Turn Indicator (Level 1  6 marks)
+			=======================================================*/
+    		draw_turn_indicator();
+    	} else {
+    		play_sound(SOUND_ILLEGAL);
+    	}
 
 	}else {
 	/*======================================================
@@ -272,128 +407,81 @@ void update_piece( void ) {
 	        
 	        //is it the same location
 	        if(cursor_y == cursor_y_old && cursor_x == cursor_x_old) {
+	            play_sound(SOUND_ILLEGAL);
 	            return;
 	        }
 	        //is it local location, 
 	        uint8_t piece_at_cursor = get_piece_at(cursor_x, cursor_y);
 	        if(piece_at_cursor != SQUARE_PICKER) {
+	            play_sound(SOUND_ILLEGAL);
 	            return;
 	        }
 	        
-	        int pos = cursor_y*WIDTH + cursor_x;
-	        if(current_player == PLAYER_1) {
-	           	player_1_pos[player_1_piece_pos] = pos;
-	            board[ cursor_x_old ][ cursor_y_old ] = EMPTY_SQUARE;
-	            board[ cursor_x ][ cursor_y ] = PLAYER_1;
-	            
-				/*======================================================
-				6) Turn Indicator (Level 1  6 marks)
-				=======================================================*/
-	            set_display_attribute(FG_RED);
-    	        move_terminal_cursor(TERMINAL_BOARD_X, TERMINAL_BOARD_Y - 1);
-    			printf("Current player: 2 (red)  ");
-				
-	        }else if (current_player == PLAYER_2){
-	            player_2_pos[player_2_piece_pos] = pos;
-	            board[ cursor_x_old ][ cursor_y_old ] = EMPTY_SQUARE;
-	            board[ cursor_x ][ cursor_y ] = PLAYER_2;
-	            
-				/*======================================================
-				6) Turn Indicator (Level 1  6 marks)
-				=======================================================*/
-	            set_display_attribute(FG_GREEN);
-    	        move_terminal_cursor(TERMINAL_BOARD_X, TERMINAL_BOARD_Y - 1);
-    			printf("Current player: 1 (green)");
-	        }
-	        piece_is_pickedup = 0;
-	        // switch player
-    		current_player = 3 - current_player; //alternate between 1 and 2
+	        uint8_t from = cursor_y_old*WIDTH + cursor_x_old;
+	        uint8_t to = cursor_y*WIDTH + cursor_x;
+	        game_move_piece(from, to);
+	        journal_move(from, to);
+	        play_sound(SOUND_PLACE);
+	        cancel_pickup();
+	        draw_game();
+	        
+			/*======================================================
+			6) Turn Indicator (Level 1  6 marks)
+			=======================================================*/
+	        draw_turn_indicator();
     		
     	/* pick a piece */
 	    }else {
 	        
     	    uint8_t piece_at_cursor = get_piece_at(cursor_x, cursor_y);
-    	    int pos = cursor_y * WIDTH + cursor_x;
     	    
-    	    if(piece_at_cursor == PLAYER_1 && current_player == PLAYER_1) {
+    	    if(piece_at_cursor == position.to_move) {
     	        
-    	        piece_is_pickedup = 1;
-    	        cursor_x_old = cursor_x;
-    	        cursor_y_old = cursor_y;
-    	        for(int j= 0; j<4; j++) {
-    	            if( player_1_pos[j] == pos){
-    	                player_1_piece_pos = j;
-    	                break;
-    	            }
-    	        }				
+    	        play_sound(SOUND_PICKUP);
 				
 				/*======================================================
 				//10) Visual Display of Legal Moves (Level 2  7 marks):
 				=======================================================*/				
-				for(int n = (cursor_y-1); n <= (cursor_y+1); n++) {
-					if( n < 0 || n >= HEIGHT) continue;
-					
-					for(int m = (cursor_x -1); m <= (cursor_x +1); m++ ) {
-						if(m < 0 || n >= WIDTH) continue;
-						
-						if(board[m][n] == EMPTY_SQUARE) {
-							board[m][n] = SQUARE_PICKER;
-							update_square_colour(m, n, SQUARE_PICKER);
-						}
-					}
-				}
-				
-				
-    	    }else if (piece_at_cursor == PLAYER_2 && current_player == PLAYER_2) {
-    			
-    	        piece_is_pickedup = 1;
-    	        cursor_x_old = cursor_x;
-    	        cursor_y_old = cursor_y;
-    	        for(int j= 0; j<4; j++) {
-    	            if( player_2_pos[j] == pos){
-    	                player_2_piece_pos = j;
-    	                break;
-    	            }
-    	        }
-								
-				/*======================================================
-				//10) Visual Display of Legal Moves (Level 2  7 marks):
-				=======================================================*/				
-				for(int n = (cursor_y-1); n <= (cursor_y+1); n++) {
-					if( n < 0 || n >= HEIGHT) continue;
-					
-					for(int m = (cursor_x -1); m <= (cursor_x +1); m++ ) {
-						if(m < 0 || n >= WIDTH) continue;
-						
-						if(board[m][n] == EMPTY_SQUARE) {
-							board[m][n] = SQUARE_PICKER;
-							update_square_colour(m, n, SQUARE_PICKER);
-						}
+				pick_up(cursor_y * WIDTH + cursor_x);
+				for(uint8_t square = 0; square < NUM_SQUARES; square++) {
+					if(legal_targets & SQUARE_BIT(square)) {
+						update_square_colour(pgm_read_byte(&square_x[square]),
+								pgm_read_byte(&square_y[square]), SQUARE_PICKER);
 					}
 				}
+#ifdef CURSOR_BLINK
+				// the mark changes to the picked up cursor's
+				update_square_colour(cursor_x, cursor_y, get_square_object(cursor_x, cursor_y));
+#endif
     	    }else {
-    	        //do nothing: TODO , Sound Effects
+    	        // not a piece of the player to move
+    	        play_sound(SOUND_ILLEGAL);
     	    }
     	    
 	    }//else:piece not picked_up
 	}//else:there are other piece not placed	
 }//end function
 
+void update_piece( void ) {
+	trace(TRACE_BEGIN + STAGE_UPDATE_PIECE, 0);
+	select_square();
+	trace(TRACE_END + STAGE_UPDATE_PIECE, 0);
+}
+
 
 void draw_game( void ) {
+	trace(TRACE_BEGIN + STAGE_DRAW_GAME, 0);
+	if(!piece_is_pickedup) {
+		legal_targets = 0;
+	}
 	for (uint8_t x = 0; x < WIDTH; x++) {
 		for (uint8_t y = 0; y < HEIGHT; y++) {
-			if(!piece_is_pickedup) {
-				if(board[x][y] == SQUARE_PICKER) {
-					board[x][y] = EMPTY_SQUARE;
-				}
-			}
-			
-			update_square_colour(x, y, board[x][y]);
+			update_square_colour(x, y, get_square_object(x, y));
 		}
 	}
 	
 	print_longest_line();
+	trace(TRACE_END + STAGE_DRAW_GAME, 0);
 }
 
 
@@ -405,44 +493,16 @@ void draw_game( void ) {
 void print_longest_line( void ) {
 	
 
-	int p1_longest = 0;
-	int p2_longest = 0;
-	
-	for (int m = 0; m < POS_WINS; m++) {
-		int p1_curr = 0;
-		int p2_curr = 0;
-		//calculate longest line for player 1
-		for (int i = 0; i < 4; i++) {
-			for (int j = 0; j < 4; j++) {
-				if (player_1_pos[i] == pos_win[m][j]) {
-					move_terminal_cursor(0,0);
-					printf("what : %d", player_1_pos[i]);
-					p1_curr++;
-					continue;
-				}
-			}
-		}
-		//calculate longest line for player 2
-		for (int i = 0; i < 4; i++) {
-			for (int j = 0; j < 4; j++) {
-				if (player_2_pos[i] == pos_win[m][j]) {
-					p2_curr++;
-					continue;
-				}
-			}
-		}
-		
-		if(p1_curr>p1_longest) p1_longest = p1_curr;
-		if(p2_curr>p2_longest) p2_longest = p2_curr;
-	}
+	int p1_longest = teeko_longest_line(position.pieces[0]);
+	int p2_longest = teeko_longest_line(position.pieces[1]);
 	
 	set_display_attribute(FG_GREEN);
 	move_terminal_cursor(TERMINAL_BOARD_X - 15, TERMINAL_BOARD_Y + 5);
-	printf("Player 1 : %d", p1_longest);
+	printf_P(PSTR("Player 1 : %d"), p1_longest);
 	
 	
 	set_display_attribute(FG_RED);
 	move_terminal_cursor(TERMINAL_BOARD_X +18, TERMINAL_BOARD_Y +5);
-	printf("Player 2 : %d", p2_longest);
+	printf_P(PSTR("Player 2 : %d"), p2_longest);
 }
 
@@ -10,6 +10,7 @@
 #define GAME_H_
 
 #include <stdint.h>
+#include "teeko.h"
 
 // initialise the display of the board, this creates the internal board
 // and also updates the display of the board
@@ -21,8 +22,22 @@ void initialise_game(void);
 // anything outside the bounds of the boards will be SQUARE_EMPTY
 uint8_t get_piece_at(uint8_t x, uint8_t y);
 
+// Builds with CURSOR_BLINK defined draw the cursor as a mark with the
+// terminal's blink attribute, once each time it moves, and the terminal
+// does the flashing. Otherwise the cursor is repainted every
+// CURSOR_FLASH_MS, but a flash waits while more than
+// CURSOR_FLASH_BUSY_BYTES are waiting to be sent, so that it doesn't hold
+// up the output of real changes.
+#ifndef CURSOR_FLASH_MS
+#define CURSOR_FLASH_MS 500
+#endif
+#ifndef CURSOR_FLASH_BUSY_BYTES
+#define CURSOR_FLASH_BUSY_BYTES 16
+#endif
+
 // update the cursor display, by changing whether it is visible or not
 // call this function at regular intervals to have the cursor flash
+// (not needed in CURSOR_BLINK builds)
 void flash_cursor(void);
 
 // moves the position of the cursor by (dx, dy) such that if the cursor
@@ -31,12 +46,59 @@ void flash_cursor(void);
 // the cursor should be displayed after it is moved as well
 void move_display_cursor(int8_t dx, int8_t dy);
 
+// move the cursor as move_display_cursor() does without showing it, so
+// that a run of moves can be shown once by show_display_cursor()
+void step_display_cursor(int8_t dx, int8_t dy);
+void show_display_cursor(void);
+
 // returns 1 if the game is over, 0 otherwise
 uint8_t is_game_over(void);
 
+// the player who has won (with a line, or because the other ran out of
+// time), 0 if nobody has. Nothing is drawn.
+uint8_t game_winner(void);
+
 //place move and pick pieces
 void update_piece( void );
 
+// place a piece for the current player on square pos (y*WIDTH + x), or
+// move one of their pieces from square from to square to, and switch
+// players. Nothing is drawn. Returns 1, or 0 if the placement or move
+// is not legal (in which case nothing changes).
+uint8_t game_place_piece(uint8_t pos);
+uint8_t game_move_piece(uint8_t from, uint8_t to);
+
+// take back the last placement or move. Nothing is drawn. Returns 1, or
+// 0 if there was nothing to undo.
+uint8_t game_undo(void);
+
+// undo or redo from the keyboard: puts down any picked up piece, keeps
+// the journal up to date and redraws the board
+void undo_move(void);
+void redo_move(void);
+
+// make a move for the computer player, as undo_move() and redo_move()
+void play_move(Move move);
+
+// the game in progress, for the computer player
+const Position* game_position(void);
+
+// the whole state of the game (the position and any picked up piece) as
+// POSITION_CODE_SIZE bytes, see teeko_encode()
+void game_encode(uint8_t* code);
+
+// carry on from an encoded state, with no moves to undo. Nothing is
+// drawn. Returns 0 (changing nothing) if the code is not valid.
+uint8_t game_decode(const uint8_t* code);
+
+// show or hide the hint overlay: empty squares where the player to move
+// can win next move, where the other player could, and in phase 2 the
+// pieces which can move to win
+void toggle_overlay(void);
+
+// display whose turn it is
+void draw_turn_indicator( void );
+
 //draw the pieces in the game board
 void draw_game( void );
 
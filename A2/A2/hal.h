@@ -0,0 +1,297 @@
+/*
+ * hal.h
+ *
+ * Thin hardware abstraction layer. The game modules never touch the AVR
+ * registers (UDR0, PINC, TCNT0, SREG, ...) directly - they go through the
+ * functions declared here. On the AVR these are implemented in hal_avr.c
+ * (and inline below where they sit in an interrupt handler). The native
+ * Linux build implements them in host/hal_host.c, where serial maps to
+ * stdin/stdout, buttons to keyboard events and time to a monotonic clock.
+ *
+ * Interrupt handlers are written with HAL_ISR(vector) rather than ISR().
+ * On the AVR this is just ISR(); on the host it defines an ordinary
+ * function hal_isr_<vector>() which the host HAL calls when the
+ * corresponding event is simulated.
+ */
+
+#ifndef HAL_H_
+#define HAL_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __AVR__
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <avr/eeprom.h>
+
+#define HAL_ISR(vector) ISR(vector)
+
+#else /* host build */
+
+#define HAL_ISR(vector) void hal_isr_##vector(void)
+
+/* Program memory is ordinary memory on the host */
+#define PROGMEM
+#define PSTR(s) (s)
+#define printf_P printf
+#define memcpy_P memcpy
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+#define pgm_read_ptr(addr) (*(void* const*)(addr))
+
+#endif /* __AVR__ */
+
+/*
+ * Interrupt masking
+ */
+#ifdef __AVR__
+
+/* Disable interrupts, returning non-zero if they were enabled beforehand */
+static inline uint8_t hal_disable_interrupts(void) {
+	uint8_t were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	return were_enabled;
+}
+
+/* Re-enable interrupts if were_enabled (from hal_disable_interrupts()) is set */
+static inline void hal_restore_interrupts(uint8_t were_enabled) {
+	if(were_enabled) {
+		sei();
+	}
+}
+
+/* Return non-zero if interrupts are currently enabled */
+static inline uint8_t hal_interrupts_enabled(void) {
+	return bit_is_set(SREG, SREG_I);
+}
+
+static inline void hal_enable_interrupts(void) {
+	sei();
+}
+
+/* Called from busy-wait loops. Interrupts do the work on the AVR so
+ * there is nothing to do here.
+ */
+static inline void hal_idle(void) {
+}
+
+#else
+
+uint8_t hal_disable_interrupts(void);
+void hal_restore_interrupts(uint8_t were_enabled);
+uint8_t hal_interrupts_enabled(void);
+void hal_enable_interrupts(void);
+void hal_idle(void);
+
+#endif /* __AVR__ */
+
+/*
+ * UART (serial port 0)
+ */
+
+/* Set the baud rate and enable transmit, receive and the receive
+ * complete interrupt (USART_RX_vect).
+ */
+void hal_uart_init(long baudrate);
+
+/* Make stdin and stdout read and write through the given functions */
+void hal_stdio_init(int (*put_char)(char, FILE*), int (*get_char)(FILE*));
+
+#ifdef __AVR__
+
+/* Read the received byte - only valid inside USART_RX_vect */
+static inline char hal_uart_read_byte(void) {
+	return UDR0;
+}
+
+/* Write a byte for transmission - only valid inside USART_UDRE_vect */
+static inline void hal_uart_write_byte(char c) {
+	UDR0 = c;
+}
+
+/* Turn the data register empty interrupt (USART_UDRE_vect) on or off */
+static inline void hal_uart_tx_interrupt(uint8_t enable) {
+	if(enable) {
+		UCSR0B |= (1 << UDRIE0);
+	} else {
+		UCSR0B &= ~(1 << UDRIE0);
+	}
+}
+
+#else
+
+char hal_uart_read_byte(void);
+void hal_uart_write_byte(char c);
+void hal_uart_tx_interrupt(uint8_t enable);
+
+#endif /* __AVR__ */
+
+/*
+ * Push buttons (B0 to B3 on pins C0 to C3)
+ */
+
+/* Enable the pin change interrupt (PCINT1_vect) for pins C0 to C3 */
+void hal_buttons_init(void);
+
+#ifdef __AVR__
+
+/* Return the state of the buttons, bit n is button n */
+static inline uint8_t hal_button_pins(void) {
+	return PINC & 0x0F;
+}
+
+#else
+
+uint8_t hal_button_pins(void);
+
+#endif /* __AVR__ */
+
+/*
+ * Timer 0
+ */
+
+/* Start timer 0 generating an interrupt (TIMER0_COMPA_vect) every millisecond */
+void hal_timer0_init(void);
+
+#ifdef __AVR__
+
+/* The count through the current millisecond, 0 to 249 in 4us steps */
+static inline uint8_t hal_timer0_count(void) {
+	return TCNT0;
+}
+
+/* Non-zero if the count has wrapped but TIMER0_COMPA_vect hasn't run yet
+ * (because interrupts are disabled)
+ */
+static inline uint8_t hal_timer0_tick_pending(void) {
+	return TIFR0 & (1<<OCF0A);
+}
+
+#else
+
+uint8_t hal_timer0_count(void);
+uint8_t hal_timer0_tick_pending(void);
+
+#endif /* __AVR__ */
+
+/*
+ * Tone generator (timer 1 toggling OC1A, pin B1, for the piezo buzzer)
+ */
+
+/* Set up timer 1 for tones, silent to begin with */
+void hal_tone_init(void);
+
+#ifdef __AVR__
+
+/* Play a square wave of the given frequency in Hz, or stop if 0. The
+ * timer counts at 2MHz and toggles the pin on each compare match.
+ */
+static inline void hal_tone(uint16_t frequency) {
+	if(frequency == 0) {
+		TCCR1A = 0;
+		PORTB &= ~(1<<PORTB1);
+		return;
+	}
+	OCR1A = (uint16_t)(1000000UL / frequency) - 1;
+	TCNT1 = 0;
+	TCCR1A = (1<<COM1A0);
+}
+
+#else
+
+void hal_tone(uint16_t frequency);
+
+#endif /* __AVR__ */
+
+/*
+ * SPI, as master to the LED matrix (SS, MOSI and SCK on pins B2, B3, B5)
+ */
+
+/* Set up the SPI with the transfer complete interrupt (SPI_STC_vect) */
+void hal_spi_init(void);
+
+#ifdef __AVR__
+
+/* Start sending a byte. SPI_STC_vect follows once it has gone. */
+static inline void hal_spi_write_byte(uint8_t byte) {
+	SPDR = byte;
+}
+
+#else
+
+void hal_spi_write_byte(uint8_t byte);
+
+#endif /* __AVR__ */
+
+/*
+ * Link port, a second serial line to another board (TX on pin D2, RX on
+ * pin D3, crossed over). The 328P has only the one USART, which the
+ * terminal uses, so this is a software UART at HAL_LINK_BAUD, 8N1, run by
+ * the timer 2 interrupt. It works a byte at a time like the USART does:
+ * received is called with each byte which arrives, and next_byte is asked
+ * for the next byte to send (-1 if there is none) whenever the line is
+ * free. Both are called with interrupts disabled.
+ */
+#define HAL_LINK_BAUD 2400
+
+void hal_link_init(void (*received)(uint8_t byte), int16_t (*next_byte)(void));
+
+/* Start sending if the line is idle (next_byte has something for it) */
+void hal_link_start(void);
+
+/* Stop (on = 0) or restart the link port. The timer 2 interrupt runs all
+ * the time while it is on, so it is stopped when there is nothing to
+ * listen for. Bytes which arrive while it is off are lost, and anything
+ * to send waits until it is on again.
+ */
+void hal_link_enable(uint8_t on);
+
+/*
+ * Stack. At reset, before main() runs, the RAM from the end of the
+ * variables to the top of the stack is painted with a pattern. The paint
+ * left at the bottom is stack which has never been used.
+ */
+#define HAL_STACK_UNKNOWN 0xFFFF
+
+/* Bytes of stack never used since reset, or HAL_STACK_UNKNOWN where this
+ * can't be measured (the host)
+ */
+uint16_t hal_stack_unused(void);
+
+/*
+ * EEPROM
+ */
+#define HAL_EEPROM_SIZE 1024
+
+#ifdef __AVR__
+
+static inline uint8_t hal_eeprom_read(uint16_t address) {
+	return eeprom_read_byte((const uint8_t*)address);
+}
+
+/* Non-zero if a write can be started without waiting */
+static inline uint8_t hal_eeprom_ready(void) {
+	return eeprom_is_ready();
+}
+
+/* Start writing a byte. This takes about 3.4ms to complete, during which
+ * hal_eeprom_ready() returns 0; call it only when hal_eeprom_ready() to
+ * avoid blocking.
+ */
+static inline void hal_eeprom_write(uint16_t address, uint8_t value) {
+	eeprom_write_byte((uint8_t*)address, value);
+}
+
+#else
+
+uint8_t hal_eeprom_read(uint16_t address);
+uint8_t hal_eeprom_ready(void);
+void hal_eeprom_write(uint16_t address, uint8_t value);
+
+#endif /* __AVR__ */
+
+#endif /* HAL_H_ */
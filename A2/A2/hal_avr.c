@@ -0,0 +1,276 @@
+/*
+ * hal_avr.c
+ *
+ * AVR (ATmega328P) implementation of the hardware abstraction layer.
+ * The register accesses needed inside interrupt handlers are inline
+ * in hal.h; the set-up code lives here, along with the software UART of
+ * the link port, which is all interrupt handler.
+ */
+
+#ifdef __AVR__
+
+#include "hal.h"
+
+/* System clock rate in Hz. (L at the end indicates this is a long constant) */
+#define SYSCLK 16000000L
+
+void hal_uart_init(long baudrate) {
+	uint16_t ubrr;
+
+	/* Configure the serial port baud rate */
+	/* (This differs from the datasheet formula so that we get
+	 * rounding to the nearest integer while using integer division
+	 * (which truncates)).
+	*/
+	ubrr = ((SYSCLK / (8 * baudrate)) + 1)/2 - 1;
+	UBRR0 = ubrr;
+
+	/*
+	 * Enable transmission and receiving via UART. We don't enable
+	 * the UDR empty interrupt here (we wait until we've got a
+	 * character to transmit).
+	 * NOTE: Interrupts must be enabled globally for this
+	 * library to work, but we do not do this here.
+	*/
+	UCSR0B = (1<<RXEN0)|(1<<TXEN0);
+
+	/*
+	 * Enable receive complete interrupt
+	*/
+	UCSR0B  |= (1 <<RXCIE0);
+}
+
+/* Stream that uses the given get and put functions. FDEV_SETUP_STREAM
+ * needs constant initialisers so we fill the stream in at run time.
+ */
+static FILE uart_stream;
+
+void hal_stdio_init(int (*put_char)(char, FILE*), int (*get_char)(FILE*)) {
+	fdev_setup_stream(&uart_stream, put_char, get_char, _FDEV_SETUP_RW);
+	stdout = &uart_stream;
+	stdin = &uart_stream;
+}
+
+// Setup interrupt if any of pins C0 to C3 change. We do this
+// using a pin change interrupt. These pins correspond to pin
+// change interrupts PCINT8 to PCINT11 which are covered by
+// Pin change interrupt 1.
+void hal_buttons_init(void) {
+	// Enable the interrupt (see datasheet page 82)
+	PCICR |= (1<<PCIE1);
+
+	// Make sure the interrupt flag is cleared (by writing a
+	// 1 to it) (see datasheet page 82)
+	PCIFR |= (1<<PCIF1);
+
+	// Choose which pins we're interested in by setting
+	// the relevant bits in the mask register (see datasheet page 83)
+	PCMSK1 |= (1<<PCINT8)|(1<<PCINT9)|(1<<PCINT10)|(1<<PCINT11);
+}
+
+/* Set up timer 0 to generate an interrupt every 1ms.
+ * We will divide the clock by 64 and count up to 249.
+ * We will therefore get an interrupt every 64 x 250
+ * clock cycles, i.e. every 1 milliseconds with a 16MHz
+ * clock.
+ * The counter will be reset to 0 when it reaches it's
+ * output compare value.
+ */
+void hal_timer0_init(void) {
+	/* Clear the timer */
+	TCNT0 = 0;
+
+	/* Set the output compare value to be 249 */
+	OCR0A = 249;
+
+	/* Set the timer to clear on compare match (CTC mode)
+	 * and to divide the clock by 64. This starts the timer
+	 * running.
+	 */
+	TCCR0A = (1<<WGM01);
+	TCCR0B = (1<<CS01)|(1<<CS00);
+
+	/* Enable an interrupt on output compare match.
+	 * Note that interrupts have to be enabled globally
+	 * before the interrupts will fire.
+	 */
+	TIMSK0 |= (1<<OCIE0A);
+
+	/* Make sure the interrupt flag is cleared by writing a
+	 * 1 to it.
+	 */
+	TIFR0 &= (1<<OCF0A);
+}
+
+/* The stack is painted first thing after reset, before even the zero
+ * register is set up, so this is in assembler. The stack pointer already
+ * points at the top of RAM (__stack) and nothing is on it yet.
+ */
+#define STACK_PAINT 0xC5
+
+extern uint8_t _end;
+extern uint8_t __stack;
+
+void hal_paint_stack(void) __attribute__((naked, used, section(".init1")));
+
+void hal_paint_stack(void) {
+	__asm__ volatile(
+		"	ldi r30, lo8(_end)\n"
+		"	ldi r31, hi8(_end)\n"
+		"	ldi r24, %0\n"
+		"	ldi r25, hi8(__stack)\n"
+		"1:	st Z+, r24\n"
+		"	cpi r30, lo8(__stack)\n"
+		"	cpc r31, r25\n"
+		"	brlo 1b\n"
+		"	breq 1b\n"
+		:: "M" (STACK_PAINT));
+}
+
+uint16_t hal_stack_unused(void) {
+	const uint8_t* p = &_end;
+	while(p <= &__stack && *p == STACK_PAINT) {
+		p++;
+	}
+	return p - &_end;
+}
+
+/* Timer 1 counts at 2MHz (16MHz / 8) in CTC mode up to OCR1A. The
+ * output compare pin is only connected (toggling) while a tone plays.
+ */
+void hal_tone_init(void) {
+	DDRB |= (1<<DDB1);
+	PORTB &= ~(1<<PORTB1);
+	TCCR1A = 0;
+	TCCR1B = (1<<WGM12)|(1<<CS11);
+}
+
+/* The LED matrix is the only device on the SPI bus, so it is selected
+ * (SS low) all the time. The clock is 1MHz (16MHz / 16), so a byte takes
+ * 8us and interrupts come every 128 cycles while a frame is being sent.
+ */
+void hal_spi_init(void) {
+	DDRB |= (1<<DDB2)|(1<<DDB3)|(1<<DDB5);
+	PORTB &= ~(1<<PORTB2);
+
+	/* Enable the SPI as master with the transfer complete interrupt */
+	SPCR = (1<<SPE)|(1<<MSTR)|(1<<SPIE)|(1<<SPR0);
+}
+
+/* Software UART for the link port. Timer 2 interrupts three times a bit
+ * (16MHz / 32 / 69 = 7246Hz, 0.6% fast for 2400 baud). The transmitter
+ * changes the TX pin every third tick. The receiver watches for the
+ * falling edge of a start bit, which it sees up to a tick late, and then
+ * samples each bit four ticks on and every three ticks after that, which
+ * is close to the middle of each bit.
+ */
+#define LINK_TICKS_PER_BIT 3
+
+static void (*link_received)(uint8_t);
+static int16_t (*link_next_byte)(void);
+static volatile uint8_t link_tx_wanted;
+
+static uint16_t link_tx_shift;	// stop bit, data, start bit, sent from bit 0
+static uint8_t link_tx_bits;	// still to send
+static uint8_t link_tx_ticks;
+
+static uint8_t link_rx_byte;
+static uint8_t link_rx_bits;	// data bits received, 0xFF when idle
+static uint8_t link_rx_ticks;
+
+void hal_link_init(void (*received)(uint8_t byte), int16_t (*next_byte)(void)) {
+	link_received = received;
+	link_next_byte = next_byte;
+	link_tx_bits = 0;
+	link_rx_bits = 0xFF;
+
+	/* TX idles high, RX has the pull up on */
+	DDRD |= (1<<DDD2);
+	DDRD &= ~(1<<DDD3);
+	PORTD |= (1<<PORTD2)|(1<<PORTD3);
+
+	/* CTC mode, divide the clock by 32, interrupt on compare match */
+	TCNT2 = 0;
+	OCR2A = 68;
+	TCCR2A = (1<<WGM21);
+	TCCR2B = (1<<CS21)|(1<<CS20);
+	TIMSK2 |= (1<<OCIE2A);
+}
+
+void hal_link_start(void) {
+	link_tx_wanted = 1;
+}
+
+void hal_link_enable(uint8_t on) {
+	if(!on) {
+		TIMSK2 &= ~(1<<OCIE2A);
+		/* and leave TX idling high */
+		PORTD |= (1<<PORTD2);
+		return;
+	}
+	if(!(TIMSK2 & (1<<OCIE2A))) {
+		/* start afresh, a byte cut off by stopping is lost */
+		link_tx_bits = 0;
+		link_tx_ticks = 0;
+		link_rx_bits = 0xFF;
+		TCNT2 = 0;
+		TIFR2 = (1<<OCF2A);
+		TIMSK2 |= (1<<OCIE2A);
+	}
+}
+
+ISR(TIMER2_COMPA_vect) {
+	/* Transmit. The stop bit is held for its full time before the next
+	 * byte starts.
+	 */
+	if(link_tx_ticks) {
+		link_tx_ticks--;
+	} else {
+		if(link_tx_bits == 0 && link_tx_wanted) {
+			int16_t next = link_next_byte();
+			if(next < 0) {
+				link_tx_wanted = 0;
+			} else {
+				link_tx_shift = (1 << 9) | ((uint8_t)next << 1);
+				link_tx_bits = 10;
+			}
+		}
+		if(link_tx_bits) {
+			if(link_tx_shift & 1) {
+				PORTD |= (1<<PORTD2);
+			} else {
+				PORTD &= ~(1<<PORTD2);
+			}
+			link_tx_shift >>= 1;
+			link_tx_bits--;
+			link_tx_ticks = LINK_TICKS_PER_BIT - 1;
+		}
+	}
+
+	/* Receive */
+	uint8_t level = PIND & (1<<PIND3);
+	if(link_rx_bits == 0xFF) {
+		if(!level) {
+			// start bit, the first data bit is sampled 4 ticks on
+			link_rx_bits = 0;
+			link_rx_ticks = LINK_TICKS_PER_BIT;
+		}
+	} else if(link_rx_ticks-- == 0) {
+		link_rx_ticks = LINK_TICKS_PER_BIT - 1;
+		if(link_rx_bits < 8) {
+			link_rx_byte >>= 1;
+			if(level) {
+				link_rx_byte |= 0x80;
+			}
+			link_rx_bits++;
+		} else {
+			// the stop bit, the byte is framed properly if it is high
+			if(level) {
+				link_received(link_rx_byte);
+			}
+			link_rx_bits = 0xFF;
+		}
+	}
+}
+
+#endif /* __AVR__ */
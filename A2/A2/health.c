@@ -0,0 +1,115 @@
+/*
+ * health.c
+ *
+ * The runtime health page (see health.h)
+ */
+
+#include "health.h"
+#include "hal.h"
+#include "buttons.h"
+#include "link.h"
+#include "serialio.h"
+#include "terminalio.h"
+#include "timer0.h"
+
+// where the page goes, left of the board
+#define HEALTH_X 1
+#define HEALTH_Y 4
+#define HEALTH_LINES 9
+
+static uint8_t shown;
+static uint8_t changed;
+
+static uint32_t last_pass;	// time the last pass started (us)
+static uint8_t timing;		// last_pass is set
+static uint32_t second_start;
+static uint16_t passes;		// so far this second
+static uint16_t passes_per_second;
+static uint32_t worst_pass;	// us
+
+void health_start_loop(void) {
+	timing = 0;
+	changed = 1;	// the screen may have been cleared
+}
+
+void health_loop(void) {
+	uint32_t now = get_current_time_us();
+	if(timing) {
+		uint32_t pass = now - last_pass;
+		if(pass > worst_pass) {
+			worst_pass = pass;
+		}
+	} else {
+		timing = 1;
+		second_start = now;
+		passes = 0;
+	}
+	last_pass = now;
+	passes++;
+	if(now - second_start >= 1000000) {
+		passes_per_second = passes;
+		passes = 0;
+		second_start = now;
+		changed = 1;
+	}
+}
+
+void health_reset(void) {
+	worst_pass = 0;
+	passes_per_second = 0;
+	timing = 0;
+	serial_reset_stats();
+	button_reset_drops();
+	link_reset_stats();
+	changed = 1;
+}
+
+uint8_t health_shown(void) {
+	return shown;
+}
+
+void toggle_health(void) {
+	shown = !shown;
+	if(shown) {
+		changed = 1;
+		return;
+	}
+	for(uint8_t line = 0; line < HEALTH_LINES; line++) {
+		move_terminal_cursor(HEALTH_X, HEALTH_Y + line);
+		printf_P(PSTR("%27s"), "");
+	}
+}
+
+void draw_health(void) {
+	if(!shown || !changed) {
+		return;
+	}
+	changed = 0;
+	const LinkStats* link = link_stats();
+	uint16_t stack = hal_stack_unused();
+	uint16_t average = link->acked ? link->total_latency / link->acked : 0;
+
+	normal_display_mode();
+	move_terminal_cursor(HEALTH_X, HEALTH_Y);
+	printf_P(PSTR("loops/s       %-6u"), passes_per_second);
+	move_terminal_cursor(HEALTH_X, HEALTH_Y + 1);
+	printf_P(PSTR("worst loop    %luus   "), (unsigned long)worst_pass);
+	move_terminal_cursor(HEALTH_X, HEALTH_Y + 2);
+	printf_P(PSTR("out buffer    %u max  "), serial_output_high_water());
+	move_terminal_cursor(HEALTH_X, HEALTH_Y + 3);
+	printf_P(PSTR("in buffer     %u max  "), serial_input_high_water());
+	move_terminal_cursor(HEALTH_X, HEALTH_Y + 4);
+	printf_P(PSTR("input overrun %-3u"), serial_input_overruns());
+	move_terminal_cursor(HEALTH_X, HEALTH_Y + 5);
+	printf_P(PSTR("button drops  %-3u"), button_drops());
+	move_terminal_cursor(HEALTH_X, HEALTH_Y + 6);
+	if(stack == HAL_STACK_UNKNOWN) {
+		printf_P(PSTR("free stack    unknown"));
+	} else {
+		printf_P(PSTR("free stack    %-5u  "), stack);
+	}
+	move_terminal_cursor(HEALTH_X, HEALTH_Y + 7);
+	printf_P(PSTR("sync avg/max  %u/%ums  "), average, link->max_latency);
+	move_terminal_cursor(HEALTH_X, HEALTH_Y + 8);
+	printf_P(PSTR("link resent   %-5u"), link->retransmits);
+}
@@ -0,0 +1,37 @@
+/*
+ * health.h
+ *
+ * A page of numbers about how the firmware is keeping up, shown on the
+ * terminal beside the board: how many times a second the main loop runs
+ * and its longest single pass, how full the serial buffers have been,
+ * the input and button pushes which have been lost, the stack which has
+ * never been used and how the link is doing. They show whether drawing
+ * or serial output is starving the input.
+ */
+
+#ifndef HEALTH_H_
+#define HEALTH_H_
+
+#include <stdint.h>
+
+// call at the start of a main loop, so the time before it isn't counted
+// as one long pass (and the page is drawn again)
+void health_start_loop(void);
+
+// call once on each pass of the main loop
+void health_loop(void);
+
+// show or hide the page
+void toggle_health(void);
+
+// returns 1 while the page is shown
+uint8_t health_shown(void);
+
+// clear the counters (but not the stack measurement, which can't be)
+void health_reset(void);
+
+// redraw the page if it is shown and the numbers have moved on (once a
+// second)
+void draw_health(void);
+
+#endif /* HEALTH_H_ */
@@ -0,0 +1,443 @@
+/*
+ * analyse.c
+ *
+ * Offline analysis of a file of positions, e.g. logged games. For each
+ * position one line is written:
+ *
+ *     <record> <to move> <winner> <longest 1> <longest 2> <moves> <best>
+ *
+ * record counts from 0, winner is 0 if nobody has won, moves is the
+ * number of legal moves and best is the engine's move at --depth ("12" for
+ * a placement on square 12, "7>12" for a move, "-" with no search or no
+ * moves). Records which aren't positions a game can reach are written as
+ * "<record> invalid".
+ *
+ * The input is either binary, POSITION_CODE_SIZE byte records from
+ * teeko_encode() (a picked up piece is ignored), or text with one position
+ * per line: NUM_SQUARES characters '.', '1' or '2' for square 0 upwards,
+ * a space and the player to move. Empty lines and lines starting with #
+ * are skipped but still counted.
+ *
+ * The file is mapped rather than read, and cut into chunks which a pool
+ * of threads analyse. Chunks are written out in order as they finish and
+ * only a few per thread are in flight at once, with the pages of written
+ * chunks dropped, so files much larger than RAM stream through with
+ * nothing allocated per record.
+ *
+ *     ./build/analyse --depth 4 --out results.txt games.bin
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "teeko.h"
+#include "engine.h"
+
+// records in a chunk of a binary file, and bytes in a chunk of a text file
+#define CHUNK_RECORDS 16384
+#define CHUNK_BYTES (512 * 1024)
+// chunks in flight per thread
+#define CHUNKS_PER_THREAD 4
+// longest output line
+#define MAX_LINE 64
+
+/* Options */
+static unsigned thread_count;
+static uint8_t depth;
+static uint8_t text_input;
+static const char* out_path = "-";
+
+/* The input */
+static const char* input;
+static size_t input_size;
+static size_t chunk_count;
+static long page_size;
+
+/*
+ * Chunks in flight. Chunk k uses slot k % slot_count, and can't be started
+ * until chunk k - slot_count has been written.
+ */
+typedef struct {
+	char* text;			// the output lines
+	size_t length, capacity;
+	size_t records;		// in the chunk, including skipped lines
+	uint8_t done;
+} Slot;
+
+static Slot* slots;
+static size_t slot_count;
+static size_t next_chunk;	// next to be started
+static size_t written;		// chunks written out
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t changed = PTHREAD_COND_INITIALIZER;
+
+static uint64_t now_us(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+// the bytes of chunk k; text chunks are moved on to start after a newline
+static size_t chunk_start(size_t k) {
+	if(!text_input) {
+		size_t start = k * CHUNK_RECORDS * POSITION_CODE_SIZE;
+		return start < input_size ? start : input_size;
+	}
+	size_t start = k * CHUNK_BYTES;
+	if(start == 0 || start >= input_size) {
+		return start < input_size ? start : input_size;
+	}
+	const char* newline = memchr(input + start - 1, '\n', input_size - start + 1);
+	return newline ? (size_t)(newline - input) + 1 : input_size;
+}
+
+// reads a text line into a code, returns 0 if it isn't a position
+static uint8_t parse_line(const char* line, size_t length, uint8_t* code) {
+	Position position;
+	if(length != NUM_SQUARES + 2 || line[NUM_SQUARES] != ' ') {
+		return 0;
+	}
+	teeko_init(&position);
+	for(uint8_t square = 0; square < NUM_SQUARES; square++) {
+		if(line[square] == '1') {
+			position.pieces[0] |= SQUARE_BIT(square);
+		} else if(line[square] == '2') {
+			position.pieces[1] |= SQUARE_BIT(square);
+		} else if(line[square] != '.') {
+			return 0;
+		}
+	}
+	if(line[NUM_SQUARES + 1] != '1' && line[NUM_SQUARES + 1] != '2') {
+		return 0;
+	}
+	position.to_move = line[NUM_SQUARES + 1] - '0';
+	// teeko_decode() checks the rest
+	teeko_encode(&position, NO_PICKUP, code);
+	return 1;
+}
+
+// write a number without the cost of printf, returns its length
+static size_t put_number(char* out, size_t value) {
+	char digits[20];
+	size_t length = 0;
+	do {
+		digits[length++] = '0' + value % 10;
+		value /= 10;
+	} while(value);
+	for(size_t i = 0; i < length; i++) {
+		out[i] = digits[length - 1 - i];
+	}
+	return length;
+}
+
+// the number of moves teeko_generate_moves() would list
+static uint8_t count_moves(const Position* position) {
+	Bitboard empty = ALL_SQUARES & ~(position->pieces[0] | position->pieces[1]);
+	if(teeko_placing(position)) {
+		return teeko_count(empty);
+	}
+	Bitboard mine = position->pieces[position->to_move - 1];
+	uint8_t count = 0;
+	for(; mine; mine &= mine - 1) {
+		count += teeko_count(neighbour_masks[__builtin_ctzll(mine)] & empty);
+	}
+	return count;
+}
+
+static void analyse(size_t record, const uint8_t* code, Slot* slot) {
+	Position position;
+	uint8_t pickup;
+	if(slot->capacity - slot->length < MAX_LINE) {
+		slot->capacity *= 2;
+		slot->text = realloc(slot->text, slot->capacity);
+	}
+	char* out = slot->text + slot->length;
+	char* at = out + put_number(out, record);
+	if(!code || !teeko_decode(code, &position, &pickup)) {
+		memcpy(at, " invalid\n", 9);
+		slot->length += at + 9 - out;
+		return;
+	}
+
+	// the longest lines come from the line counts teeko_decode() set up
+	uint8_t longest[2] = { 0, 0 };
+	for(uint8_t m = 0; m < POS_WINS; m++) {
+		for(uint8_t player = PLAYER_1; player <= PLAYER_2; player++) {
+			uint8_t length = LINE_COUNT(&position, m, player);
+			if(length > longest[player - 1]) {
+				longest[player - 1] = length;
+			}
+		}
+	}
+	uint8_t winner = 0;
+	if(longest[0] == WIN_SHAPE_SQUARES || longest[1] == WIN_SHAPE_SQUARES) {
+		winner = teeko_winner(&position);
+	}
+	uint8_t move_count = winner ? 0 : count_moves(&position);
+
+	uint8_t fields[5] = { position.to_move, winner, longest[0], longest[1], move_count };
+	for(uint8_t f = 0; f < 5; f++) {
+		*at++ = ' ';
+		at += put_number(at, fields[f]);
+	}
+	*at++ = ' ';
+	if(depth && move_count) {
+		SearchLimits limits = { .max_depth = depth };
+		SearchResult result;
+		engine_search(&position, &limits, &result);
+		if(MOVE_FROM(result.move) != MOVE_PLACE) {
+			at += put_number(at, MOVE_FROM(result.move));
+			*at++ = '>';
+		}
+		at += put_number(at, MOVE_TO(result.move));
+	} else {
+		*at++ = '-';
+	}
+	*at++ = '\n';
+	slot->length += at - out;
+}
+
+// Analyse chunk k into its slot. Binary records are numbered from the
+// start of the file, but the lines of a text chunk can't be numbered until
+// the chunks before it have been counted, so they are numbered from the
+// start of the chunk and renumbered as they are written out.
+static void analyse_chunk(size_t k, Slot* slot) {
+	size_t start = chunk_start(k), end = chunk_start(k + 1);
+	slot->length = 0;
+	slot->records = 0;
+	if(!text_input) {
+		size_t first = start / POSITION_CODE_SIZE;
+		for(size_t at = start; at + POSITION_CODE_SIZE <= end; at += POSITION_CODE_SIZE) {
+			analyse(first++, (const uint8_t*)input + at, slot);
+		}
+		if((end - start) % POSITION_CODE_SIZE) {
+			// a short record at the end of the file
+			analyse(first, NULL, slot);
+		}
+		return;
+	}
+	while(start < end) {
+		const char* line = input + start;
+		const char* newline = memchr(line, '\n', end - start);
+		size_t length = newline ? (size_t)(newline - line) : end - start;
+		start += length + (newline != NULL);
+		if(length && line[length - 1] == '\r') {
+			length--;
+		}
+		if(length && line[0] != '#') {
+			uint8_t code[POSITION_CODE_SIZE];
+			analyse(slot->records, parse_line(line, length, code) ? code : NULL, slot);
+		}
+		slot->records++;
+	}
+}
+
+static void* worker_main(void* argument) {
+	(void)argument;
+	while(1) {
+		pthread_mutex_lock(&lock);
+		while(next_chunk < chunk_count && next_chunk >= written + slot_count) {
+			pthread_cond_wait(&changed, &lock);
+		}
+		if(next_chunk >= chunk_count) {
+			pthread_mutex_unlock(&lock);
+			return NULL;
+		}
+		size_t k = next_chunk++;
+		pthread_mutex_unlock(&lock);
+
+		Slot* slot = &slots[k % slot_count];
+		analyse_chunk(k, slot);
+
+		pthread_mutex_lock(&lock);
+		slot->done = 1;
+		pthread_cond_broadcast(&changed);
+		pthread_mutex_unlock(&lock);
+	}
+}
+
+static int write_all(int fd, const char* data, size_t length) {
+	while(length) {
+		ssize_t n = write(fd, data, length);
+		if(n < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		data += n;
+		length -= n;
+	}
+	return 0;
+}
+
+// copy the lines of a text chunk with first added to each record number
+static size_t renumber(const Slot* slot, size_t first, char* buffer) {
+	size_t length = 0;
+	const char* line = slot->text;
+	const char* end = slot->text + slot->length;
+	while(line < end) {
+		char* after;
+		size_t record = strtoull(line, &after, 10);
+		const char* newline = memchr(after, '\n', end - after);
+		length += sprintf(buffer + length, "%zu", first + record);
+		memcpy(buffer + length, after, newline + 1 - after);
+		length += newline + 1 - after;
+		line = newline + 1;
+	}
+	return length;
+}
+
+static void usage(const char* program) {
+	fprintf(stderr, "usage: %s [options] FILE\n"
+			"  --text          the file has a position per line (default: binary\n"
+			"                  records from teeko_encode())\n"
+			"  --depth N       search each position for the best move (default 0, none)\n"
+			"  --threads N     worker threads (default: one per core)\n"
+			"  --out FILE      where to write the results (default: stdout)\n", program);
+}
+
+int main(int argc, char** argv) {
+	const char* path = NULL;
+	for(int i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--text") == 0) {
+			text_input = 1;
+			continue;
+		}
+		if(argv[i][0] != '-' && !path) {
+			path = argv[i];
+			continue;
+		}
+		const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+		if(!value) {
+			usage(argv[0]);
+			return 2;
+		}
+		if(strcmp(argv[i], "--depth") == 0) {
+			depth = atoi(value);
+		} else if(strcmp(argv[i], "--threads") == 0) {
+			thread_count = atoi(value);
+		} else if(strcmp(argv[i], "--out") == 0) {
+			out_path = value;
+		} else {
+			usage(argv[0]);
+			return 2;
+		}
+		i++;
+	}
+	if(!path || depth > ENGINE_MAX_DEPTH) {
+		usage(argv[0]);
+		return 2;
+	}
+	if(thread_count == 0) {
+		long cores = sysconf(_SC_NPROCESSORS_ONLN);
+		thread_count = cores > 0 ? cores : 1;
+	}
+
+	int in = open(path, O_RDONLY);
+	struct stat status;
+	if(in < 0 || fstat(in, &status) < 0) {
+		perror(path);
+		return 1;
+	}
+	input_size = status.st_size;
+	if(input_size) {
+		input = mmap(NULL, input_size, PROT_READ, MAP_PRIVATE, in, 0);
+		if(input == MAP_FAILED) {
+			perror("mmap");
+			return 1;
+		}
+		madvise((void*)input, input_size, MADV_SEQUENTIAL);
+	}
+	close(in);
+	int out = strcmp(out_path, "-") == 0 ? STDOUT_FILENO :
+			open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(out < 0) {
+		perror(out_path);
+		return 1;
+	}
+	page_size = sysconf(_SC_PAGESIZE);
+
+	size_t chunk_size = text_input ? CHUNK_BYTES : CHUNK_RECORDS * POSITION_CODE_SIZE;
+	chunk_count = (input_size + chunk_size - 1) / chunk_size;
+	slot_count = thread_count * CHUNKS_PER_THREAD;
+	slots = calloc(slot_count, sizeof(*slots));
+	size_t slot_capacity = (text_input ? CHUNK_BYTES / (NUM_SQUARES + 2) + 1 :
+			CHUNK_RECORDS + 1) * MAX_LINE;
+	for(size_t s = 0; s < slot_count; s++) {
+		slots[s].capacity = slot_capacity;
+		slots[s].text = malloc(slot_capacity);
+	}
+	// a renumbered line is at most 20 digits longer, and the shortest line
+	// is 10 characters
+	size_t renumbered_capacity = 0;
+	char* renumbered = NULL;
+
+	uint64_t start_time = now_us();
+	pthread_t* threads = malloc(thread_count * sizeof(*threads));
+	for(unsigned w = 0; w < thread_count; w++) {
+		pthread_create(&threads[w], NULL, worker_main, NULL);
+	}
+
+	// write the chunks out in order as they finish
+	size_t records = 0;
+	int failed = 0;
+	for(size_t k = 0; k < chunk_count; k++) {
+		Slot* slot = &slots[k % slot_count];
+		pthread_mutex_lock(&lock);
+		while(!slot->done) {
+			pthread_cond_wait(&changed, &lock);
+		}
+		pthread_mutex_unlock(&lock);
+
+		if(!failed) {
+			if(text_input) {
+				if(slot->length * 3 > renumbered_capacity) {
+					renumbered_capacity = slot->length * 3;
+					renumbered = realloc(renumbered, renumbered_capacity);
+				}
+				size_t length = renumber(slot, records, renumbered);
+				failed = write_all(out, renumbered, length) < 0;
+				records += slot->records;
+			} else {
+				failed = write_all(out, slot->text, slot->length) < 0;
+			}
+			if(failed) {
+				perror(out_path);
+			}
+		}
+
+		// the input pages of this chunk won't be needed again
+		size_t drop_start = chunk_start(k) & ~(size_t)(page_size - 1);
+		size_t drop_end = chunk_start(k + 1) & ~(size_t)(page_size - 1);
+		if(drop_end > drop_start) {
+			madvise((void*)(input + drop_start), drop_end - drop_start, MADV_DONTNEED);
+		}
+
+		pthread_mutex_lock(&lock);
+		slot->done = 0;
+		written++;
+		pthread_cond_broadcast(&changed);
+		pthread_mutex_unlock(&lock);
+	}
+	for(unsigned w = 0; w < thread_count; w++) {
+		pthread_join(threads[w], NULL);
+	}
+
+	double seconds = (now_us() - start_time) / 1e6;
+	fprintf(stderr, "%zu bytes in %.2f s, %.1f MB/s, %u threads\n", input_size,
+			seconds, seconds > 0 ? input_size / seconds / 1e6 : 0.0, thread_count);
+	if(out != STDOUT_FILENO) {
+		close(out);
+	}
+	return failed;
+}
@@ -0,0 +1,304 @@
+/*
+ * batch_eval.c
+ *
+ * Batch win and longest line tests (see batch_eval.h)
+ */
+
+#include <string.h>
+#include "batch_eval.h"
+
+#if defined(__x86_64__) && NUM_SQUARES <= 32
+#define HAVE_VECTOR_KERNELS 1
+#include <immintrin.h>
+#endif
+
+static BatchIsa chosen = BATCH_AUTO;
+
+BatchIsa batch_best_isa(void) {
+#ifdef HAVE_VECTOR_KERNELS
+	if(__builtin_cpu_supports("avx2")) {
+		return BATCH_AVX2;
+	}
+	if(__builtin_cpu_supports("sse4.1")) {
+		return BATCH_SSE4;
+	}
+#endif
+	return BATCH_SCALAR;
+}
+
+uint8_t batch_use(BatchIsa isa) {
+	if(isa > batch_best_isa()) {
+		return 0;
+	}
+	chosen = isa;
+	return 1;
+}
+
+const char* batch_isa_name(BatchIsa isa) {
+	switch(isa) {
+	case BATCH_SCALAR: return "scalar";
+	case BATCH_SSE4: return "sse4.1";
+	case BATCH_AVX2: return "avx2";
+	default: return "auto";
+	}
+}
+
+static void evaluate_scalar(const Bitboard* boards, size_t count, uint8_t* wins,
+		uint8_t* longest) {
+	for(size_t i = 0; i < count; i++) {
+		wins[i] = teeko_is_win(boards[i]);
+		if(longest) {
+			longest[i] = teeko_longest_line(boards[i]);
+		}
+	}
+}
+
+#ifdef HAVE_VECTOR_KERNELS
+/*
+ * Each lane holds one board. A line is won where (board & line) == line,
+ * and its length is the popcount of board & line, found by looking up
+ * each nibble in a 16 entry table with a byte shuffle and adding the
+ * bytes of the lane.
+ */
+#define NIBBLE_COUNTS 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+
+__attribute__((target("avx2")))
+static void evaluate_avx2(const Bitboard* boards, size_t count, uint8_t* wins,
+		uint8_t* longest) {
+	const __m256i table = _mm256_setr_epi8(NIBBLE_COUNTS, NIBBLE_COUNTS);
+	const __m256i nibble = _mm256_set1_epi8(0x0F);
+	const __m256i low_byte = _mm256_set1_epi32(0xFF);
+	size_t i = 0;
+	for(; i + 8 <= count; i += 8) {
+		__m256i board = _mm256_loadu_si256((const __m256i*)(boards + i));
+		__m256i won = _mm256_setzero_si256();
+		__m256i best = _mm256_setzero_si256();
+		for(uint8_t m = 0; m < POS_WINS; m++) {
+			__m256i line = _mm256_set1_epi32(win_masks[m]);
+			__m256i on = _mm256_and_si256(board, line);
+			won = _mm256_or_si256(won, _mm256_cmpeq_epi32(on, line));
+			if(longest) {
+				__m256i low = _mm256_and_si256(on, nibble);
+				__m256i high = _mm256_and_si256(_mm256_srli_epi16(on, 4), nibble);
+				__m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(table, low),
+						_mm256_shuffle_epi8(table, high));
+				bytes = _mm256_add_epi32(bytes, _mm256_srli_epi32(bytes, 16));
+				bytes = _mm256_add_epi32(bytes, _mm256_srli_epi32(bytes, 8));
+				best = _mm256_max_epu32(best, _mm256_and_si256(bytes, low_byte));
+			}
+		}
+		uint32_t won_lanes = _mm256_movemask_ps(_mm256_castsi256_ps(won));
+		uint32_t lengths[8];
+		_mm256_storeu_si256((__m256i*)lengths, best);
+		for(uint8_t lane = 0; lane < 8; lane++) {
+			wins[i + lane] = (won_lanes >> lane) & 1;
+			if(longest) {
+				longest[i + lane] = lengths[lane];
+			}
+		}
+	}
+	evaluate_scalar(boards + i, count - i, wins + i, longest ? longest + i : NULL);
+}
+
+__attribute__((target("sse4.1")))
+static void evaluate_sse4(const Bitboard* boards, size_t count, uint8_t* wins,
+		uint8_t* longest) {
+	const __m128i table = _mm_setr_epi8(NIBBLE_COUNTS);
+	const __m128i nibble = _mm_set1_epi8(0x0F);
+	const __m128i low_byte = _mm_set1_epi32(0xFF);
+	size_t i = 0;
+	for(; i + 4 <= count; i += 4) {
+		__m128i board = _mm_loadu_si128((const __m128i*)(boards + i));
+		__m128i won = _mm_setzero_si128();
+		__m128i best = _mm_setzero_si128();
+		for(uint8_t m = 0; m < POS_WINS; m++) {
+			__m128i line = _mm_set1_epi32(win_masks[m]);
+			__m128i on = _mm_and_si128(board, line);
+			won = _mm_or_si128(won, _mm_cmpeq_epi32(on, line));
+			if(longest) {
+				__m128i low = _mm_and_si128(on, nibble);
+				__m128i high = _mm_and_si128(_mm_srli_epi16(on, 4), nibble);
+				__m128i bytes = _mm_add_epi8(_mm_shuffle_epi8(table, low),
+						_mm_shuffle_epi8(table, high));
+				bytes = _mm_add_epi32(bytes, _mm_srli_epi32(bytes, 16));
+				bytes = _mm_add_epi32(bytes, _mm_srli_epi32(bytes, 8));
+				best = _mm_max_epu32(best, _mm_and_si128(bytes, low_byte));
+			}
+		}
+		uint32_t won_lanes = _mm_movemask_ps(_mm_castsi128_ps(won));
+		uint32_t lengths[4];
+		_mm_storeu_si128((__m128i*)lengths, best);
+		for(uint8_t lane = 0; lane < 4; lane++) {
+			wins[i + lane] = (won_lanes >> lane) & 1;
+			if(longest) {
+				longest[i + lane] = lengths[lane];
+			}
+		}
+	}
+	evaluate_scalar(boards + i, count - i, wins + i, longest ? longest + i : NULL);
+}
+#endif
+
+static void line_terms_scalar(const Bitboard* mine, const Bitboard* theirs, size_t count,
+		int8_t (*terms)[BATCH_LINE_TERMS]) {
+	for(size_t i = 0; i < count; i++) {
+		memset(terms[i], 0, BATCH_LINE_TERMS);
+		for(uint8_t m = 0; m < POS_WINS; m++) {
+			uint8_t my_count = teeko_count(mine[i] & win_masks[m]);
+			uint8_t their_count = teeko_count(theirs[i] & win_masks[m]);
+			if(their_count == 0 && my_count > 0 && my_count <= BATCH_LINE_TERMS) {
+				terms[i][my_count - 1]++;
+			}
+			if(my_count == 0 && their_count > 0 && their_count <= BATCH_LINE_TERMS) {
+				terms[i][their_count - 1]--;
+			}
+		}
+	}
+}
+
+#ifdef HAVE_VECTOR_KERNELS
+/*
+ * Each lane holds one position, and keeps a count for each term. The
+ * compares give -1 in the lanes where they hold, so the counts go up by
+ * subtracting them and down by adding them.
+ */
+__attribute__((target("avx2")))
+static inline __m256i popcount_avx2(__m256i value) {
+	const __m256i table = _mm256_setr_epi8(NIBBLE_COUNTS, NIBBLE_COUNTS);
+	const __m256i nibble = _mm256_set1_epi8(0x0F);
+	__m256i low = _mm256_and_si256(value, nibble);
+	__m256i high = _mm256_and_si256(_mm256_srli_epi16(value, 4), nibble);
+	__m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(table, low),
+			_mm256_shuffle_epi8(table, high));
+	bytes = _mm256_add_epi32(bytes, _mm256_srli_epi32(bytes, 16));
+	bytes = _mm256_add_epi32(bytes, _mm256_srli_epi32(bytes, 8));
+	return _mm256_and_si256(bytes, _mm256_set1_epi32(0xFF));
+}
+
+__attribute__((target("avx2")))
+static void line_terms_avx2(const Bitboard* mine, const Bitboard* theirs, size_t count,
+		int8_t (*terms)[BATCH_LINE_TERMS]) {
+	const __m256i zero = _mm256_setzero_si256();
+	size_t i = 0;
+	for(; i + 8 <= count; i += 8) {
+		__m256i my_board = _mm256_loadu_si256((const __m256i*)(mine + i));
+		__m256i their_board = _mm256_loadu_si256((const __m256i*)(theirs + i));
+		__m256i sums[BATCH_LINE_TERMS];
+		for(uint8_t n = 0; n < BATCH_LINE_TERMS; n++) {
+			sums[n] = zero;
+		}
+		for(uint8_t m = 0; m < POS_WINS; m++) {
+			__m256i line = _mm256_set1_epi32(win_masks[m]);
+			__m256i my_count = popcount_avx2(_mm256_and_si256(my_board, line));
+			__m256i their_count = popcount_avx2(_mm256_and_si256(their_board, line));
+			__m256i mine_only = _mm256_cmpeq_epi32(their_count, zero);
+			__m256i theirs_only = _mm256_cmpeq_epi32(my_count, zero);
+			for(uint8_t n = 0; n < BATCH_LINE_TERMS; n++) {
+				__m256i holding = _mm256_set1_epi32(n + 1);
+				sums[n] = _mm256_sub_epi32(sums[n], _mm256_and_si256(mine_only,
+						_mm256_cmpeq_epi32(my_count, holding)));
+				sums[n] = _mm256_add_epi32(sums[n], _mm256_and_si256(theirs_only,
+						_mm256_cmpeq_epi32(their_count, holding)));
+			}
+		}
+		int32_t lanes[BATCH_LINE_TERMS][8];
+		for(uint8_t n = 0; n < BATCH_LINE_TERMS; n++) {
+			_mm256_storeu_si256((__m256i*)lanes[n], sums[n]);
+		}
+		for(uint8_t lane = 0; lane < 8; lane++) {
+			for(uint8_t n = 0; n < BATCH_LINE_TERMS; n++) {
+				terms[i + lane][n] = lanes[n][lane];
+			}
+		}
+	}
+	line_terms_scalar(mine + i, theirs + i, count - i, terms + i);
+}
+
+__attribute__((target("sse4.1")))
+static inline __m128i popcount_sse4(__m128i value) {
+	const __m128i table = _mm_setr_epi8(NIBBLE_COUNTS);
+	const __m128i nibble = _mm_set1_epi8(0x0F);
+	__m128i low = _mm_and_si128(value, nibble);
+	__m128i high = _mm_and_si128(_mm_srli_epi16(value, 4), nibble);
+	__m128i bytes = _mm_add_epi8(_mm_shuffle_epi8(table, low),
+			_mm_shuffle_epi8(table, high));
+	bytes = _mm_add_epi32(bytes, _mm_srli_epi32(bytes, 16));
+	bytes = _mm_add_epi32(bytes, _mm_srli_epi32(bytes, 8));
+	return _mm_and_si128(bytes, _mm_set1_epi32(0xFF));
+}
+
+__attribute__((target("sse4.1")))
+static void line_terms_sse4(const Bitboard* mine, const Bitboard* theirs, size_t count,
+		int8_t (*terms)[BATCH_LINE_TERMS]) {
+	const __m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+	for(; i + 4 <= count; i += 4) {
+		__m128i my_board = _mm_loadu_si128((const __m128i*)(mine + i));
+		__m128i their_board = _mm_loadu_si128((const __m128i*)(theirs + i));
+		__m128i sums[BATCH_LINE_TERMS];
+		for(uint8_t n = 0; n < BATCH_LINE_TERMS; n++) {
+			sums[n] = zero;
+		}
+		for(uint8_t m = 0; m < POS_WINS; m++) {
+			__m128i line = _mm_set1_epi32(win_masks[m]);
+			__m128i my_count = popcount_sse4(_mm_and_si128(my_board, line));
+			__m128i their_count = popcount_sse4(_mm_and_si128(their_board, line));
+			__m128i mine_only = _mm_cmpeq_epi32(their_count, zero);
+			__m128i theirs_only = _mm_cmpeq_epi32(my_count, zero);
+			for(uint8_t n = 0; n < BATCH_LINE_TERMS; n++) {
+				__m128i holding = _mm_set1_epi32(n + 1);
+				sums[n] = _mm_sub_epi32(sums[n], _mm_and_si128(mine_only,
+						_mm_cmpeq_epi32(my_count, holding)));
+				sums[n] = _mm_add_epi32(sums[n], _mm_and_si128(theirs_only,
+						_mm_cmpeq_epi32(their_count, holding)));
+			}
+		}
+		int32_t lanes[BATCH_LINE_TERMS][4];
+		for(uint8_t n = 0; n < BATCH_LINE_TERMS; n++) {
+			_mm_storeu_si128((__m128i*)lanes[n], sums[n]);
+		}
+		for(uint8_t lane = 0; lane < 4; lane++) {
+			for(uint8_t n = 0; n < BATCH_LINE_TERMS; n++) {
+				terms[i + lane][n] = lanes[n][lane];
+			}
+		}
+	}
+	line_terms_scalar(mine + i, theirs + i, count - i, terms + i);
+}
+#endif
+
+void batch_line_terms(const Bitboard* mine, const Bitboard* theirs, size_t count,
+		int8_t (*terms)[BATCH_LINE_TERMS]) {
+	BatchIsa isa = (chosen == BATCH_AUTO) ? batch_best_isa() : chosen;
+	switch(isa) {
+#ifdef HAVE_VECTOR_KERNELS
+	case BATCH_AVX2:
+		line_terms_avx2(mine, theirs, count, terms);
+		break;
+	case BATCH_SSE4:
+		line_terms_sse4(mine, theirs, count, terms);
+		break;
+#endif
+	default:
+		line_terms_scalar(mine, theirs, count, terms);
+		break;
+	}
+}
+
+void batch_evaluate(const Bitboard* boards, size_t count, uint8_t* wins,
+		uint8_t* longest) {
+	BatchIsa isa = (chosen == BATCH_AUTO) ? batch_best_isa() : chosen;
+	switch(isa) {
+#ifdef HAVE_VECTOR_KERNELS
+	case BATCH_AVX2:
+		evaluate_avx2(boards, count, wins, longest);
+		break;
+	case BATCH_SSE4:
+		evaluate_sse4(boards, count, wins, longest);
+		break;
+#endif
+	default:
+		evaluate_scalar(boards, count, wins, longest);
+		break;
+	}
+}
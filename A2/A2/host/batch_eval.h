@@ -0,0 +1,58 @@
+/*
+ * batch_eval.h
+ *
+ * Win and longest line tests for many bitboards at once, for the host
+ * tools which look at millions of positions. The results are the same as
+ * calling teeko_is_win() and teeko_longest_line() on each board, but the
+ * winning lines are tested against 8 boards at a time with AVX2 (or 4
+ * with SSE4.1) when the CPU has it. The line terms of the evaluation,
+ * which the weight tuning needs, are counted 8 or 4 positions at a time
+ * too. The kernel is chosen at run time, so the build needs no special
+ * flags.
+ *
+ * The vector kernels are for boards of up to 32 squares (a Bitboard of
+ * 32 bits); larger variants always use the scalar kernel.
+ */
+
+#ifndef BATCH_EVAL_H_
+#define BATCH_EVAL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "teeko.h"
+
+typedef enum {
+	BATCH_AUTO,		// the best the CPU has
+	BATCH_SCALAR,
+	BATCH_SSE4,
+	BATCH_AVX2
+} BatchIsa;
+
+// the fastest kernel this CPU and board can use
+BatchIsa batch_best_isa(void);
+
+// use a particular kernel from now on (for benchmarks and checking the
+// kernels against each other), or BATCH_AUTO. Returns 0 if the CPU or
+// board can't use it.
+uint8_t batch_use(BatchIsa isa);
+
+const char* batch_isa_name(BatchIsa isa);
+
+// for each of count boards set wins[i] to teeko_is_win(boards[i]) and, if
+// longest isn't NULL, longest[i] to teeko_longest_line(boards[i])
+void batch_evaluate(const Bitboard* boards, size_t count, uint8_t* wins,
+		uint8_t* longest);
+
+/* The line terms of engine_evaluate(), without the weights. For each of
+ * count positions, given the pieces of the player to move (mine) and of
+ * the other player, terms[i][n - 1] is the number of winning lines holding
+ * n of the player's pieces and none of the other's, less the number
+ * holding n of the other player's and none of the player's, for n from 1
+ * to 3.
+ */
+#define BATCH_LINE_TERMS 3
+
+void batch_line_terms(const Bitboard* mine, const Bitboard* theirs,
+		size_t count, int8_t (*terms)[BATCH_LINE_TERMS]);
+
+#endif /* BATCH_EVAL_H_ */
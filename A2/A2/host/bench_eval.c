@@ -0,0 +1,173 @@
+/*
+ * bench_eval.c
+ *
+ * Throughput of the batch evaluator (batch_eval.c) against calling
+ * teeko_is_win() and teeko_longest_line() on one position at a time.
+ * The boards are random sets of up to 4 squares, as one player's pieces.
+ * Every kernel the CPU has is run over the same boards, and its results
+ * are checked against the one-at-a-time loop. The line terms are run the
+ * same way, each board against a second random set of squares for the
+ * other player, and the vector kernels are checked against the scalar one.
+ *
+ *     ./build/bench_eval --positions 4000000 --rounds 5
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "teeko.h"
+#include "batch_eval.h"
+#include "random.h"
+
+static size_t position_count = 1 << 22;
+static unsigned rounds = 5;
+
+static Bitboard *boards, *others;
+static uint8_t *expect_wins, *expect_longest, *wins, *longest;
+static int8_t (*expect_terms)[BATCH_LINE_TERMS], (*terms)[BATCH_LINE_TERMS];
+
+static uint64_t now_us(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+// fastest of the rounds, in positions per second
+static double report(const char* name, uint64_t best_us, double baseline) {
+	double rate = best_us ? position_count * 1e6 / best_us : 0.0;
+	printf("%-10s %8.1f M positions/s", name, rate / 1e6);
+	if(baseline > 0) {
+		printf("  x%.2f", rate / baseline);
+	}
+	printf("\n");
+	return rate;
+}
+
+static void usage(const char* program) {
+	fprintf(stderr, "usage: %s [options]\n"
+			"  --positions N   boards per round (default 4194304)\n"
+			"  --rounds N      rounds of each kernel, the fastest counts (default 5)\n",
+			program);
+}
+
+int main(int argc, char** argv) {
+	for(int i = 1; i < argc; i++) {
+		const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+		if(!value) {
+			usage(argv[0]);
+			return 2;
+		}
+		if(strcmp(argv[i], "--positions") == 0) {
+			position_count = strtoull(value, NULL, 10);
+		} else if(strcmp(argv[i], "--rounds") == 0) {
+			rounds = atoi(value);
+		} else {
+			usage(argv[0]);
+			return 2;
+		}
+		i++;
+	}
+	if(position_count == 0 || rounds == 0) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	boards = malloc(position_count * sizeof(Bitboard));
+	expect_wins = malloc(position_count);
+	expect_longest = malloc(position_count);
+	wins = malloc(position_count);
+	longest = malloc(position_count);
+	others = malloc(position_count * sizeof(Bitboard));
+	expect_terms = malloc(position_count * BATCH_LINE_TERMS);
+	terms = malloc(position_count * BATCH_LINE_TERMS);
+	uint32_t random_state = 1;
+	for(size_t i = 0; i < position_count; i++) {
+		Bitboard board = 0;
+		uint8_t pieces = next_random(&random_state) % (PIECES_PER_PLAYER + 1);
+		while(teeko_count(board) < pieces) {
+			board |= SQUARE_BIT(next_random(&random_state) % NUM_SQUARES);
+		}
+		boards[i] = board;
+		Bitboard other = 0;
+		pieces = next_random(&random_state) % (PIECES_PER_PLAYER + 1);
+		while(teeko_count(other) < pieces) {
+			other |= SQUARE_BIT(next_random(&random_state) % NUM_SQUARES) & ~board;
+		}
+		others[i] = other;
+	}
+
+	printf("%zu positions, %d winning lines, best of %u rounds\n",
+			position_count, POS_WINS, rounds);
+
+	// the one-at-a-time loop
+	uint64_t best_us = UINT64_MAX;
+	for(unsigned r = 0; r < rounds; r++) {
+		uint64_t start = now_us();
+		for(size_t i = 0; i < position_count; i++) {
+			expect_wins[i] = teeko_is_win(boards[i]);
+			expect_longest[i] = teeko_longest_line(boards[i]);
+		}
+		uint64_t elapsed = now_us() - start;
+		if(elapsed < best_us) {
+			best_us = elapsed;
+		}
+	}
+	double baseline = report("loop", best_us, 0);
+
+	int failed = 0;
+	for(BatchIsa isa = BATCH_SCALAR; isa <= BATCH_AVX2; isa++) {
+		if(!batch_use(isa)) {
+			printf("%-10s not supported\n", batch_isa_name(isa));
+			continue;
+		}
+		best_us = UINT64_MAX;
+		for(unsigned r = 0; r < rounds; r++) {
+			memset(wins, 0xFF, position_count);
+			memset(longest, 0xFF, position_count);
+			uint64_t start = now_us();
+			batch_evaluate(boards, position_count, wins, longest);
+			uint64_t elapsed = now_us() - start;
+			if(elapsed < best_us) {
+				best_us = elapsed;
+			}
+		}
+		report(batch_isa_name(isa), best_us, baseline);
+		if(memcmp(wins, expect_wins, position_count) != 0 ||
+				memcmp(longest, expect_longest, position_count) != 0) {
+			printf("%-10s results differ from the loop\n", batch_isa_name(isa));
+			failed = 1;
+		}
+	}
+
+	// the line terms, each kernel against the scalar one
+	printf("line terms\n");
+	baseline = 0;
+	for(BatchIsa isa = BATCH_SCALAR; isa <= BATCH_AVX2; isa++) {
+		if(!batch_use(isa)) {
+			printf("%-10s not supported\n", batch_isa_name(isa));
+			continue;
+		}
+		int8_t (*out)[BATCH_LINE_TERMS] = (isa == BATCH_SCALAR) ? expect_terms : terms;
+		best_us = UINT64_MAX;
+		for(unsigned r = 0; r < rounds; r++) {
+			memset(out, 0x7F, position_count * BATCH_LINE_TERMS);
+			uint64_t start = now_us();
+			batch_line_terms(boards, others, position_count, out);
+			uint64_t elapsed = now_us() - start;
+			if(elapsed < best_us) {
+				best_us = elapsed;
+			}
+		}
+		double rate = report(batch_isa_name(isa), best_us, baseline);
+		if(isa == BATCH_SCALAR) {
+			baseline = rate;
+		} else if(memcmp(terms, expect_terms, position_count * BATCH_LINE_TERMS) != 0) {
+			printf("%-10s line terms differ from the scalar kernel\n", batch_isa_name(isa));
+			failed = 1;
+		}
+	}
+	return failed;
+}
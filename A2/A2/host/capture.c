@@ -0,0 +1,62 @@
+/*
+ * capture.c
+ *
+ * Reading and writing of recorded input sessions (see capture.h)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#include "capture.h"
+
+void capture_write(FILE* file, const CaptureEvent* event) {
+	fprintf(file, "%" PRIu64 " %c %02x\n", event->time_us, event->type,
+			event->value);
+	fflush(file);
+}
+
+long capture_load(const char* path, CaptureEvent** events) {
+	FILE* file = fopen(path, "r");
+	if(!file) {
+		perror(path);
+		return -1;
+	}
+
+	long count = 0, capacity = 256;
+	CaptureEvent* list = malloc(capacity * sizeof(*list));
+	char line[128];
+	long line_number = 0;
+	uint64_t last_time = 0;
+
+	while(fgets(line, sizeof(line), file)) {
+		line_number++;
+		if(line[0] == '#' || line[0] == '\n') {
+			continue;
+		}
+
+		CaptureEvent event;
+		unsigned value;
+		if(sscanf(line, "%" SCNu64 " %c %x", &event.time_us, &event.type,
+				&value) != 3 || value > 0xFF || event.time_us < last_time ||
+				(event.type != CAPTURE_SERIAL &&
+				event.type != CAPTURE_BUTTONS)) {
+			fprintf(stderr, "%s:%ld: bad event\n", path, line_number);
+			free(list);
+			fclose(file);
+			return -1;
+		}
+		event.value = value;
+		last_time = event.time_us;
+
+		if(count == capacity) {
+			capacity *= 2;
+			list = realloc(list, capacity * sizeof(*list));
+		}
+		list[count++] = event;
+	}
+
+	fclose(file);
+	*events = list;
+	return count;
+}
@@ -0,0 +1,37 @@
+/*
+ * capture.h
+ *
+ * Recorded input sessions for the native build. A capture is a text file
+ * with one input event per line:
+ *     <time in microseconds> s <byte in hex>     serial byte received
+ *     <time in microseconds> b <pins in hex>     button pins changed
+ * Lines starting with # are comments. Times are measured from start up
+ * and never decrease.
+ */
+
+#ifndef CAPTURE_H_
+#define CAPTURE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+
+#define CAPTURE_SERIAL 's'
+#define CAPTURE_BUTTONS 'b'
+
+typedef struct {
+	uint64_t time_us;
+	char type;		// CAPTURE_SERIAL or CAPTURE_BUTTONS
+	uint8_t value;	// the byte or the button pin state
+} CaptureEvent;
+
+/* Append one event to an open capture file */
+void capture_write(FILE* file, const CaptureEvent* event);
+
+/* Read a whole capture file. Returns the number of events and sets
+ * *events to a malloc'd array of them, or returns -1 (with a message
+ * on stderr) if the file can't be read.
+ */
+long capture_load(const char* path, CaptureEvent** events);
+
+#endif /* CAPTURE_H_ */
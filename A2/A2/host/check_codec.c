@@ -0,0 +1,137 @@
+/*
+ * check_codec.c
+ *
+ * Checks that every position of a number of random games, with each piece
+ * the mover could have picked up, packs with teeko_encode() and unpacks
+ * with teeko_decode() to the same position (line counts and hash
+ * included), and that codes of positions no game can reach are turned
+ * down. Run by make check.
+ *
+ *     ./build/check_codec --games 20000
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "teeko.h"
+#include "random.h"
+
+static unsigned game_count = 20000;
+static unsigned long checked;
+static unsigned failures;
+
+static void fail(const char* what, const Position* position, uint8_t pickup) {
+	if(failures++ < 10) {
+		fprintf(stderr, "%s: pieces %llx %llx, player %u to move, pickup %u\n", what,
+				(unsigned long long)position->pieces[0],
+				(unsigned long long)position->pieces[1], position->to_move, pickup);
+	}
+}
+
+static void check_round_trip(const Position* position, uint8_t pickup) {
+	uint8_t code[POSITION_CODE_SIZE], again[POSITION_CODE_SIZE];
+	Position decoded;
+	uint8_t decoded_pickup;
+	checked++;
+	teeko_encode(position, pickup, code);
+	if(!teeko_decode(code, &decoded, &decoded_pickup)) {
+		fail("not decoded", position, pickup);
+		return;
+	}
+	if(decoded.pieces[0] != position->pieces[0] || decoded.pieces[1] != position->pieces[1] ||
+			decoded.to_move != position->to_move || decoded.placed != position->placed ||
+			decoded.hash != position->hash ||
+			memcmp(decoded.lines, position->lines, sizeof(decoded.lines)) != 0 ||
+			decoded_pickup != pickup) {
+		fail("decoded differently", position, pickup);
+		return;
+	}
+	teeko_encode(&decoded, decoded_pickup, again);
+	if(memcmp(code, again, POSITION_CODE_SIZE) != 0) {
+		fail("encoded differently", position, pickup);
+	}
+}
+
+// every state of the position: nothing picked up, or in phase 2 any one
+// of the mover's pieces
+static void check_position(const Position* position) {
+	check_round_trip(position, NO_PICKUP);
+	if(teeko_placing(position) || teeko_winner(position)) {
+		return;
+	}
+	for(uint8_t square = 0; square < NUM_SQUARES; square++) {
+		if(position->pieces[position->to_move - 1] & SQUARE_BIT(square)) {
+			check_round_trip(position, square);
+		}
+	}
+}
+
+// a code which mustn't decode
+static void check_rejected(const char* what, const uint8_t* code) {
+	Position decoded;
+	uint8_t pickup;
+	checked++;
+	if(teeko_decode(code, &decoded, &pickup)) {
+		failures++;
+		fprintf(stderr, "decoded %s\n", what);
+	}
+}
+
+static void check_unreachable(void) {
+	uint8_t code[POSITION_CODE_SIZE];
+	Position position;
+
+	// both players with a line: the first 4 squares of the bottom two
+	// rows (a line on every board this builds for)
+	teeko_init(&position);
+	for(uint8_t x = 0; x < PIECES_PER_PLAYER; x++) {
+		position.pieces[0] |= SQUARE_BIT(x);
+		position.pieces[1] |= SQUARE_BIT(WIDTH + x);
+	}
+	if(teeko_is_win(position.pieces[0]) && teeko_is_win(position.pieces[1])) {
+		teeko_encode(&position, NO_PICKUP, code);
+		check_rejected("a position where both players have a line", code);
+	}
+
+	// pieces on the same square
+	teeko_init(&position);
+	position.pieces[0] = position.pieces[1] = SQUARE_BIT(0);
+	position.to_move = PLAYER_1;
+	teeko_encode(&position, NO_PICKUP, code);
+	check_rejected("two pieces on one square", code);
+
+	// an unused bit set
+	teeko_init(&position);
+	teeko_encode(&position, NO_PICKUP, code);
+	if(POSITION_CODE_BITS < 8 * POSITION_CODE_SIZE) {
+		code[POSITION_CODE_SIZE - 1] |= 0x80;
+		check_rejected("a code with an unused bit set", code);
+	}
+}
+
+int main(int argc, char** argv) {
+	for(int i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+			game_count = strtoul(argv[++i], NULL, 10);
+		} else {
+			fprintf(stderr, "usage: %s [--games N]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	uint32_t random_state = 1;
+	for(unsigned game = 0; game < game_count; game++) {
+		Position position;
+		teeko_init(&position);
+		check_position(&position);
+		for(unsigned ply = 0; ply < 200 && !teeko_winner(&position) &&
+				random_move(&position, &random_state); ply++) {
+			check_position(&position);
+		}
+	}
+	check_unreachable();
+
+	printf("check_codec: %lu codes, %u failures\n", checked, failures);
+	return failures ? 1 : 0;
+}
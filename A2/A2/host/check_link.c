@@ -0,0 +1,242 @@
+/*
+ * check_link.c
+ *
+ * Checks a game between two boards over the link (see link.h). Two
+ * instances of build/teeko have their link ports joined through this
+ * program, which passes the bytes across and can lose or repeat them.
+ *
+ * First board B is in a game of its own when board A invites it, and
+ * must leave the invites unanswered. Then a new board B takes up the
+ * invite and the two play the placement phase, with the first byte of A's
+ * first move lost and the first byte of B's first move sent twice. Both
+ * boards must end up with the same position. Run by make check.
+ *
+ *     ./build/check_link [--teeko build/teeko]
+ */
+
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#define FRAME_MOVE 0x80
+#define FRAME_NEW_GAME 0x50
+
+typedef struct {
+	const char* name;
+	pid_t pid;
+	int keys;		// its serial input
+	int link;		// our end of its link port
+	int errors;		// its stderr, where --position goes
+} Board;
+
+typedef struct {
+	unsigned long long pieces[2];
+	unsigned to_move, placed;
+} BoardPosition;
+
+static const char* teeko_path;
+static unsigned checks, failures;
+
+// bytes each way, and the faults put in
+static unsigned invites_from_a, bytes_from_b;
+static uint8_t drop_a_move = 1, repeat_b_move = 1;
+
+static void check(int ok, const char* what) {
+	checks++;
+	if(!ok) {
+		failures++;
+		fprintf(stderr, "check_link: %s\n", what);
+	}
+}
+
+static uint64_t now_ms(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000u + ts.tv_nsec / 1000000;
+}
+
+static void start_board(Board* board, const char* name) {
+	int keys[2], link[2], errors[2];
+	if(pipe2(keys, O_CLOEXEC) != 0 || pipe2(errors, O_CLOEXEC) != 0 ||
+			socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, link) != 0) {
+		perror("check_link");
+		exit(1);
+	}
+	board->name = name;
+	board->pid = fork();
+	if(board->pid < 0) {
+		perror("fork");
+		exit(1);
+	}
+	if(board->pid == 0) {
+		char link_fd[16];
+		int null = open("/dev/null", O_WRONLY);
+		dup2(keys[0], STDIN_FILENO);
+		dup2(null, STDOUT_FILENO);
+		dup2(errors[1], STDERR_FILENO);
+		fcntl(link[1], F_SETFD, 0);
+		snprintf(link_fd, sizeof(link_fd), "%d", link[1]);
+		execl(teeko_path, teeko_path, "--link-fd", link_fd, "--position", (char*)NULL);
+		perror(teeko_path);
+		_exit(1);
+	}
+	close(keys[0]);
+	close(errors[1]);
+	close(link[1]);
+	board->keys = keys[1];
+	board->link = link[0];
+	board->errors = errors[0];
+}
+
+/*
+ * Pass the bytes between the boards for ms milliseconds, counting them
+ * and putting in the faults
+ */
+static void pass_bytes(Board* a, Board* b, unsigned ms) {
+	uint64_t end = now_ms() + ms;
+	for(uint64_t now = now_ms(); now < end; now = now_ms()) {
+		struct pollfd fds[2] = {
+			{ .fd = a->link, .events = POLLIN },
+			{ .fd = b->link, .events = POLLIN }
+		};
+		if(poll(fds, 2, end - now) <= 0) {
+			continue;
+		}
+		for(int side = 0; side < 2; side++) {
+			Board* from = side ? b : a;
+			Board* to = side ? a : b;
+			if(!(fds[side].revents & (POLLIN | POLLHUP))) {
+				continue;
+			}
+			uint8_t buffer[64], out[128];
+			ssize_t n = read(from->link, buffer, sizeof(buffer));
+			if(n <= 0) {
+				// the board has gone
+				close(from->link);
+				from->link = -1;
+				continue;
+			}
+			size_t length = 0;
+			for(ssize_t i = 0; i < n; i++) {
+				uint8_t byte = buffer[i];
+				if(side == 0) {
+					invites_from_a += (byte & ~1) == FRAME_NEW_GAME;
+					if((byte & FRAME_MOVE) && drop_a_move) {
+						drop_a_move = 0;
+						continue;
+					}
+				} else {
+					bytes_from_b++;
+					if((byte & FRAME_MOVE) && repeat_b_move) {
+						repeat_b_move = 0;
+						out[length++] = byte;
+					}
+				}
+				out[length++] = byte;
+			}
+			if(to->link >= 0 && write(to->link, out, length) != (ssize_t)length) {
+				perror("link");
+			}
+		}
+	}
+}
+
+static void press(Board* board, const char* keys, Board* a, Board* b) {
+	for(; *keys; keys++) {
+		if(write(board->keys, keys, 1) != 1) {
+			perror(board->name);
+		}
+		pass_bytes(a, b, 50);
+	}
+}
+
+// end the board's input and read the position it prints as it exits
+static void finish_board(Board* board, Board* a, Board* b, BoardPosition* position) {
+	close(board->keys);
+	int status;
+	uint64_t give_up = now_ms() + 5000;
+	while(waitpid(board->pid, &status, WNOHANG) == 0) {
+		if(now_ms() > give_up) {
+			kill(board->pid, SIGKILL);
+			waitpid(board->pid, &status, 0);
+			break;
+		}
+		pass_bytes(a, b, 20);
+	}
+	char text[256];
+	ssize_t n = read(board->errors, text, sizeof(text) - 1);
+	close(board->errors);
+	text[n > 0 ? n : 0] = 0;
+	const char* line = strstr(text, "position ");
+	memset(position, 0, sizeof(*position));
+	check(line && sscanf(line, "position %llx %llx %u %u", &position->pieces[0],
+			&position->pieces[1], &position->to_move, &position->placed) == 4,
+			"a board didn't print its position");
+	if(board->link >= 0) {
+		close(board->link);
+		board->link = -1;
+	}
+}
+
+int main(int argc, char** argv) {
+	char default_path[4096];
+	snprintf(default_path, sizeof(default_path), "%s/teeko", dirname(strdup(argv[0])));
+	teeko_path = default_path;
+	for(int i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--teeko") == 0 && i + 1 < argc) {
+			teeko_path = argv[++i];
+		} else {
+			fprintf(stderr, "usage: %s [--teeko PATH]\n", argv[0]);
+			return 2;
+		}
+	}
+	signal(SIGPIPE, SIG_IGN);
+
+	// B places a piece in a game of its own, then A invites it
+	Board a, b;
+	BoardPosition position_a, position_b;
+	start_board(&b, "board B");
+	a.link = -1;
+	pass_bytes(&a, &b, 300);
+	press(&b, "s ", &a, &b);
+	start_board(&a, "board A");
+	pass_bytes(&a, &b, 300);
+	press(&a, "l", &a, &b);
+	pass_bytes(&a, &b, 1200);
+	check(invites_from_a >= 3, "the invite wasn't sent again");
+	check(bytes_from_b == 0, "a board in a game of its own answered the invite");
+	finish_board(&b, &a, &b, &position_b);
+	check(position_b.pieces[0] && !position_b.pieces[1] && position_b.placed == 1,
+			"the invite changed the game of board B");
+
+	// a new board B takes up the invite, and they place their pieces
+	start_board(&b, "board B");
+	pass_bytes(&a, &b, 1000);
+	check(bytes_from_b > 0, "the invite wasn't answered");
+	// each board's cursor starts in the same place, and no one gets a line
+	static const char* placements[] = { " ", "d ", "w ", "w ", "dds ", "dd ", "ww ", "dww " };
+	for(unsigned i = 0; i < sizeof(placements) / sizeof(placements[0]); i++) {
+		press(i % 2 ? &b : &a, placements[i], &a, &b);
+		pass_bytes(&a, &b, 700);
+	}
+	finish_board(&a, &a, &b, &position_a);
+	finish_board(&b, &a, &b, &position_b);
+	check(!drop_a_move && !repeat_b_move, "the faults weren't put in");
+	check(position_a.placed == 8, "the pieces weren't all placed");
+	check(memcmp(&position_a, &position_b, sizeof(position_a)) == 0,
+			"the boards ended with different positions");
+
+	printf("check_link: %u checks, %u failures\n", checks, failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,160 @@
+/*
+ * check_mcts.c
+ *
+ * Checks the Monte Carlo tree search node pool over random games: after
+ * every search each node is in the tree or on the free list (whole freed
+ * subtrees included) exactly once, the tree's counts agree, and a search
+ * with no pool at all returns MOVE_NONE. Every game is searched with the
+ * same tree, so it is kept as the game moves on one or two plies and
+ * started again at each new game. Run by make check.
+ *
+ *     ./build/check_mcts --games 20
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mcts.h"
+#include "random.h"
+
+static unsigned game_count = 20;
+static unsigned long searches;
+static unsigned failures;
+
+static const MctsIndex pool_sizes[] = { 1, 2, 7, 32, 300 };
+
+static void fail(const MctsTree* tree, const char* what, MctsIndex index) {
+	if(failures++ < 10) {
+		fprintf(stderr, "pool of %u, search %lu: %s at node %u\n", tree->pool_size, searches,
+				what, index);
+	}
+}
+
+// Mark a node and the children and siblings hanging off it. Returns 0 on a
+// node out of the pool or marked before (shared, or a cycle).
+static uint8_t mark(const MctsTree* tree, uint8_t* seen, MctsIndex index, uint8_t free) {
+	while(index != MCTS_NONE) {
+		if(index >= tree->pool_size) {
+			fail(tree, "index out of the pool", index);
+			return 0;
+		}
+		if(seen[index]) {
+			fail(tree, "node reached twice", index);
+			return 0;
+		}
+		seen[index] = 1;
+		const MctsNode* node = &tree->pool[index];
+		if(!free) {
+			uint8_t children = 0;
+			uint32_t child_visits = 0;
+			for(MctsIndex c = node->child; c != MCTS_NONE && c < tree->pool_size &&
+					children <= MAX_MOVES; c = tree->pool[c].sibling) {
+				children++;
+				child_visits += tree->pool[c].visits;
+			}
+			if(children != node->tried || node->tried > node->move_count) {
+				fail(tree, "children don't match tried", index);
+			}
+			if(child_visits > node->visits || node->score > 2u * node->visits) {
+				fail(tree, "counts don't add up", index);
+			}
+		}
+		if(!mark(tree, seen, node->child, free)) {
+			return 0;
+		}
+		index = node->sibling;
+	}
+	return 1;
+}
+
+static void check_pool(const MctsTree* tree) {
+	uint8_t* seen = calloc(tree->pool_size, 1);
+	if(tree->root == MCTS_NONE) {
+		fail(tree, "no root", MCTS_NONE);
+	} else if(tree->pool[tree->root].sibling != MCTS_NONE) {
+		fail(tree, "root with a sibling", tree->root);
+	}
+	uint8_t ok = mark(tree, seen, tree->root, 0);
+	// the free list: chains of siblings linked by their first node
+	unsigned chains = 0;
+	for(MctsIndex chain = tree->free; ok && chain != MCTS_NONE;
+			chain = tree->pool[chain].next_chain) {
+		if(chain >= tree->pool_size || ++chains > tree->pool_size) {
+			fail(tree, "free list runs on", chain);
+			ok = 0;
+		} else {
+			ok = mark(tree, seen, chain, 1);
+		}
+	}
+	if(ok) {
+		for(MctsIndex i = 0; i < tree->pool_size; i++) {
+			if(!seen[i]) {
+				fail(tree, "node lost", i);
+				break;
+			}
+		}
+	}
+	free(seen);
+}
+
+static uint32_t no_time(void) {
+	return 0;
+}
+
+static void check_empty_pool(void) {
+	MctsTree tree;
+	Position position;
+	SearchLimits limits = { .max_depth = 1, .max_nodes = 100, .clock = no_time };
+	SearchResult result;
+	mcts_init(&tree, NULL, 0, 1);
+	teeko_init(&position);
+	mcts_search(&tree, &position, &limits, &result);
+	searches++;
+	if(result.move != MOVE_NONE || result.reply != MOVE_NONE) {
+		fail(&tree, "a move from an empty pool", 0);
+	}
+}
+
+int main(int argc, char** argv) {
+	for(int i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+			game_count = strtoul(argv[++i], NULL, 10);
+		} else {
+			fprintf(stderr, "usage: %s [--games N]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	check_empty_pool();
+	uint32_t random_state = 1;
+	for(unsigned p = 0; p < sizeof(pool_sizes) / sizeof(pool_sizes[0]); p++) {
+		MctsIndex pool_size = pool_sizes[p];
+		MctsNode* pool = malloc(pool_size * sizeof(MctsNode));
+		MctsTree tree;
+		mcts_init(&tree, pool, pool_size, p + 1);
+		for(unsigned game = 0; game < game_count; game++) {
+			Position position;
+			SearchLimits limits = { .max_depth = 1, .clock = no_time };
+			teeko_init(&position);
+			for(unsigned ply = 0; ply < 60 && !teeko_winner(&position); ply++) {
+				SearchResult result;
+				limits.max_nodes = 1 + next_random(&random_state) % (pool_size + 50u);
+				// some games only the second player searches, so the
+				// tree moves on two plies at a time
+				if(game % 3 != 1 || position.to_move == PLAYER_2) {
+					mcts_search(&tree, &position, &limits, &result);
+					searches++;
+					check_pool(&tree);
+				}
+				if(!random_move(&position, &random_state)) {
+					break;
+				}
+			}
+		}
+		free(pool);
+	}
+
+	printf("check_mcts: %lu searches, %u failures\n", searches, failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,431 @@
+/*
+ * gen_endgame.c
+ *
+ * Makes the endgame table (see endgame.h). Every phase 2 position is
+ * solved to a given number of plies by retrograde analysis, a pass over
+ * all the positions for each ply. When n is even the pass finds the
+ * positions the player to move loses in n plies, where every move goes to
+ * a position won in fewer. When n is odd it finds those won in n plies,
+ * by taking back each of the other player's moves from the positions lost
+ * in n - 1 (and in the first pass, those with a winning move). Positions
+ * where either player already has a line are left out, as a game never
+ * carries on from them.
+ *
+ * Positions are numbered as endgame_index() numbers them, with one byte
+ * each for the result (about 76MB on the 5x5 board), and the passes are
+ * shared out between threads. Of each set of lost positions which are the
+ * same under a symmetry, only the one with the smallest number can go in
+ * the table. There are far more of them than fit in flash (a hundred
+ * thousand lost in 2 plies on the 5x5 board), so the table is filled up
+ * to --bytes with those furthest from the end: all of those lost in
+ * exactly n plies, from --plies down, and then an even spread over the
+ * key range of those lost in the next n. Out of the same --bytes comes
+ * the filter in front of the table, --filter-bytes of it.
+ *
+ * An entry packs the position's number and its plies into 32 bits, which
+ * boards of 6x6 and larger have too many positions for, so no table is
+ * made for them.
+ *
+ *     ./build/gen_endgame --plies 8 --bytes 4096 --out endgame_table.h
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "teeko.h"
+#include "endgame.h"
+
+// bytes per entry in the table
+#define ENTRY_SIZE 4
+// set in a position's result if it is the one of its symmetries which
+// goes in the table
+#define CANONICAL 0x80
+
+/* Options */
+static uint8_t max_plies = 8;
+static uint32_t max_bytes = 4096;
+static uint32_t filter_bytes = 1024;
+static unsigned thread_count;
+static const char* out_path = "-";
+
+static uint32_t binomial[NUM_SQUARES + 1][PIECES_PER_PLAYER + 1];
+static Bitboard* sets;			// every set of PIECES_PER_PLAYER squares, by number
+static uint32_t set_count;
+static uint32_t rest_count;		// sets of the squares left by one of them
+static uint8_t* is_line;		// by number, the set is a winning line
+static uint8_t* plies;			// by position, 0 if not solved
+
+static uint64_t now_us(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+// the number of a set of squares among all the sets of its size
+static uint32_t set_number(Bitboard set) {
+	uint32_t number = 0;
+	for(uint8_t k = 1; set; k++) {
+		number += binomial[__builtin_ctzll(set)][k];
+		set &= set - 1;
+	}
+	return number;
+}
+
+// the number of a set of squares among the sets of squares not in taken
+static uint32_t rest_number(Bitboard set, Bitboard taken) {
+	uint32_t number = 0;
+	for(uint8_t k = 1; set; k++) {
+		uint8_t square = __builtin_ctzll(set);
+		number += binomial[square - teeko_count(taken & (SQUARE_BIT(square) - 1))][k];
+		set &= set - 1;
+	}
+	return number;
+}
+
+static void make_sets(void) {
+	for(uint8_t n = 0; n <= NUM_SQUARES; n++) {
+		binomial[n][0] = 1;
+		for(uint8_t k = 1; k <= PIECES_PER_PLAYER; k++) {
+			binomial[n][k] = n ? binomial[n - 1][k - 1] + binomial[n - 1][k] : 0;
+		}
+	}
+	set_count = binomial[NUM_SQUARES][PIECES_PER_PLAYER];
+	rest_count = binomial[NUM_SQUARES - PIECES_PER_PLAYER][PIECES_PER_PLAYER];
+	sets = malloc(set_count * sizeof(Bitboard));
+	is_line = malloc(set_count);
+	// the sets in order of number are those of the bits of the numbers
+	// with PIECES_PER_PLAYER bits set, in order
+	Bitboard set = SQUARE_BIT(PIECES_PER_PLAYER) - 1;
+	for(uint32_t number = 0; number < set_count; number++) {
+		sets[number] = set;
+		is_line[number] = teeko_is_win(set);
+		Bitboard low = set & -set;
+		Bitboard ripple = set + low;
+		set = ripple | (((set ^ ripple) >> 2) / low);
+	}
+}
+
+/*
+ * One pass. Each thread takes the positions for one set of the mover's
+ * squares at a time. Results written in this pass are never the ones it
+ * reads (those are for fewer plies), but another thread may be writing
+ * the same byte, so the accesses are atomic.
+ */
+static uint8_t pass_plies;
+static uint32_t next_set;
+static uint64_t pass_found;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+// n if the position is won in n = 1 plies or lost in an even n, else 0
+static uint8_t solve(Bitboard mine, Bitboard theirs, uint8_t n) {
+	Bitboard empty = ALL_SQUARES & ~(mine | theirs);
+	uint32_t child_base = set_number(theirs) * rest_count;
+	uint8_t moves = 0;
+	for(Bitboard pieces = mine; pieces; pieces &= pieces - 1) {
+		uint8_t from = __builtin_ctzll(pieces);
+		Bitboard targets = teeko_neighbours(SQUARE_BIT(from)) & empty;
+		for(; targets; targets &= targets - 1) {
+			Bitboard moved = mine ^ SQUARE_BIT(from) ^ (targets & -targets);
+			if(n == 1) {
+				if(is_line[set_number(moved)]) {
+					return 1;
+				}
+				continue;
+			}
+			moves++;
+			uint8_t child = __atomic_load_n(&plies[child_base + rest_number(moved, theirs)],
+					__ATOMIC_RELAXED);
+			if(child % 2 == 0) {
+				// a move the other player doesn't win after
+				return 0;
+			}
+		}
+	}
+	// blocked in is a draw, not a loss
+	return (n > 1 && moves) ? n : 0;
+}
+
+// mark the unsolved positions before a position lost in n - 1 plies as
+// won in n, returns how many there were
+static uint32_t mark_won(Bitboard mine, Bitboard theirs, uint8_t n) {
+	Bitboard empty = ALL_SQUARES & ~(mine | theirs);
+	uint32_t marked = 0;
+	// the other player moved a piece to square, from one next to it
+	for(Bitboard pieces = theirs; pieces; pieces &= pieces - 1) {
+		Bitboard square = pieces & -pieces;
+		Bitboard sources = teeko_neighbours(square) & empty;
+		for(; sources; sources &= sources - 1) {
+			Bitboard before = theirs ^ square ^ (sources & -sources);
+			uint32_t number = set_number(before);
+			if(is_line[number]) {
+				// they had won already
+				continue;
+			}
+			uint8_t unsolved = 0;
+			marked += __atomic_compare_exchange_n(
+					&plies[number * rest_count + rest_number(mine, before)],
+					&unsolved, n, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+		}
+	}
+	return marked;
+}
+
+static void* pass_main(void* argument) {
+	(void)argument;
+	uint64_t found = 0;
+	for(;;) {
+		pthread_mutex_lock(&lock);
+		uint32_t my_number = next_set++;
+		pthread_mutex_unlock(&lock);
+		if(my_number >= set_count) {
+			break;
+		}
+		Bitboard mine = sets[my_number];
+		if(is_line[my_number]) {
+			continue;
+		}
+		for(uint32_t their_number = 0; their_number < set_count; their_number++) {
+			Bitboard theirs = sets[their_number];
+			if((theirs & mine) || is_line[their_number]) {
+				continue;
+			}
+			uint8_t* result = &plies[my_number * rest_count + rest_number(theirs, mine)];
+			uint8_t solved = __atomic_load_n(result, __ATOMIC_RELAXED);
+			if(pass_plies % 2 == 1 && pass_plies > 1) {
+				if(solved == pass_plies - 1) {
+					found += mark_won(mine, theirs, pass_plies);
+				}
+				continue;
+			}
+			if(solved) {
+				continue;
+			}
+			uint8_t n = solve(mine, theirs, pass_plies);
+			if(n) {
+				__atomic_store_n(result, n, __ATOMIC_RELAXED);
+				found++;
+			}
+		}
+	}
+	pthread_mutex_lock(&lock);
+	pass_found += found;
+	pthread_mutex_unlock(&lock);
+	return NULL;
+}
+
+static uint64_t run_pass(uint8_t n) {
+	pass_plies = n;
+	next_set = 0;
+	pass_found = 0;
+	pthread_t* threads = malloc(thread_count * sizeof(*threads));
+	for(unsigned t = 0; t < thread_count; t++) {
+		pthread_create(&threads[t], NULL, pass_main, NULL);
+	}
+	for(unsigned t = 0; t < thread_count; t++) {
+		pthread_join(threads[t], NULL);
+	}
+	free(threads);
+	return pass_found;
+}
+
+// mark the lost positions which can go in the table and count them by
+// plies
+static void find_canonical(uint32_t* counts) {
+	for(uint32_t my_number = 0; my_number < set_count; my_number++) {
+		Bitboard mine = sets[my_number];
+		for(uint32_t their_number = 0; their_number < set_count; their_number++) {
+			Bitboard theirs = sets[their_number];
+			if(theirs & mine) {
+				continue;
+			}
+			uint32_t index = my_number * rest_count + rest_number(theirs, mine);
+			if(plies[index] && plies[index] % 2 == 0 && endgame_key(mine, theirs) == index) {
+				counts[plies[index]]++;
+				plies[index] |= CANONICAL;
+			}
+		}
+	}
+}
+
+// the entries of each class of lost positions which fit in the table,
+// the furthest from the end first
+static uint32_t fit_entries(const uint32_t* counts, uint32_t* taken) {
+	uint32_t room = (max_bytes - filter_bytes) / ENTRY_SIZE;
+	uint32_t entries = 0;
+	for(uint8_t n = max_plies - max_plies % 2; n > 0; n -= 2) {
+		taken[n] = counts[n] < room - entries ? counts[n] : room - entries;
+		entries += taken[n];
+	}
+	return entries;
+}
+
+static int write_table(const uint32_t* counts, const uint32_t* taken, uint32_t entries) {
+	uint32_t* chosen = malloc(entries * sizeof(uint32_t));
+	uint8_t* filter = calloc(filter_bytes, 1);
+	uint32_t seen[ENDGAME_PLY_LIMIT] = { 0 };
+	uint32_t written = 0;
+	// in order of number, as the positions are numbered by the mover's
+	// set and then by the other player's
+	for(uint32_t my_number = 0; my_number < set_count; my_number++) {
+		Bitboard mine = sets[my_number];
+		for(uint32_t their_number = 0; their_number < set_count; their_number++) {
+			Bitboard theirs = sets[their_number];
+			if(theirs & mine) {
+				continue;
+			}
+			uint32_t index = my_number * rest_count + rest_number(theirs, mine);
+			if(!(plies[index] & CANONICAL)) {
+				continue;
+			}
+			// a class which doesn't all fit has every (counts / taken)th
+			// position taken
+			uint8_t n = plies[index] & ~CANONICAL;
+			uint64_t before = (uint64_t)seen[n] * taken[n] / counts[n];
+			seen[n]++;
+			if((uint64_t)seen[n] * taken[n] / counts[n] == before) {
+				continue;
+			}
+			uint16_t bit = endgame_signature(mine, theirs) % (filter_bytes * 8);
+			filter[bit / 8] |= 1 << (bit % 8);
+			chosen[written++] = index * ENDGAME_PLY_LIMIT + n;
+		}
+	}
+
+	FILE* file = strcmp(out_path, "-") == 0 ? stdout : fopen(out_path, "w");
+	if(!file) {
+		perror(out_path);
+		return 0;
+	}
+	fprintf(file, "/*\n"
+			" * endgame_table.h\n"
+			" *\n"
+			" * The endgame table (see endgame.h), kept in flash. Included once, by\n"
+			" * endgame.c. Written by build/gen_endgame --plies %u --bytes %u:\n"
+			" *\n", max_plies, max_bytes);
+	for(uint8_t n = 2; n <= max_plies; n += 2) {
+		fprintf(file, " *   lost in %u plies: %u of %u\n", n, taken[n], counts[n]);
+	}
+	uint32_t filter_set = 0;
+	for(uint32_t i = 0; i < filter_bytes; i++) {
+		filter_set += teeko_count(filter[i]);
+	}
+	fprintf(file, " *\n"
+			" * %u of the %u bits of the filter are set.\n"
+			" */\n"
+			"\n"
+			"#define ENDGAME_TABLE_WIDTH %u\n"
+			"#define ENDGAME_TABLE_HEIGHT %u\n"
+			"#define ENDGAME_TABLE_SQUARE_WINS %u\n"
+			"#define ENDGAME_TABLE_ENTRIES %u\n"
+			"#define ENDGAME_FILTER_BITS %u\n"
+			"\n"
+			"const uint8_t endgame_filter[ENDGAME_FILTER_BITS / 8] PROGMEM = {",
+			filter_set, filter_bytes * 8, WIDTH, HEIGHT, SQUARE_WINS, entries,
+			filter_bytes * 8);
+	for(uint32_t i = 0; i < filter_bytes; i++) {
+		fprintf(file, "%s0x%02x%s", i % 12 ? " " : "\n\t", filter[i],
+				i + 1 < filter_bytes ? "," : "");
+	}
+	fprintf(file, "\n};\n"
+			"\n"
+			"const uint32_t endgame_entries[ENDGAME_TABLE_ENTRIES] PROGMEM = {");
+	for(uint32_t i = 0; i < written; i++) {
+		fprintf(file, "%s0x%08x%s", i % 6 ? " " : "\n\t", chosen[i],
+				i + 1 < written ? "," : "");
+	}
+	fprintf(file, "\n};\n");
+	free(chosen);
+	free(filter);
+	return file == stdout ? fflush(file) == 0 : fclose(file) == 0;
+}
+
+static void usage(const char* program) {
+	fprintf(stderr, "usage: %s [options]\n"
+			"  --plies N      solve positions up to N plies from the end (default 8)\n"
+			"  --bytes N      flash for the table (default 4096)\n"
+			"  --filter-bytes N  of which for the filter (default 1024)\n"
+			"  --threads N    worker threads (default: one per core)\n"
+			"  --out FILE     write the table to FILE (default stdout)\n", program);
+}
+
+int main(int argc, char** argv) {
+	for(int i = 1; i < argc; i++) {
+		const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+		if(!value) {
+			usage(argv[0]);
+			return 2;
+		}
+		if(strcmp(argv[i], "--plies") == 0) {
+			max_plies = atoi(value);
+		} else if(strcmp(argv[i], "--bytes") == 0) {
+			max_bytes = strtoul(value, NULL, 10);
+		} else if(strcmp(argv[i], "--filter-bytes") == 0) {
+			filter_bytes = strtoul(value, NULL, 10);
+		} else if(strcmp(argv[i], "--threads") == 0) {
+			thread_count = atoi(value);
+		} else if(strcmp(argv[i], "--out") == 0) {
+			out_path = value;
+		} else {
+			usage(argv[0]);
+			return 2;
+		}
+		i++;
+	}
+	if(max_plies < 2 || max_plies >= ENDGAME_PLY_LIMIT || filter_bytes == 0 ||
+			filter_bytes > 8192 || filter_bytes + ENTRY_SIZE > max_bytes) {
+		usage(argv[0]);
+		return 2;
+	}
+	if(thread_count == 0) {
+		long cores = sysconf(_SC_NPROCESSORS_ONLN);
+		thread_count = cores > 0 ? cores : 1;
+	}
+
+	make_sets();
+	uint64_t positions = (uint64_t)set_count * rest_count;
+	if(positions * ENDGAME_PLY_LIMIT > UINT32_MAX) {
+		fprintf(stderr, "the %ux%u board has %llu positions, too many to number in a "
+				"32 bit entry with the plies (at most %u)\n", WIDTH, HEIGHT,
+				(unsigned long long)positions, UINT32_MAX / ENDGAME_PLY_LIMIT);
+		return 1;
+	}
+	plies = calloc(positions, 1);
+	if(!plies) {
+		perror("positions");
+		return 1;
+	}
+	// check the numbering against endgame_index()
+	for(uint32_t i = 0; i < 1000; i++) {
+		Bitboard mine = sets[(i * 7919u) % set_count];
+		Bitboard theirs = sets[(i * 104729u) % set_count] & ~mine;
+		if(teeko_count(theirs) == PIECES_PER_PLAYER &&
+				endgame_index(mine, theirs, 0) != set_number(mine) * rest_count +
+				rest_number(theirs, mine)) {
+			fprintf(stderr, "numbering doesn't match endgame_index()\n");
+			return 1;
+		}
+	}
+
+	for(uint8_t n = 1; n <= max_plies; n++) {
+		uint64_t start = now_us();
+		uint64_t found = run_pass(n);
+		fprintf(stderr, "%s in %2u plies: %10llu positions (%.1f s)\n",
+				n % 2 ? "won " : "lost", n, (unsigned long long)found,
+				(now_us() - start) / 1e6);
+	}
+
+	uint32_t counts[ENDGAME_PLY_LIMIT] = { 0 };
+	uint32_t taken[ENDGAME_PLY_LIMIT] = { 0 };
+	find_canonical(counts);
+	uint32_t entries = fit_entries(counts, taken);
+	for(uint8_t n = 2; n <= max_plies; n += 2) {
+		fprintf(stderr, "lost in %2u plies: %8u up to symmetry, %u in the table\n",
+				n, counts[n], taken[n]);
+	}
+	return write_table(counts, taken, entries) ? 0 : 1;
+}
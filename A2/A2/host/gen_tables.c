@@ -0,0 +1,304 @@
+/*
+ * gen_tables.c
+ *
+ * Generates the board tables (teeko_tables.h and teeko_tables.c) for a
+ * board size and rule set, as a build step. Everything the rules need to
+ * know about the board is worked out here, so the firmware and host tools
+ * only loop over tables and never test which rules are in use.
+ *
+ *     ./build/gen_tables --width 5 --height 5 --square-wins 1 --out DIR
+ *
+ * The tables for the default 5x5 board without square wins are checked
+ * in to tables/ for the Atmel Studio build ("make tables" regenerates
+ * them).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// a winning line is always 4 pieces, one for each piece a player has
+#define LINE_LENGTH 4
+// squares must fit in a 64 bit bitboard with a spare bit for ALL_SQUARES
+#define MAX_SQUARES 63
+#define MAX_LINES 512
+
+static int width = 5;
+static int height = 5;
+static int square_wins;
+
+static int num_lines;
+static uint8_t lines[MAX_LINES][LINE_LENGTH];
+
+static int square_at(int x, int y) {
+	return y * width + x;
+}
+
+// The shapes of the winning lines: the (x, y) offset of each square from
+// the first. Lines of every shape are added at every place they fit.
+#define NUM_LINE_SHAPES 4
+static const int8_t shapes[NUM_LINE_SHAPES + 1][LINE_LENGTH][2] = {
+	{{0, 0}, {1, 0}, {2, 0}, {3, 0}},	// rows
+	{{0, 0}, {0, 1}, {0, 2}, {0, 3}},	// columns
+	{{0, 0}, {1, 1}, {2, 2}, {3, 3}},	// diagonals
+	{{0, 0}, {1, -1}, {2, -2}, {3, -3}},	// and the other way
+	{{0, 0}, {1, 0}, {0, 1}, {1, 1}}	// 2x2 squares, with square wins
+};
+static int num_shapes;
+
+// add the lines of a shape wherever it fits on the board
+static void add_shape(int shape) {
+	for(int y = 0; y < height; y++) {
+		for(int x = 0; x < width; x++) {
+			int fits = 1;
+			for(int i = 0; i < LINE_LENGTH; i++) {
+				int sx = x + shapes[shape][i][0];
+				int sy = y + shapes[shape][i][1];
+				if(sx < 0 || sx >= width || sy < 0 || sy >= height) {
+					fits = 0;
+				}
+			}
+			if(!fits) {
+				continue;
+			}
+			for(int i = 0; i < LINE_LENGTH; i++) {
+				lines[num_lines][i] = square_at(x + shapes[shape][i][0],
+						y + shapes[shape][i][1]);
+			}
+			num_lines++;
+		}
+	}
+}
+
+static uint64_t line_mask(int line) {
+	uint64_t mask = 0;
+	for(int i = 0; i < LINE_LENGTH; i++) {
+		mask |= (uint64_t)1 << lines[line][i];
+	}
+	return mask;
+}
+
+static uint64_t neighbour_mask(int square) {
+	int x = square % width, y = square / width;
+	uint64_t mask = 0;
+	for(int ny = y - 1; ny <= y + 1; ny++) {
+		for(int nx = x - 1; nx <= x + 1; nx++) {
+			if(nx >= 0 && nx < width && ny >= 0 && ny < height &&
+					(nx != x || ny != y)) {
+				mask |= (uint64_t)1 << square_at(nx, ny);
+			}
+		}
+	}
+	return mask;
+}
+
+static FILE* open_output(const char* dir, const char* name) {
+	char path[4096];
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	FILE* file = fopen(path, "w");
+	if(!file) {
+		perror(path);
+		exit(1);
+	}
+	return file;
+}
+
+static void write_banner(FILE* file, const char* name) {
+	fprintf(file, "/*\n * %s\n *\n", name);
+	fprintf(file, " * Board tables for a %dx%d board %s square wins.\n", width,
+			height, square_wins ? "with" : "without");
+	fprintf(file, " * Generated by host/gen_tables.c, do not edit.\n */\n\n");
+}
+
+static void write_header(const char* dir, int bits, int max_square_lines) {
+	FILE* file = open_output(dir, "teeko_tables.h");
+	write_banner(file, "teeko_tables.h");
+	fprintf(file, "#ifndef TEEKO_TABLES_H_\n#define TEEKO_TABLES_H_\n\n");
+	fprintf(file, "#include <stdint.h>\n#include \"hal.h\"\n\n");
+	fprintf(file, "// board dimensions\n#define WIDTH %d\n#define HEIGHT %d\n"
+			"#define NUM_SQUARES %d\n\n", width, height, width * height);
+	fprintf(file, "// winning lines (4 in a row, and squares if SQUARE_WINS)\n"
+			"#define SQUARE_WINS %d\n#define POS_WINS %d\n\n", square_wins, num_lines);
+	fprintf(file, "// most winning lines through any one square\n"
+			"#define MAX_SQUARE_LINES %d\n\n", max_square_lines);
+	fprintf(file, "// shapes of winning line, and squares in each\n"
+			"#define NUM_WIN_SHAPES %d\n#define WIN_SHAPE_SQUARES %d\n\n",
+			num_shapes, LINE_LENGTH);
+
+	fprintf(file, "typedef uint%d_t Bitboard;\n\n", bits);
+	if(bits == 32) {
+		fprintf(file, "#define pgm_read_bitboard(addr) pgm_read_dword(addr)\n\n");
+	} else {
+		fprintf(file, "static inline Bitboard pgm_read_bitboard(const Bitboard* addr) {\n"
+				"\tconst uint32_t* half = (const uint32_t*)addr;\n"
+				"\treturn ((Bitboard)pgm_read_dword(half + 1) << 32) |"
+				" pgm_read_dword(half);\n}\n\n");
+	}
+
+	fprintf(file, "// Tables in flash (read them with pgm_read_byte/bitboard)\n\n");
+	fprintf(file, "// the squares of each winning line\n"
+			"extern const Bitboard win_masks[POS_WINS] PROGMEM;\n\n");
+	fprintf(file, "// the winning lines through each square (square_line_count[n]\n"
+			"// entries of square_lines[n] are used)\n"
+			"extern const uint8_t square_lines[NUM_SQUARES][MAX_SQUARE_LINES] PROGMEM;\n"
+			"extern const uint8_t square_line_count[NUM_SQUARES] PROGMEM;\n\n");
+	fprintf(file, "// the squares next to (including diagonally) each square\n"
+			"extern const Bitboard neighbour_masks[NUM_SQUARES] PROGMEM;\n\n");
+	fprintf(file, "// the x and y coordinates of each square\n"
+			"extern const uint8_t square_x[NUM_SQUARES] PROGMEM;\n"
+			"extern const uint8_t square_y[NUM_SQUARES] PROGMEM;\n\n");
+	fprintf(file, "// the (x, y) offset of each square of each shape of winning line\n"
+			"// from its first square, for finding lines with shifts of a whole\n"
+			"// bitboard\n"
+			"extern const int8_t win_shapes[NUM_WIN_SHAPES][WIN_SHAPE_SQUARES][2] PROGMEM;\n\n");
+	fprintf(file, "// C(n, k + 1), the number of sets of k + 1 squares below square n,\n"
+			"// for numbering sets of squares (see endgame.c)\n"
+			"extern const uint32_t set_numbers[WIN_SHAPE_SQUARES][NUM_SQUARES] PROGMEM;\n\n");
+	fprintf(file, "#endif /* TEEKO_TABLES_H_ */\n");
+	fclose(file);
+}
+
+static void write_bitboards(FILE* file, const char* name, const uint64_t* values,
+		int count, const char* size, int bits) {
+	fprintf(file, "const Bitboard %s[%s] PROGMEM = {", name, size);
+	for(int i = 0; i < count; i++) {
+		fprintf(file, "%s0x%0*llX,", (i % 4) ? " " : "\n\t", bits / 4,
+				(unsigned long long)values[i]);
+	}
+	fprintf(file, "\n};\n\n");
+}
+
+static void write_bytes(FILE* file, const char* name, const uint8_t* values,
+		int count, const char* size) {
+	fprintf(file, "const uint8_t %s[%s] PROGMEM = {", name, size);
+	for(int i = 0; i < count; i++) {
+		fprintf(file, "%s%d,", (i % 10) ? " " : "\n\t", values[i]);
+	}
+	fprintf(file, "\n};\n\n");
+}
+
+static void write_source(const char* dir, int bits, int max_square_lines,
+		uint8_t square_lines[][MAX_LINES], const uint8_t* square_line_count) {
+	int squares = width * height;
+	uint64_t masks[MAX_LINES];
+	uint64_t neighbours[MAX_SQUARES];
+	uint8_t xs[MAX_SQUARES], ys[MAX_SQUARES];
+	for(int m = 0; m < num_lines; m++) {
+		masks[m] = line_mask(m);
+	}
+	for(int n = 0; n < squares; n++) {
+		neighbours[n] = neighbour_mask(n);
+		xs[n] = n % width;
+		ys[n] = n / width;
+	}
+
+	FILE* file = open_output(dir, "teeko_tables.c");
+	write_banner(file, "teeko_tables.c");
+	fprintf(file, "#include \"teeko_tables.h\"\n\n");
+	write_bitboards(file, "win_masks", masks, num_lines, "POS_WINS", bits);
+
+	fprintf(file, "const uint8_t square_lines[NUM_SQUARES][MAX_SQUARE_LINES] PROGMEM = {\n");
+	for(int n = 0; n < squares; n++) {
+		fprintf(file, "\t{");
+		for(int i = 0; i < max_square_lines; i++) {
+			// unused entries are padding
+			fprintf(file, "%s%d", i ? ", " : "",
+					i < square_line_count[n] ? square_lines[n][i] : 0);
+		}
+		fprintf(file, "},\n");
+	}
+	fprintf(file, "};\n\n");
+
+	write_bytes(file, "square_line_count", square_line_count, squares, "NUM_SQUARES");
+	write_bitboards(file, "neighbour_masks", neighbours, squares, "NUM_SQUARES", bits);
+	write_bytes(file, "square_x", xs, squares, "NUM_SQUARES");
+	write_bytes(file, "square_y", ys, squares, "NUM_SQUARES");
+
+	fprintf(file, "const int8_t win_shapes[NUM_WIN_SHAPES][WIN_SHAPE_SQUARES][2] PROGMEM = {\n");
+	for(int shape = 0; shape < num_shapes; shape++) {
+		fprintf(file, "\t{");
+		for(int i = 0; i < LINE_LENGTH; i++) {
+			fprintf(file, "%s{%d, %d}", i ? ", " : "", shapes[shape][i][0],
+					shapes[shape][i][1]);
+		}
+		fprintf(file, "},\n");
+	}
+	fprintf(file, "};\n\n");
+
+	fprintf(file, "const uint32_t set_numbers[WIN_SHAPE_SQUARES][NUM_SQUARES] PROGMEM = {\n");
+	for(int k = 1; k <= LINE_LENGTH; k++) {
+		fprintf(file, "\t{");
+		for(int n = 0; n < squares; n++) {
+			// C(n, k) = n (n - 1) ... (n - k + 1) / k!, exact at each step
+			uint64_t number = 1;
+			for(int i = 1; i <= k; i++) {
+				number = n < k ? 0 : number * (n - k + i) / i;
+			}
+			fprintf(file, "%s%llu", (n == 0) ? "" : (n % 10) ? ", " : ",\n\t ",
+					(unsigned long long)number);
+		}
+		fprintf(file, "},\n");
+	}
+	fprintf(file, "};\n");
+	fclose(file);
+}
+
+static void usage(const char* program) {
+	fprintf(stderr, "usage: %s [--width N] [--height N] [--square-wins 0|1] --out DIR\n",
+			program);
+	exit(2);
+}
+
+int main(int argc, char** argv) {
+	const char* out = NULL;
+	for(int i = 1; i + 1 < argc; i += 2) {
+		if(strcmp(argv[i], "--width") == 0) {
+			width = atoi(argv[i + 1]);
+		} else if(strcmp(argv[i], "--height") == 0) {
+			height = atoi(argv[i + 1]);
+		} else if(strcmp(argv[i], "--square-wins") == 0) {
+			square_wins = atoi(argv[i + 1]);
+		} else if(strcmp(argv[i], "--out") == 0) {
+			out = argv[i + 1];
+		} else {
+			usage(argv[0]);
+		}
+	}
+	if(!out || argc % 2 == 0) {
+		usage(argv[0]);
+	}
+	if(width < LINE_LENGTH || height < LINE_LENGTH ||
+			width * height > MAX_SQUARES) {
+		fprintf(stderr, "%s: the board must be at least %dx%d and at most %d squares\n",
+				argv[0], LINE_LENGTH, LINE_LENGTH, MAX_SQUARES);
+		return 1;
+	}
+
+	num_shapes = square_wins ? NUM_LINE_SHAPES + 1 : NUM_LINE_SHAPES;
+	for(int shape = 0; shape < num_shapes; shape++) {
+		add_shape(shape);
+	}
+	if(num_lines > 255) {
+		fprintf(stderr, "%s: too many winning lines (%d)\n", argv[0], num_lines);
+		return 1;
+	}
+
+	static uint8_t square_lines[MAX_SQUARES][MAX_LINES];
+	uint8_t square_line_count[MAX_SQUARES] = {0};
+	int max_square_lines = 0;
+	for(int m = 0; m < num_lines; m++) {
+		for(int i = 0; i < LINE_LENGTH; i++) {
+			int n = lines[m][i];
+			square_lines[n][square_line_count[n]++] = m;
+			if(square_line_count[n] > max_square_lines) {
+				max_square_lines = square_line_count[n];
+			}
+		}
+	}
+
+	int bits = (width * height > 32) ? 64 : 32;
+	write_header(out, bits, max_square_lines);
+	write_source(out, bits, max_square_lines, square_lines, square_line_count);
+	return 0;
+}
@@ -0,0 +1,451 @@
+/*
+ * hal_host.c
+ *
+ * Native (Linux) implementation of the hardware abstraction layer, so the
+ * real game.c/display.c/terminalio.c code can be run, benchmarked and
+ * soak tested at host speed. Time, input and output come from a
+ * HostDriver (see hal_host.h); live.c has the interactive one.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#include "hal.h"
+#include "hal_host.h"
+
+/* The interrupt handlers defined with HAL_ISR() in the firmware */
+void hal_isr_USART_RX_vect(void);
+void hal_isr_USART_UDRE_vect(void);
+void hal_isr_PCINT1_vect(void);
+void hal_isr_TIMER0_COMPA_vect(void);
+void hal_isr_SPI_STC_vect(void);
+
+/* Simulated interrupt state. in_interrupt stops handlers being re-entered
+ * when they themselves enable interrupts.
+ */
+static uint8_t interrupts_on;
+static uint8_t in_interrupt;
+
+/* UART */
+static uint8_t uart_enabled;
+static uint64_t uart_byte_time_us;
+static uint64_t uart_next_rx_us;
+static uint8_t uart_tx_interrupt_on;
+static char uart_rx_register;
+#define RX_QUEUE_SIZE 4096
+static char rx_queue[RX_QUEUE_SIZE];
+static size_t rx_head, rx_count;
+#define TX_CHUNK_SIZE 512
+static char tx_chunk[TX_CHUNK_SIZE];
+static size_t tx_chunk_length;
+static uint64_t tx_total;
+
+/* Buttons - a queue of pin states still to be presented to the ISR */
+static uint8_t buttons_enabled;
+static uint8_t button_pin_state;
+#define PIN_QUEUE_SIZE 16
+static uint8_t pin_queue[PIN_QUEUE_SIZE];
+static uint8_t pin_head, pin_count;
+
+/* SPI - bytes are sent instantly, pending is set until the transfer
+ * complete interrupt has run
+ */
+static uint8_t spi_enabled;
+static uint8_t spi_pending;
+static uint64_t spi_total;
+
+/* Tone generator, changes are written to note_log */
+static FILE* note_log;
+static uint16_t tone_frequency;
+
+/* Link port, bytes go straight to and from link_fd (if it is set), with
+ * the outgoing ones dropped at random link_loss times in 1000
+ */
+static void (*link_received)(uint8_t);
+static int16_t (*link_next_byte)(void);
+static uint8_t link_tx_wanted;
+static uint8_t link_enabled = 1;
+static int link_fd = -1;
+static uint16_t link_loss;
+static uint32_t link_random = 1;
+
+/* Timer 0 */
+static uint8_t timer_running;
+static uint64_t timer_start_us;
+static uint64_t timer_ticks;
+
+/* EEPROM, optionally mirrored to a file */
+static uint8_t eeprom[HAL_EEPROM_SIZE];
+static uint8_t eeprom_erased;
+static int eeprom_fd = -1;
+
+static const HostDriver* driver;
+
+static void service_link(void);
+
+/*
+ * Interrupt simulation
+ */
+void hal_host_service(void) {
+	if(!interrupts_on || in_interrupt) {
+		return;
+	}
+	// handlers run with interrupts disabled, as on the AVR
+	in_interrupt = 1;
+	interrupts_on = 0;
+
+	driver->poll();
+
+	if(timer_running) {
+		uint64_t due = (driver->now_us() - timer_start_us) / 1000;
+		while(timer_ticks < due) {
+			timer_ticks++;
+			hal_isr_TIMER0_COMPA_vect();
+		}
+	}
+
+	// received bytes arrive no faster than the baud rate allows
+	if(uart_enabled && rx_count > 0 && driver->now_us() >= uart_next_rx_us) {
+		uart_next_rx_us = driver->now_us() + uart_byte_time_us;
+		uart_rx_register = rx_queue[rx_head];
+		rx_head = (rx_head + 1) % RX_QUEUE_SIZE;
+		rx_count--;
+		hal_isr_USART_RX_vect();
+	}
+
+	if(pin_count > 0) {
+		button_pin_state = pin_queue[pin_head];
+		pin_head = (pin_head + 1) % PIN_QUEUE_SIZE;
+		pin_count--;
+		if(buttons_enabled) {
+			hal_isr_PCINT1_vect();
+		}
+	}
+
+	// and so is the SPI, each byte's interrupt sends the next
+	while(spi_enabled && spi_pending) {
+		spi_pending = 0;
+		hal_isr_SPI_STC_vect();
+	}
+
+	if(link_received) {
+		service_link();
+	}
+
+	// the UART is infinitely fast, the whole buffer goes out at once
+	while(uart_tx_interrupt_on) {
+		hal_isr_USART_UDRE_vect();
+	}
+	if(tx_chunk_length > 0) {
+		driver->transmit(tx_chunk, tx_chunk_length);
+		tx_chunk_length = 0;
+	}
+
+	interrupts_on = 1;
+	in_interrupt = 0;
+}
+
+uint8_t hal_disable_interrupts(void) {
+	uint8_t were_enabled = interrupts_on;
+	interrupts_on = 0;
+	return were_enabled;
+}
+
+void hal_restore_interrupts(uint8_t were_enabled) {
+	if(were_enabled) {
+		hal_enable_interrupts();
+	}
+}
+
+uint8_t hal_interrupts_enabled(void) {
+	return interrupts_on;
+}
+
+void hal_enable_interrupts(void) {
+	interrupts_on = 1;
+	hal_host_service();
+}
+
+void hal_idle(void) {
+	hal_host_service();
+}
+
+/*
+ * UART
+ */
+void hal_uart_init(long baudrate) {
+	// 10 bits (start, 8 data, stop) per byte
+	uart_byte_time_us = 10000000 / baudrate;
+	uart_enabled = 1;
+}
+
+static ssize_t stream_write(void* cookie, const char* data, size_t length) {
+	int (*put_char)(char, FILE*) = ((int (**)(char, FILE*))cookie)[0];
+	for(size_t i = 0; i < length; i++) {
+		put_char(data[i], stdout);
+	}
+	return length;
+}
+
+static ssize_t stream_read(void* cookie, char* data, size_t length) {
+	int (*get_char)(FILE*) = ((int (**)(FILE*))cookie)[1];
+	if(length == 0) {
+		return 0;
+	}
+	data[0] = get_char(stdin);
+	return 1;
+}
+
+void hal_stdio_init(int (*put_char)(char, FILE*), int (*get_char)(FILE*)) {
+	static void* functions[2];
+	static const cookie_io_functions_t io = {
+		.read = stream_read,
+		.write = stream_write
+	};
+	functions[0] = (void*)put_char;
+	functions[1] = (void*)get_char;
+
+	FILE* stream = fopencookie(functions, "r+", io);
+	setvbuf(stream, NULL, _IONBF, 0);
+	stdout = stream;
+	stdin = stream;
+}
+
+char hal_uart_read_byte(void) {
+	return uart_rx_register;
+}
+
+void hal_uart_write_byte(char c) {
+	if(tx_chunk_length == TX_CHUNK_SIZE) {
+		driver->transmit(tx_chunk, tx_chunk_length);
+		tx_chunk_length = 0;
+	}
+	tx_chunk[tx_chunk_length++] = c;
+	tx_total++;
+}
+
+void hal_uart_tx_interrupt(uint8_t enable) {
+	uart_tx_interrupt_on = enable;
+}
+
+/*
+ * Buttons
+ */
+void hal_buttons_init(void) {
+	buttons_enabled = 1;
+}
+
+uint8_t hal_button_pins(void) {
+	return button_pin_state;
+}
+
+/*
+ * Tone generator
+ */
+void hal_tone_init(void) {
+	tone_frequency = 0;
+}
+
+void hal_tone(uint16_t frequency) {
+	if(frequency == tone_frequency) {
+		return;
+	}
+	tone_frequency = frequency;
+	if(note_log) {
+		fprintf(note_log, "%llu %u\n", (unsigned long long)timer_ticks, frequency);
+	}
+}
+
+/*
+ * SPI
+ */
+void hal_spi_init(void) {
+	spi_enabled = 1;
+}
+
+void hal_spi_write_byte(uint8_t byte) {
+	(void)byte;
+	spi_total++;
+	spi_pending = 1;
+}
+
+/*
+ * Link port
+ */
+void hal_link_init(void (*received)(uint8_t byte), int16_t (*next_byte)(void)) {
+	link_received = received;
+	link_next_byte = next_byte;
+}
+
+void hal_link_start(void) {
+	link_tx_wanted = 1;
+}
+
+void hal_link_enable(uint8_t on) {
+	link_enabled = on;
+}
+
+static uint8_t link_lost(void) {
+	link_random ^= link_random << 13;
+	link_random ^= link_random >> 17;
+	link_random ^= link_random << 5;
+	return link_random % 1000 < link_loss;
+}
+
+static void service_link(void) {
+	uint8_t buffer[64];
+	ssize_t n = link_fd >= 0 ? read(link_fd, buffer, sizeof(buffer)) : 0;
+	if(!link_enabled) {
+		// as on the AVR, what arrives while the port is off is lost
+		return;
+	}
+	for(ssize_t i = 0; i < n; i++) {
+		link_received(buffer[i]);
+	}
+
+	size_t length = 0;
+	while(link_tx_wanted && length < sizeof(buffer)) {
+		int16_t next = link_next_byte();
+		if(next < 0) {
+			link_tx_wanted = 0;
+		} else if(!link_lost()) {
+			buffer[length++] = next;
+		}
+	}
+	if(link_fd >= 0 && length > 0 && write(link_fd, buffer, length) < 0 && errno != EAGAIN) {
+		perror("link");
+	}
+}
+
+/*
+ * Timer 0
+ */
+void hal_timer0_init(void) {
+	timer_start_us = driver->now_us();
+	timer_ticks = 0;
+	timer_running = 1;
+}
+
+// the count goes on with the driver's clock, but wraps only when the
+// tick has been simulated
+uint8_t hal_timer0_count(void) {
+	uint64_t elapsed = driver->now_us() - timer_start_us - timer_ticks * 1000;
+	return elapsed >= 1000 ? 249 : elapsed / 4;
+}
+
+uint8_t hal_timer0_tick_pending(void) {
+	return 0;
+}
+
+/*
+ * Stack, which there is no telling on the host
+ */
+uint16_t hal_stack_unused(void) {
+	return HAL_STACK_UNKNOWN;
+}
+
+/*
+ * EEPROM
+ */
+static void erase_eeprom(void) {
+	if(!eeprom_erased) {
+		memset(eeprom, 0xFF, sizeof(eeprom));
+		eeprom_erased = 1;
+	}
+}
+
+uint8_t hal_eeprom_read(uint16_t address) {
+	erase_eeprom();
+	return eeprom[address % HAL_EEPROM_SIZE];
+}
+
+uint8_t hal_eeprom_ready(void) {
+	return 1;
+}
+
+void hal_eeprom_write(uint16_t address, uint8_t value) {
+	erase_eeprom();
+	address %= HAL_EEPROM_SIZE;
+	eeprom[address] = value;
+	if(eeprom_fd >= 0 && pwrite(eeprom_fd, &value, 1, address) != 1) {
+		perror("eeprom");
+	}
+}
+
+/*
+ * Host interface
+ */
+int hal_host_eeprom_file(const char* path) {
+	eeprom_fd = open(path, O_RDWR | O_CREAT, 0644);
+	if(eeprom_fd < 0) {
+		perror(path);
+		return -1;
+	}
+	erase_eeprom();
+	if(pread(eeprom_fd, eeprom, sizeof(eeprom), 0) != sizeof(eeprom)) {
+		// new (or short) file, start from erased
+		memset(eeprom, 0xFF, sizeof(eeprom));
+		if(pwrite(eeprom_fd, eeprom, sizeof(eeprom), 0) != sizeof(eeprom)) {
+			perror(path);
+			return -1;
+		}
+	}
+	return 0;
+}
+int hal_host_link_fd(int fd, uint16_t loss) {
+	int flags = fcntl(fd, F_GETFL);
+	if(flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+		perror("link");
+		return -1;
+	}
+	link_fd = fd;
+	link_loss = loss;
+	return 0;
+}
+
+void hal_host_set_driver(const HostDriver* new_driver) {
+	driver = new_driver;
+}
+
+void hal_host_rx(char c) {
+	if(rx_count < RX_QUEUE_SIZE) {
+		rx_queue[(rx_head + rx_count) % RX_QUEUE_SIZE] = c;
+		rx_count++;
+	}
+}
+
+size_t hal_host_rx_pending(void) {
+	return rx_count;
+}
+
+void hal_host_set_buttons(uint8_t pins) {
+	if(pin_count < PIN_QUEUE_SIZE) {
+		pin_queue[(pin_head + pin_count) % PIN_QUEUE_SIZE] = pins & 0x0F;
+		pin_count++;
+	}
+}
+
+uint8_t hal_host_tx_idle(void) {
+	return !uart_tx_interrupt_on && tx_chunk_length == 0;
+}
+
+uint64_t hal_host_tx_count(void) {
+	return tx_total;
+}
+
+void hal_host_note_log(FILE* file) {
+	note_log = file;
+}
+
+uint64_t hal_host_spi_count(void) {
+	return spi_total;
+}
+
+uint64_t hal_host_uart_byte_us(void) {
+	return uart_byte_time_us;
+}
@@ -0,0 +1,94 @@
+/*
+ * hal_host.h
+ *
+ * Extra interface of the native (Linux) hardware abstraction layer. The
+ * firmware only ever sees hal.h; this file is for host programs (the
+ * replay driver, benchmarks, ...) which need to feed input into the
+ * simulated hardware and watch its output.
+ *
+ * Interrupts are simulated on a single thread. Whenever the firmware
+ * re-enables interrupts (hal_restore_interrupts(), hal_enable_interrupts())
+ * or waits in hal_idle(), pending "interrupts" are run: timer ticks up to
+ * the driver's clock, one received byte, one button change, the whole
+ * of the transmit buffer, any SPI transfer and the link port. This keeps
+ * runs deterministic for a given sequence of driver calls.
+ */
+
+#ifndef HAL_HOST_H_
+#define HAL_HOST_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/* A driver supplies the time and input and consumes the output of the
+ * simulated hardware. There is no default: each host program sets its own
+ * (live.c for the terminal or pty, replay.c for captures) with
+ * hal_host_set_driver() before anything else.
+ */
+typedef struct {
+	// current time in microseconds, must never go backwards
+	uint64_t (*now_us)(void);
+	// called at each interrupt point before interrupts are simulated,
+	// input is supplied through hal_host_rx() and hal_host_set_buttons()
+	void (*poll)(void);
+	// called with bytes transmitted by the UART
+	void (*transmit)(const char* data, size_t length);
+} HostDriver;
+
+/* Set the driver, call before firmware_main() */
+void hal_host_set_driver(const HostDriver* driver);
+
+/* Queue a byte for the UART to receive. Bytes are delivered to the
+ * receive interrupt one per interrupt point, and no faster than the
+ * baud rate given to hal_uart_init() allows.
+ */
+void hal_host_rx(char c);
+
+/* Number of bytes queued with hal_host_rx() not yet delivered */
+size_t hal_host_rx_pending(void);
+
+/* Change the state of button pins C0 to C3 (bit n is button n). Each
+ * change raises one pin change interrupt.
+ */
+void hal_host_set_buttons(uint8_t pins);
+
+/* Non-zero if the UART has nothing left to transmit */
+uint8_t hal_host_tx_idle(void);
+
+/* Total number of bytes transmitted by the UART since start up */
+uint64_t hal_host_tx_count(void);
+
+/* Write each change of the buzzer's tone to file as a line "<ms> <Hz>",
+ * where ms is timer 0's tick count and 0 Hz is silence. The log of a
+ * replayed capture can be compared with a recorded one.
+ */
+void hal_host_note_log(FILE* file);
+
+/* Total number of bytes sent over the SPI (to the LED matrix) */
+uint64_t hal_host_spi_count(void);
+
+/* Time the real UART takes to send or receive one byte at the baud rate
+ * given to hal_uart_init()
+ */
+uint64_t hal_host_uart_byte_us(void);
+
+/* Keep the EEPROM in the given file (created erased if it doesn't exist)
+ * rather than in memory, so it survives from run to run.
+ */
+int hal_host_eeprom_file(const char* path);
+
+/* Connect the link port to fd (a socket, pipe or pty, made non-blocking)
+ * which goes to another instance of the firmware. Bytes sent are lost
+ * at random loss times in 1000, to try out the link's retransmission.
+ * Without a file the link port's output goes nowhere.
+ */
+int hal_host_link_fd(int fd, uint16_t loss);
+
+/* Run any pending interrupts now (as if interrupts were briefly enabled) */
+void hal_host_service(void);
+
+/* The firmware's main(), renamed by the host build */
+int firmware_main(void);
+
+#endif /* HAL_HOST_H_ */
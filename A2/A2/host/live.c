@@ -0,0 +1,255 @@
+/*
+ * live.c
+ *
+ * Interactive driver for the native build of the firmware.
+ *
+ * Serial input comes from stdin and output goes to stdout (or both go to
+ * a pseudo terminal with --pty). The keys 0 to 3 are taken as pushes of
+ * buttons B0 to B3 rather than serial input. Time comes from the monotonic
+ * clock. When stdin is not a terminal the program exits once input is
+ * exhausted and output has been idle for a short while, so
+ *     ./build/teeko < keys.txt > screen.txt
+ * runs a scripted game. With --record the input is also written to a
+ * capture file (see capture.h) for build/replay to play back.
+ *
+ * The link port (for a game between two boards) can be joined to another
+ * instance through a pseudo terminal,
+ *     ./build/teeko --link-pty           prints "link port on /dev/pts/N"
+ *     ./build/teeko --link /dev/pts/N    in a second terminal
+ * or through a socket pair set up by whatever starts the two (--link-fd).
+ * With --position the position is printed to stderr on exit, for
+ * host/check_link.c to compare the two boards.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "hal_host.h"
+#include "capture.h"
+#include "game.h"
+
+static int in_fd = STDIN_FILENO;
+static int out_fd = STDOUT_FILENO;
+static uint8_t input_ended;
+static uint64_t last_activity_us;
+static struct termios saved_termios;
+static uint8_t termios_saved;
+
+// how long buttons stay down for a key press, and how long output must
+// be idle after the end of (non terminal) input before we exit
+#define LIVE_BUTTON_HOLD_US 50000
+#define LIVE_EXIT_IDLE_US 100000
+static uint64_t button_release_us;
+
+// capture file being recorded (if any) and the time recording started
+static FILE* record_file;
+static uint64_t start_us;
+static uint8_t print_position;
+
+static uint64_t monotonic_us(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+static void record(uint64_t now, char type, uint8_t value) {
+	if(record_file) {
+		CaptureEvent event = { now - start_us, type, value };
+		capture_write(record_file, &event);
+	}
+}
+
+static void live_poll(void) {
+	uint64_t now = monotonic_us();
+
+	if(button_release_us && now >= button_release_us) {
+		hal_host_set_buttons(0);
+		record(now, CAPTURE_BUTTONS, 0);
+		button_release_us = 0;
+	}
+
+	if(!input_ended && hal_host_rx_pending() == 0) {
+		struct pollfd pfd = { .fd = in_fd, .events = POLLIN };
+		if(poll(&pfd, 1, 0) > 0) {
+			char buffer[64];
+			ssize_t n = read(in_fd, buffer, sizeof(buffer));
+			if(n <= 0) {
+				if(n == 0 || (errno != EAGAIN && errno != EINTR)) {
+					input_ended = 1;
+				}
+			}
+			for(ssize_t i = 0; i < n; i++) {
+				if(buffer[i] >= '0' && buffer[i] <= '3') {
+					// a button push, held down for a short time
+					hal_host_set_buttons(1 << (buffer[i] - '0'));
+					record(now, CAPTURE_BUTTONS, 1 << (buffer[i] - '0'));
+					button_release_us = now + LIVE_BUTTON_HOLD_US;
+				} else {
+					hal_host_rx(buffer[i]);
+					record(now, CAPTURE_SERIAL, buffer[i]);
+				}
+			}
+			last_activity_us = now;
+		}
+	}
+
+	if(input_ended && !isatty(in_fd) && hal_host_rx_pending() == 0) {
+		if(!hal_host_tx_idle()) {
+			last_activity_us = now;
+		} else if(now - last_activity_us > LIVE_EXIT_IDLE_US) {
+			exit(0);
+		}
+	}
+}
+
+static void live_transmit(const char* data, size_t length) {
+	while(length > 0) {
+		ssize_t n = write(out_fd, data, length);
+		if(n < 0) {
+			if(errno == EINTR || errno == EAGAIN) {
+				continue;
+			}
+			exit(1);
+		}
+		data += n;
+		length -= n;
+	}
+	last_activity_us = monotonic_us();
+}
+
+static const HostDriver live_driver = {
+	.now_us = monotonic_us,
+	.poll = live_poll,
+	.transmit = live_transmit
+};
+
+static void restore_terminal(void) {
+	static const char reset[] = "\x1b[0m\x1b[?25h\r\n";
+	if(write(out_fd, reset, sizeof(reset) - 1) < 0) {
+		// nothing we can do
+	}
+	if(termios_saved) {
+		tcsetattr(in_fd, TCSANOW, &saved_termios);
+	}
+	if(print_position) {
+		const Position* position = game_position();
+		fprintf(stderr, "position %llx %llx %u %u\n",
+				(unsigned long long)position->pieces[0],
+				(unsigned long long)position->pieces[1], position->to_move,
+				position->placed);
+	}
+}
+
+/* Put the terminal into raw mode (no echo, no line buffering) so it
+ * behaves like a serial terminal. Ctrl-C still exits.
+ */
+static void raw_terminal(void) {
+	struct termios t;
+	if(tcgetattr(in_fd, &saved_termios) != 0) {
+		return;
+	}
+	termios_saved = 1;
+	t = saved_termios;
+	t.c_iflag &= ~(ICRNL | IXON);
+	t.c_lflag &= ~(ICANON | ECHO);
+	t.c_cc[VMIN] = 1;
+	t.c_cc[VTIME] = 0;
+	tcsetattr(in_fd, TCSANOW, &t);
+}
+
+static int open_pty(const char* name) {
+	int fd = posix_openpt(O_RDWR | O_NOCTTY);
+	if(fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) {
+		perror("pty");
+		exit(1);
+	}
+	fprintf(stderr, "%s on %s\n", name, ptsname(fd));
+	return fd;
+}
+
+/* Bytes on the link are binary, so a terminal carrying them must pass
+ * them through untouched
+ */
+static int open_link(const char* path) {
+	int fd = open(path, O_RDWR | O_NOCTTY);
+	if(fd < 0) {
+		perror(path);
+		exit(1);
+	}
+	struct termios t;
+	if(tcgetattr(fd, &t) == 0) {
+		cfmakeraw(&t);
+		tcsetattr(fd, TCSANOW, &t);
+	}
+	return fd;
+}
+
+
+static void usage(const char* program) {
+	fprintf(stderr, "usage: %s [--pty] [--record FILE] [--eeprom FILE] [--link-pty]\n"
+			"          [--link PATH] [--link-fd FD] [--link-loss N] [--position]\n"
+			"  --pty            use a pseudo terminal for the serial port\n"
+			"  --record FILE    write the input to a capture file\n"
+			"  --eeprom FILE    keep the EEPROM in FILE between runs\n"
+			"  --link-pty       make a pseudo terminal for the link port\n"
+			"  --link PATH      join the link port to a terminal (or FIFO)\n"
+			"  --link-fd FD     join the link port to an open file descriptor\n"
+			"  --link-loss N    lose N in 1000 bytes sent over the link\n"
+			"  --position       print the position to stderr on exit\n"
+			"keys 0-3 push buttons B0-B3, everything else is serial input\n",
+			program);
+}
+
+int main(int argc, char** argv) {
+	int link_fd = -1;
+	int link_loss = 0;
+	for(int i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--pty") == 0) {
+			in_fd = out_fd = open_pty("serial port");
+		} else if(strcmp(argv[i], "--link-pty") == 0) {
+			link_fd = open_pty("link port");
+		} else if(strcmp(argv[i], "--link") == 0 && i + 1 < argc) {
+			link_fd = open_link(argv[++i]);
+		} else if(strcmp(argv[i], "--link-fd") == 0 && i + 1 < argc) {
+			link_fd = atoi(argv[++i]);
+		} else if(strcmp(argv[i], "--link-loss") == 0 && i + 1 < argc) {
+			link_loss = atoi(argv[++i]);
+		} else if(strcmp(argv[i], "--position") == 0) {
+			print_position = 1;
+		} else if(strcmp(argv[i], "--eeprom") == 0 && i + 1 < argc) {
+			if(hal_host_eeprom_file(argv[++i]) != 0) {
+				return 1;
+			}
+		} else if(strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+			record_file = fopen(argv[++i], "w");
+			if(!record_file) {
+				perror(argv[i]);
+				return 1;
+			}
+		} else {
+			usage(argv[0]);
+			return 2;
+		}
+	}
+
+	if(link_fd >= 0 && hal_host_link_fd(link_fd, link_loss) != 0) {
+		return 1;
+	}
+
+	if(isatty(in_fd)) {
+		raw_terminal();
+	}
+	atexit(restore_terminal);
+
+	start_us = last_activity_us = monotonic_us();
+	hal_host_set_driver(&live_driver);
+	return firmware_main();
+}
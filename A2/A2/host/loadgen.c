@@ -0,0 +1,352 @@
+/*
+ * loadgen.c
+ *
+ * Load generator for the game server (server.c). A number of active
+ * sessions play random games as fast as the server answers, each waiting
+ * for the answer to one move before sending the next, while any number of
+ * idle sessions start a game and then sit there. The time from sending a
+ * move until it is the session's turn again (after the computer's reply,
+ * in games against it) is recorded, and the percentiles reported.
+ *
+ *     ./build/loadgen --sessions 200 --idle 20000 --seconds 10 --engine
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "teeko.h"
+#include "protocol.h"
+#include "random.h"
+
+// a game with no winner after this many plies is abandoned
+#define MAX_PLIES 200
+
+typedef struct {
+	int fd;
+	uint8_t waiting;	// for the answer to a move
+	uint8_t started;	// a new game has just started
+	uint8_t game_over;
+	uint8_t partial;	// bytes of a frame received so far
+	uint8_t first;
+	uint16_t plies;
+	uint32_t random_state;
+	uint64_t sent_us;
+	Position position;
+} Client;
+
+typedef struct {
+	pthread_t thread;
+	Client* clients;
+	unsigned client_count;
+	uint32_t* samples;	// move latencies in microseconds
+	size_t sample_count, sample_capacity;
+	uint64_t games, errors;
+} Driver;
+
+/* Options */
+static int port = DEFAULT_PORT;
+static const char* unix_path;
+static unsigned session_count = 100;
+static unsigned idle_count;
+static unsigned thread_count = 2;
+static unsigned seconds = 5;
+static uint8_t mode = MODE_HUMAN;
+
+static uint64_t deadline_us;
+
+static uint64_t now_us(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+static int connect_to_server(void) {
+	int fd;
+	if(unix_path) {
+		struct sockaddr_un address = { .sun_family = AF_UNIX };
+		strncpy(address.sun_path, unix_path, sizeof(address.sun_path) - 1);
+		fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if(fd >= 0 && connect(fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+			close(fd);
+			return -1;
+		}
+	} else {
+		struct sockaddr_in address = {
+			.sin_family = AF_INET,
+			.sin_port = htons(port),
+			.sin_addr.s_addr = htonl(INADDR_LOOPBACK)
+		};
+		fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if(fd >= 0 && connect(fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+			close(fd);
+			return -1;
+		}
+		int one = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	}
+	return fd;
+}
+
+static int send_frame(Client* client, uint8_t first, uint8_t second) {
+	uint8_t frame[FRAME_SIZE] = { first, second };
+	return send(client->fd, frame, FRAME_SIZE, MSG_NOSIGNAL) == FRAME_SIZE;
+}
+
+static void add_sample(Driver* driver, uint32_t latency) {
+	if(driver->sample_count == driver->sample_capacity) {
+		driver->sample_capacity = driver->sample_capacity ? 2 * driver->sample_capacity : 65536;
+		driver->samples = realloc(driver->samples,
+				driver->sample_capacity * sizeof(uint32_t));
+	}
+	driver->samples[driver->sample_count++] = latency;
+}
+
+// a random legal move for the player to move
+static int send_move(Client* client) {
+	Move moves[MAX_MOVES];
+	uint8_t count = teeko_generate_moves(&client->position, moves);
+	Move move = moves[next_random(&client->random_state) % count];
+	client->waiting = 1;
+	client->sent_us = now_us();
+	return send_frame(client, MOVE_FROM(move), MOVE_TO(move));
+}
+
+// handle one frame from the server, returns 0 on an error
+static int receive_frame(Driver* driver, Client* client, uint8_t first, uint8_t second) {
+	if(first == FRAME_NEW_GAME) {
+		teeko_init(&client->position);
+		client->started = 1;
+		client->game_over = 0;
+		client->plies = 0;
+	} else if(first == FRAME_ERROR) {
+		driver->errors++;
+		return 0;
+	} else if(first == FRAME_GAME_OVER) {
+		client->game_over = 1;
+	} else {
+		teeko_make(&client->position, MAKE_MOVE(first, second));
+		client->plies++;
+	}
+	return 1;
+}
+
+// after the answer to a move, record how long it took and carry on
+static int answered(Driver* driver, Client* client) {
+	if(client->started && !client->partial) {
+		client->started = 0;
+		return send_move(client);
+	}
+	uint8_t my_turn = mode == MODE_HUMAN || client->position.to_move == PLAYER_1;
+	if(!client->waiting || client->partial || !(client->game_over || my_turn)) {
+		return 1;	// more to come
+	}
+	client->waiting = 0;
+	add_sample(driver, now_us() - client->sent_us);
+	if(now_us() >= deadline_us) {
+		return 1;
+	}
+	if(client->game_over || client->plies >= MAX_PLIES) {
+		driver->games++;
+		return send_frame(client, FRAME_NEW_GAME, mode);
+	}
+	return send_move(client);
+}
+
+static void* driver_main(void* argument) {
+	Driver* driver = argument;
+	int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	for(unsigned i = 0; i < driver->client_count; i++) {
+		Client* client = &driver->clients[i];
+		struct epoll_event event = { .events = EPOLLIN, .data.ptr = client };
+		epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client->fd, &event);
+		send_frame(client, FRAME_NEW_GAME, mode);
+	}
+
+	struct epoll_event events[64];
+	while(now_us() < deadline_us) {
+		int count = epoll_wait(epoll_fd, events, 64, 100);
+		for(int i = 0; i < count; i++) {
+			Client* client = events[i].data.ptr;
+			uint8_t input[256];
+			ssize_t received = recv(client->fd, input, sizeof(input), MSG_DONTWAIT);
+			if(received <= 0) {
+				if(received < 0 && errno == EAGAIN) {
+					continue;
+				}
+				fprintf(stderr, "server closed a session\n");
+				epoll_ctl(epoll_fd, EPOLL_CTL_DEL, client->fd, NULL);
+				continue;
+			}
+			int ok = 1;
+			for(ssize_t j = 0; j < received && ok; j++) {
+				if(!client->partial) {
+					client->first = input[j];
+					client->partial = 1;
+				} else {
+					client->partial = 0;
+					ok = receive_frame(driver, client, client->first, input[j]);
+				}
+			}
+			if(!ok || !answered(driver, client)) {
+				// start again with a new game
+				client->waiting = 0;
+				client->partial = 0;
+				send_frame(client, FRAME_NEW_GAME, mode);
+			}
+		}
+	}
+	close(epoll_fd);
+	return NULL;
+}
+
+static void raise_file_limit(void) {
+	struct rlimit limit;
+	if(getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+}
+
+static int compare_samples(const void* a, const void* b) {
+	uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+	return (x > y) - (x < y);
+}
+
+static uint32_t percentile(const uint32_t* samples, size_t count, double p) {
+	size_t index = (size_t)(p / 100 * (count - 1) + 0.5);
+	return samples[index];
+}
+
+static void usage(const char* program) {
+	fprintf(stderr, "usage: %s [options]\n"
+			"  --port N       server's TCP port on 127.0.0.1 (default %d)\n"
+			"  --unix PATH    connect to a Unix socket instead\n"
+			"  --sessions N   sessions playing games (default 100)\n"
+			"  --idle N       sessions which start a game and wait (default 0)\n"
+			"  --threads N    threads driving the active sessions (default 2)\n"
+			"  --seconds N    how long to run (default 5)\n"
+			"  --engine       play against the computer (default: both sides)\n",
+			program, DEFAULT_PORT);
+}
+
+int main(int argc, char** argv) {
+	for(int i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--engine") == 0) {
+			mode = MODE_ENGINE;
+			continue;
+		}
+		const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+		if(!value) {
+			usage(argv[0]);
+			return 2;
+		}
+		if(strcmp(argv[i], "--port") == 0) {
+			port = atoi(value);
+		} else if(strcmp(argv[i], "--unix") == 0) {
+			unix_path = value;
+		} else if(strcmp(argv[i], "--sessions") == 0) {
+			session_count = atoi(value);
+		} else if(strcmp(argv[i], "--idle") == 0) {
+			idle_count = atoi(value);
+		} else if(strcmp(argv[i], "--threads") == 0) {
+			thread_count = atoi(value);
+		} else if(strcmp(argv[i], "--seconds") == 0) {
+			seconds = atoi(value);
+		} else {
+			usage(argv[0]);
+			return 2;
+		}
+		i++;
+	}
+	if(thread_count == 0 || session_count < thread_count) {
+		usage(argv[0]);
+		return 2;
+	}
+	raise_file_limit();
+
+	// the idle sessions each start a game and are never heard from again
+	int* idle = malloc((idle_count + 1) * sizeof(int));
+	for(unsigned i = 0; i < idle_count; i++) {
+		idle[i] = connect_to_server();
+		uint8_t frame[FRAME_SIZE] = { FRAME_NEW_GAME, mode };
+		if(idle[i] < 0 || send(idle[i], frame, FRAME_SIZE, MSG_NOSIGNAL) != FRAME_SIZE) {
+			perror("idle session");
+			return 1;
+		}
+	}
+
+	Client* clients = calloc(session_count, sizeof(Client));
+	for(unsigned i = 0; i < session_count; i++) {
+		clients[i].fd = connect_to_server();
+		clients[i].random_state = (i + 1) * 2654435761u | 1;
+		if(clients[i].fd < 0) {
+			perror("session");
+			return 1;
+		}
+	}
+
+	deadline_us = now_us() + seconds * 1000000ull;
+	Driver* drivers = calloc(thread_count, sizeof(Driver));
+	for(unsigned t = 0; t < thread_count; t++) {
+		// share the sessions out evenly
+		unsigned first = session_count * t / thread_count;
+		unsigned last = session_count * (t + 1) / thread_count;
+		drivers[t].clients = clients + first;
+		drivers[t].client_count = last - first;
+		pthread_create(&drivers[t].thread, NULL, driver_main, &drivers[t]);
+	}
+
+	size_t total = 0;
+	uint64_t games = 0, errors = 0;
+	for(unsigned t = 0; t < thread_count; t++) {
+		pthread_join(drivers[t].thread, NULL);
+		total += drivers[t].sample_count;
+		games += drivers[t].games;
+		errors += drivers[t].errors;
+	}
+	uint32_t* samples = malloc((total + 1) * sizeof(uint32_t));
+	size_t count = 0;
+	for(unsigned t = 0; t < thread_count; t++) {
+		memcpy(samples + count, drivers[t].samples, drivers[t].sample_count * sizeof(uint32_t));
+		count += drivers[t].sample_count;
+		free(drivers[t].samples);
+	}
+	qsort(samples, count, sizeof(uint32_t), compare_samples);
+
+	printf("%u active and %u idle sessions, %s, %u s\n", session_count, idle_count,
+			mode == MODE_ENGINE ? "against the computer" : "both sides", seconds);
+	printf("moves %zu (%.0f/s), games %llu, errors %llu\n", count,
+			(double)count / seconds, (unsigned long long)games,
+			(unsigned long long)errors);
+	if(count) {
+		printf("latency us: p50 %u  p90 %u  p99 %u  p99.9 %u  max %u\n",
+				percentile(samples, count, 50), percentile(samples, count, 90),
+				percentile(samples, count, 99), percentile(samples, count, 99.9),
+				samples[count - 1]);
+	}
+
+	for(unsigned i = 0; i < session_count; i++) {
+		close(clients[i].fd);
+	}
+	for(unsigned i = 0; i < idle_count; i++) {
+		close(idle[i]);
+	}
+	free(samples);
+	free(clients);
+	free(drivers);
+	free(idle);
+	return errors != 0;
+}
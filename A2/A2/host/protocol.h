@@ -0,0 +1,52 @@
+/*
+ * protocol.h
+ *
+ * The binary protocol spoken by the game server (server.c) and the load
+ * generator (loadgen.c). Every message either way is a 2-byte frame, so
+ * there is no framing to parse and a session buffers at most one byte of
+ * a partial frame.
+ *
+ * A move is sent as its 2-byte Move (teeko.h), high byte first: the
+ * square moved from (MOVE_PLACE for a placement) then the square moved
+ * to. The other frames start with a byte which is never a square.
+ *
+ * Client to server:
+ *     FRAME_NEW_GAME mode    start a game, MODE_HUMAN for two players at
+ *                            one client or MODE_ENGINE to play player 1
+ *                            against the computer
+ *     from to                make a move for the player to move
+ *
+ * Server to client:
+ *     FRAME_NEW_GAME mode    the game has started
+ *     from to                a move was made (the client's own, then the
+ *                            computer's reply in MODE_ENGINE)
+ *     FRAME_ERROR code       the request was refused, nothing changed
+ *     FRAME_GAME_OVER winner sent after the winning move
+ *
+ * A client sends one request at a time and reads the whole answer before
+ * sending the next; the server may drop clients which don't.
+ */
+
+#ifndef PROTOCOL_H_
+#define PROTOCOL_H_
+
+#define FRAME_SIZE 2
+
+#define FRAME_NEW_GAME 0xFE
+#define FRAME_ERROR 0xFD
+#define FRAME_GAME_OVER 0xFC
+
+#define MODE_HUMAN 0
+#define MODE_ENGINE 1
+
+#define ERROR_ILLEGAL_MOVE 1
+#define ERROR_NO_GAME 2
+#define ERROR_BAD_FRAME 3
+
+// most bytes the server sends in answer to one request: the move, the
+// computer's reply and game over
+#define MAX_ANSWER (3 * FRAME_SIZE)
+
+#define DEFAULT_PORT 7410
+
+#endif /* PROTOCOL_H_ */
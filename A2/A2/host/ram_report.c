@@ -0,0 +1,262 @@
+/*
+ * ram_report.c
+ *
+ * Reports the RAM used by each module of a build, from the GNU linker map
+ * file (Atmel Studio writes Debug/A2.map). Variables are counted from the
+ * .data, .bss and .noinit sections. If .su files from -fstack-usage are
+ * given as well, the largest stack frame of each module is shown too
+ * (the stack needed is the sum of the frames along the deepest call
+ * chain, which a map file can't tell us).
+ *
+ *     ./build/ram_report Debug/A2.map Debug/buttons.su Debug/game.su ...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+enum { DATA, BSS, NOINIT, NUM_SECTIONS };
+static const char* section_names[NUM_SECTIONS] = { ".data", ".bss", ".noinit" };
+
+#define MAX_MODULES 128
+#define NAME_LENGTH 64
+
+typedef struct {
+	char name[NAME_LENGTH];
+	unsigned long size[NUM_SECTIONS];
+	unsigned long frame;	// largest stack frame, 0 if unknown
+	char frame_function[NAME_LENGTH];
+} Module;
+
+static Module modules[MAX_MODULES];
+static int num_modules;
+
+// the module an object file belongs to: its file name, or the archive's
+// name for library members (libc.a(iob.o) counts as libc.a)
+static Module* find_module(const char* path) {
+	char name[NAME_LENGTH];
+	size_t end = strcspn(path, "\r\n");
+	const char* member = NULL;
+	if(end > 0 && path[end - 1] == ')') {
+		// the archive's path may itself have brackets in it
+		for(const char* p = path; p < path + end; p++) {
+			if(*p == '(') {
+				member = p;
+			}
+		}
+	}
+	if(member) {
+		end = member - path;
+	}
+	const char* base = path;
+	for(const char* p = path; p < path + end; p++) {
+		if(*p == '/' || *p == '\\') {
+			base = p + 1;
+		}
+	}
+	size_t length = path + end - base;
+	if(length >= NAME_LENGTH) {
+		length = NAME_LENGTH - 1;
+	}
+	memcpy(name, base, length);
+	name[length] = '\0';
+
+	for(int i = 0; i < num_modules; i++) {
+		if(strcmp(modules[i].name, name) == 0) {
+			return &modules[i];
+		}
+	}
+	if(num_modules == MAX_MODULES) {
+		fprintf(stderr, "too many modules\n");
+		exit(1);
+	}
+	Module* module = &modules[num_modules++];
+	strcpy(module->name, name);
+	return module;
+}
+
+static char* skip_spaces(char* s) {
+	while(isspace((unsigned char)*s)) {
+		s++;
+	}
+	return s;
+}
+
+// parse "0xADDRESS 0xSIZE file", returning the file or NULL
+static char* parse_placement(char* s, unsigned long* size) {
+	char* end;
+	s = skip_spaces(s);
+	if(strncmp(s, "0x", 2) != 0) {
+		return NULL;
+	}
+	strtoul(s, &end, 16);
+	s = skip_spaces(end);
+	if(strncmp(s, "0x", 2) != 0) {
+		return NULL;
+	}
+	*size = strtoul(s, &end, 16);
+	s = skip_spaces(end);
+	if(*s == '\0') {
+		return NULL;
+	}
+	s[strcspn(s, "\r\n")] = '\0';
+	return s;
+}
+
+// returns the size of the "data" memory region (the RAM), or 0
+static unsigned long read_map(const char* path) {
+	FILE* map = fopen(path, "r");
+	if(!map) {
+		perror(path);
+		exit(1);
+	}
+
+	char line[1024];
+	unsigned long ram_size = 0;
+	int in_memory_configuration = 0;
+	int section = -1;
+	int pending = 0;	// an input section name was on a line of its own
+
+	while(fgets(line, sizeof(line), map)) {
+		if(strncmp(line, "Memory Configuration", 20) == 0) {
+			in_memory_configuration = 1;
+			continue;
+		}
+		if(strncmp(line, "Linker script and memory map", 28) == 0) {
+			in_memory_configuration = 0;
+			continue;
+		}
+		if(in_memory_configuration) {
+			char name[32];
+			unsigned long origin, length;
+			if(sscanf(line, "%31s %lx %lx", name, &origin, &length) == 3 &&
+					strcmp(name, "data") == 0) {
+				ram_size = length;
+			}
+			continue;
+		}
+
+		// an output section starts at the beginning of a line
+		if(line[0] != ' ' && line[0] != '\n' && line[0] != '\r') {
+			section = -1;
+			pending = 0;
+			for(int i = 0; i < NUM_SECTIONS; i++) {
+				size_t length = strlen(section_names[i]);
+				if(strncmp(line, section_names[i], length) == 0 &&
+						isspace((unsigned char)line[length])) {
+					section = i;
+				}
+			}
+			continue;
+		}
+		if(section < 0) {
+			continue;
+		}
+
+		// input sections are " .name 0xADDRESS 0xSIZE file" or
+		// " COMMON ...", with long names on a line of their own
+		char* s = line + 1;
+		unsigned long size;
+		char* file;
+		if(pending) {
+			pending = 0;
+			if((file = parse_placement(s, &size))) {
+				find_module(file)->size[section] += size;
+			}
+		} else if(*s == '.' || strncmp(s, "COMMON", 6) == 0) {
+			s += strcspn(s, " \t\r\n");
+			if(*skip_spaces(s) == '\0') {
+				pending = 1;
+			} else if((file = parse_placement(s, &size))) {
+				find_module(file)->size[section] += size;
+			}
+		}
+	}
+	fclose(map);
+	return ram_size;
+}
+
+// lines of a .su file are "file.c:line:column:function<TAB>bytes<TAB>type"
+static void read_stack_usage(const char* path) {
+	FILE* su = fopen(path, "r");
+	if(!su) {
+		perror(path);
+		exit(1);
+	}
+
+	// foo.su was written alongside foo.o
+	char object[NAME_LENGTH];
+	const char* base = strrchr(path, '/');
+	base = base ? base + 1 : path;
+	snprintf(object, sizeof(object), "%.*s.o", (int)strcspn(base, "."), base);
+	Module* module = find_module(object);
+
+	char line[1024];
+	while(fgets(line, sizeof(line), su)) {
+		char* tab = strchr(line, '\t');
+		if(!tab) {
+			continue;
+		}
+		*tab = '\0';
+		unsigned long frame = strtoul(tab + 1, NULL, 10);
+		if(frame > module->frame) {
+			const char* function = strrchr(line, ':');
+			module->frame = frame;
+			snprintf(module->frame_function, NAME_LENGTH, "%.63s",
+					function ? function + 1 : line);
+		}
+	}
+	fclose(su);
+}
+
+static int compare_modules(const void* a, const void* b) {
+	const Module* x = a;
+	const Module* y = b;
+	unsigned long x_total = x->size[DATA] + x->size[BSS] + x->size[NOINIT];
+	unsigned long y_total = y->size[DATA] + y->size[BSS] + y->size[NOINIT];
+	if(x_total != y_total) {
+		return x_total < y_total ? 1 : -1;
+	}
+	return strcmp(x->name, y->name);
+}
+
+int main(int argc, char** argv) {
+	if(argc < 2) {
+		fprintf(stderr, "usage: %s MAP_FILE [SU_FILE...]\n", argv[0]);
+		return 2;
+	}
+	unsigned long ram_size = read_map(argv[1]);
+	for(int i = 2; i < argc; i++) {
+		read_stack_usage(argv[i]);
+	}
+	qsort(modules, num_modules, sizeof(Module), compare_modules);
+
+	unsigned long totals[NUM_SECTIONS] = {0};
+	printf("%-24s %7s %7s %7s %7s  %s\n", "module", ".data", ".bss", ".noinit",
+			"total", argc > 2 ? "largest stack frame" : "");
+	for(int i = 0; i < num_modules; i++) {
+		const Module* m = &modules[i];
+		unsigned long total = m->size[DATA] + m->size[BSS] + m->size[NOINIT];
+		if(total == 0 && m->frame == 0) {
+			continue;
+		}
+		printf("%-24s %7lu %7lu %7lu %7lu", m->name, m->size[DATA], m->size[BSS],
+				m->size[NOINIT], total);
+		if(m->frame) {
+			printf("  %5lu %s", m->frame, m->frame_function);
+		}
+		printf("\n");
+		for(int s = 0; s < NUM_SECTIONS; s++) {
+			totals[s] += m->size[s];
+		}
+	}
+	unsigned long used = totals[DATA] + totals[BSS] + totals[NOINIT];
+	printf("%-24s %7lu %7lu %7lu %7lu\n", "total", totals[DATA], totals[BSS],
+			totals[NOINIT], used);
+	if(ram_size) {
+		printf("RAM %lu bytes, %lu left for the stack\n", ram_size,
+				used < ram_size ? ram_size - used : 0);
+	}
+	return 0;
+}
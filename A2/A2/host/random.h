@@ -0,0 +1,36 @@
+/*
+ * random.h
+ *
+ * The pseudo-random numbers of the host programs, for random games,
+ * openings and boards. Each caller keeps its own state, seeded with
+ * anything but 0, so a run depends only on its seed and not on the order
+ * threads or clients are scheduled in.
+ */
+
+#ifndef RANDOM_H_
+#define RANDOM_H_
+
+#include <stdint.h>
+#include "teeko.h"
+
+/* xorshift32 */
+static inline uint32_t next_random(uint32_t* state) {
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *state = x;
+}
+
+/* Make any one of the legal moves. Returns 0 if there are none. */
+static inline uint8_t random_move(Position* position, uint32_t* state) {
+	Move moves[MAX_MOVES];
+	uint8_t move_count = teeko_generate_moves(position, moves);
+	if(move_count == 0) {
+		return 0;
+	}
+	teeko_make(position, moves[next_random(state) % move_count]);
+	return 1;
+}
+
+#endif /* RANDOM_H_ */
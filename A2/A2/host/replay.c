@@ -0,0 +1,238 @@
+/*
+ * replay.c
+ *
+ * Plays a recorded input session (see capture.h, made with
+ * build/teeko --record) back into the native build of the firmware and
+ * reports what each input event cost:
+ *     bytes       bytes written to the terminal in response to the event
+ *     background  bytes written between the previous event and this one
+ *                 (cursor flashing and so on)
+ *     line_us     time the real UART needs to send those bytes
+ *     host_us     host time from delivering the event until its last
+ *                 output byte was written
+ * followed by totals (with the bytes sent to the LED matrix) and the final
+ * board state. The buzzer's notes can be logged with --notes, to compare
+ * with a recorded log. With --null-display the board is drawn into memory only,
+ * to see what the rest of the output costs.
+ *
+ * Time is virtual so a replay is deterministic: the clock advances one
+ * microsecond per interrupt point and jumps forward to each event's time
+ * once the firmware has gone quiet. Everything except host_us is therefore
+ * identical from run to run and can be kept as a regression baseline.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hal_host.h"
+#include "capture.h"
+#include "game.h"
+#include "display.h"
+
+// the firmware is idle once this many interrupt points pass without
+// any output
+#define QUIET_POLLS 64
+
+static CaptureEvent* events;
+static long event_count;
+static long next_event;
+
+static FILE* report;
+static FILE* screen;
+
+static enum {
+	STARTING,	// waiting for the start up output to finish
+	ADVANCING,	// moving time on to the next event
+	SETTLING,	// waiting for background output to finish
+	MEASURING	// waiting for the response to an event to finish
+} state = STARTING;
+
+static uint64_t virtual_us;
+static uint32_t quiet_polls;
+
+// measurements for the current event
+static uint64_t background_start_count;
+static uint64_t event_start_count;
+static uint64_t event_start_host_ns;
+static uint64_t last_output_host_ns;
+static uint64_t background_bytes;
+
+// totals
+static uint64_t total_bytes, total_background, total_host_us, worst_host_us;
+
+static uint64_t host_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static uint64_t replay_now_us(void) {
+	return virtual_us;
+}
+
+static void describe(const CaptureEvent* event, char* text) {
+	if(event->type == CAPTURE_BUTTONS) {
+		sprintf(text, "btn:%x", event->value);
+	} else if(event->value > ' ' && event->value < 0x7F) {
+		sprintf(text, "'%c'", event->value);
+	} else {
+		sprintf(text, "0x%02x", event->value);
+	}
+}
+
+static void finish(void) {
+	uint64_t byte_us = hal_host_uart_byte_us();
+	fprintf(report, "# events %ld bytes %" PRIu64 " background %" PRIu64
+			" line_us %" PRIu64 " host_us %" PRIu64 " worst_host_us %"
+			PRIu64 " spi_bytes %" PRIu64 "\n", event_count, total_bytes,
+			total_background, total_bytes * byte_us, total_host_us, worst_host_us,
+			hal_host_spi_count());
+
+	// board, top row first as on the terminal
+	fprintf(report, "# board\n");
+	for(int8_t y = HEIGHT - 1; y >= 0; y--) {
+		fprintf(report, "# ");
+		for(uint8_t x = 0; x < WIDTH; x++) {
+			fputc(".12"[get_piece_at(x, y) % 3], report);
+		}
+		fputc('\n', report);
+	}
+	fflush(report);
+	if(screen) {
+		fflush(screen);
+	}
+	exit(0);
+}
+
+static void replay_poll(void) {
+	// each interrupt point takes a microsecond
+	virtual_us++;
+	quiet_polls++;
+	if(quiet_polls < QUIET_POLLS) {
+		return;
+	}
+
+	switch(state) {
+	case STARTING:
+		state = ADVANCING;
+		break;
+
+	case ADVANCING:
+		if(next_event == event_count) {
+			finish();
+		}
+		if(virtual_us < events[next_event].time_us) {
+			virtual_us = events[next_event].time_us;
+		}
+		background_start_count = hal_host_tx_count();
+		quiet_polls = 0;
+		state = SETTLING;
+		break;
+
+	case SETTLING: {
+		const CaptureEvent* event = &events[next_event];
+		background_bytes = hal_host_tx_count() - background_start_count;
+		event_start_count = hal_host_tx_count();
+		event_start_host_ns = last_output_host_ns = host_ns();
+		if(event->type == CAPTURE_SERIAL) {
+			hal_host_rx(event->value);
+		} else {
+			hal_host_set_buttons(event->value);
+		}
+		quiet_polls = 0;
+		state = MEASURING;
+		break;
+	}
+
+	case MEASURING:
+		if(hal_host_rx_pending() == 0) {
+			const CaptureEvent* event = &events[next_event];
+			uint64_t bytes = hal_host_tx_count() - event_start_count;
+			uint64_t host_us = (last_output_host_ns - event_start_host_ns) / 1000;
+			char input[16];
+			describe(event, input);
+			fprintf(report, "%6ld %10" PRIu64 " %-7s %7" PRIu64 " %10" PRIu64
+					" %8" PRIu64 " %8" PRIu64 "\n", next_event,
+					event->time_us / 1000, input, bytes, background_bytes,
+					bytes * hal_host_uart_byte_us(), host_us);
+
+			total_bytes += bytes;
+			total_background += background_bytes;
+			total_host_us += host_us;
+			if(host_us > worst_host_us) {
+				worst_host_us = host_us;
+			}
+			next_event++;
+			state = ADVANCING;
+		}
+		break;
+	}
+}
+
+static void replay_transmit(const char* data, size_t length) {
+	quiet_polls = 0;
+	last_output_host_ns = host_ns();
+	if(screen) {
+		fwrite(data, 1, length, screen);
+	}
+}
+
+static const HostDriver replay_driver = {
+	.now_us = replay_now_us,
+	.poll = replay_poll,
+	.transmit = replay_transmit
+};
+
+int main(int argc, char** argv) {
+	static const DisplayBackend* const null_backends[] = { &null_display, NULL };
+	const char* capture = NULL;
+	for(int i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--null-display") == 0) {
+			display_set_backends(null_backends);
+		} else if(strcmp(argv[i], "--notes") == 0 && i + 1 < argc) {
+			FILE* notes = fopen(argv[++i], "w");
+			if(!notes) {
+				perror(argv[i]);
+				return 1;
+			}
+			hal_host_note_log(notes);
+		} else if(strcmp(argv[i], "--screen") == 0 && i + 1 < argc) {
+			screen = fopen(argv[++i], "w");
+			if(!screen) {
+				perror(argv[i]);
+				return 1;
+			}
+		} else if(!capture && argv[i][0] != '-') {
+			capture = argv[i];
+		} else {
+			capture = NULL;
+			break;
+		}
+	}
+	if(!capture) {
+		fprintf(stderr, "usage: %s [--screen FILE] [--notes FILE] [--null-display] CAPTURE\n"
+				"  --screen FILE   write the terminal output to FILE\n"
+				"  --notes FILE    write the buzzer's notes to FILE\n"
+				"  --null-display  draw the board in memory only\n", argv[0]);
+		return 2;
+	}
+
+	event_count = capture_load(capture, &events);
+	if(event_count < 0) {
+		return 1;
+	}
+
+	// the firmware takes over stdout, keep our own copy for the report
+	report = fdopen(dup(STDOUT_FILENO), "w");
+	fprintf(report, "# replay of %s\n", capture);
+	fprintf(report, "# %4s %10s %-7s %7s %10s %8s %8s\n", "event", "time_ms",
+			"input", "bytes", "background", "line_us", "host_us");
+
+	hal_host_set_driver(&replay_driver);
+	return firmware_main();
+}
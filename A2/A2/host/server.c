@@ -0,0 +1,461 @@
+/*
+ * server.c
+ *
+ * A game server on Linux for many games at once, human against human or
+ * against the computer, using the same rules (teeko.c) and search
+ * (engine.c) as the firmware. Clients speak the 2-byte frame protocol in
+ * protocol.h over TCP on the loopback interface or a Unix socket.
+ *
+ * A small pool of worker threads share the listening socket, each with its
+ * own epoll set. Whichever worker is woken accepts new connections and
+ * deals them round robin into the workers' sets, and from then on a
+ * session is only served by the one worker, so nothing is locked.
+ * Sessions are a few dozen bytes, allocated from a slab per worker, and
+ * an idle one costs nothing but its memory and socket. The
+ * computer's moves are searched on the worker, with a node limit keeping
+ * each one to around a millisecond.
+ *
+ *     ./build/server --port 7410 --threads 4
+ *     ./build/server --unix /tmp/teeko.sock
+ *
+ * It runs until interrupted (or for --seconds), then reports what it did.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "teeko.h"
+#include "engine.h"
+#include "protocol.h"
+
+typedef struct {
+	int fd;
+	uint8_t playing;	// a game is in progress
+	uint8_t mode;		// MODE_HUMAN or MODE_ENGINE
+	uint8_t partial;	// bytes of a frame received so far (0 or 1)
+	uint8_t first;		// the first byte of a partial frame
+	Position position;
+} Session;
+
+/*
+ * Slab allocator. Sessions come from chunks of SLAB_SESSIONS, and freed
+ * ones go on a free list to be used again. Chunks are kept until exit.
+ * A session is allocated by the worker which accepted it but freed by the
+ * one serving it, so slots move between workers' free lists, but each
+ * list is only used by its own worker.
+ */
+#define SLAB_SESSIONS 1024
+
+typedef union Slot {
+	Session session;
+	union Slot* next_free;
+} Slot;
+
+typedef struct Chunk {
+	struct Chunk* next;
+	Slot slots[SLAB_SESSIONS];
+} Chunk;
+
+typedef struct {
+	Chunk* chunks;
+	Slot* free_list;
+} Slab;
+
+static Session* slab_alloc(Slab* slab) {
+	if(!slab->free_list) {
+		Chunk* chunk = malloc(sizeof(Chunk));
+		if(!chunk) {
+			return NULL;
+		}
+		chunk->next = slab->chunks;
+		slab->chunks = chunk;
+		for(int i = 0; i < SLAB_SESSIONS; i++) {
+			chunk->slots[i].next_free = slab->free_list;
+			slab->free_list = &chunk->slots[i];
+		}
+	}
+	Slot* slot = slab->free_list;
+	slab->free_list = slot->next_free;
+	return &slot->session;
+}
+
+static void slab_free(Slab* slab, Session* session) {
+	Slot* slot = (Slot*)session;
+	slot->next_free = slab->free_list;
+	slab->free_list = slot;
+}
+
+static void slab_destroy(Slab* slab) {
+	while(slab->chunks) {
+		Chunk* next = slab->chunks->next;
+		free(slab->chunks);
+		slab->chunks = next;
+	}
+	slab->free_list = NULL;
+}
+
+typedef struct {
+	pthread_t thread;
+	int epoll_fd;
+	Slab slab;
+	unsigned next_worker;	// to deal the next connection to
+	// counted by the worker, read once it has stopped
+	uint64_t accepted;
+	uint64_t moves, engine_moves, engine_us;
+} Worker;
+
+/* Options */
+static unsigned thread_count = 4;
+static int port = DEFAULT_PORT;
+static const char* unix_path;
+static unsigned seconds;
+static SearchLimits engine_limits = { .max_depth = 4, .max_nodes = 5000 };
+
+static Worker* workers;
+static int listen_fd;
+static volatile sig_atomic_t stopping;
+
+// sessions open, across all workers
+static uint64_t open_sessions, peak_sessions;
+
+static uint64_t now_us(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+static void close_session(Worker* worker, Session* session) {
+	// closing the socket takes it out of the epoll set
+	close(session->fd);
+	slab_free(&worker->slab, session);
+	__atomic_sub_fetch(&open_sessions, 1, __ATOMIC_RELAXED);
+}
+
+static void count_session(void) {
+	uint64_t open = __atomic_add_fetch(&open_sessions, 1, __ATOMIC_RELAXED);
+	uint64_t peak = __atomic_load_n(&peak_sessions, __ATOMIC_RELAXED);
+	while(open > peak && !__atomic_compare_exchange_n(&peak_sessions, &peak, open,
+			0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+		continue;
+	}
+}
+
+// make a move in the session's game, adding it (and game over) to the
+// answer. Returns the bytes added.
+static int play(Session* session, Move move, uint8_t* answer) {
+	int length = 0;
+	teeko_make(&session->position, move);
+	answer[length++] = MOVE_FROM(move);
+	answer[length++] = MOVE_TO(move);
+	if(teeko_move_won(&session->position, move)) {
+		answer[length++] = FRAME_GAME_OVER;
+		answer[length++] = 3 - session->position.to_move;
+		session->playing = 0;
+	}
+	return length;
+}
+
+// answer one request, returning the length of the answer
+static int handle_frame(Worker* worker, Session* session, uint8_t first,
+		uint8_t second, uint8_t* answer) {
+	if(first == FRAME_NEW_GAME) {
+		if(second != MODE_HUMAN && second != MODE_ENGINE) {
+			answer[0] = FRAME_ERROR;
+			answer[1] = ERROR_BAD_FRAME;
+			return FRAME_SIZE;
+		}
+		teeko_init(&session->position);
+		session->playing = 1;
+		session->mode = second;
+		answer[0] = FRAME_NEW_GAME;
+		answer[1] = second;
+		return FRAME_SIZE;
+	}
+
+	Move move = MAKE_MOVE(first, second);
+	if(!session->playing) {
+		answer[0] = FRAME_ERROR;
+		answer[1] = ERROR_NO_GAME;
+		return FRAME_SIZE;
+	}
+	if(!teeko_is_legal(&session->position, move)) {
+		answer[0] = FRAME_ERROR;
+		answer[1] = ERROR_ILLEGAL_MOVE;
+		return FRAME_SIZE;
+	}
+	int length = play(session, move, answer);
+	worker->moves++;
+
+	if(session->playing && session->mode == MODE_ENGINE) {
+		SearchResult result;
+		uint64_t start = now_us();
+		engine_search(&session->position, &engine_limits, &result);
+		worker->engine_us += now_us() - start;
+		worker->engine_moves++;
+		if(result.move == MOVE_NONE) {
+			// blocked in, which can't happen in Teeko but ends the game
+			answer[length++] = FRAME_GAME_OVER;
+			answer[length++] = 0;
+			session->playing = 0;
+		} else {
+			length += play(session, result.move, answer + length);
+		}
+	}
+	return length;
+}
+
+// read what the client has sent and answer it. Returns 0 if the session
+// should be closed.
+static int serve(Worker* worker, Session* session) {
+	// One read per wakeup: epoll is level triggered so anything left is
+	// served next time round, after the other sessions which are waiting.
+	// (Reading until EAGAIN lets a client which answers quickly keep the
+	// worker to itself.)
+	uint8_t input[256];
+	ssize_t received = recv(session->fd, input, sizeof(input), 0);
+	if(received == 0) {
+		return 0;
+	}
+	if(received < 0) {
+		return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+	}
+
+	for(ssize_t i = 0; i < received; i++) {
+		if(!session->partial) {
+			session->first = input[i];
+			session->partial = 1;
+			continue;
+		}
+		session->partial = 0;
+		uint8_t answer[MAX_ANSWER];
+		int length = handle_frame(worker, session, session->first, input[i], answer);
+		// a client which isn't reading its answers is dropped
+		if(send(session->fd, answer, length, MSG_NOSIGNAL) != length) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static void accept_sessions(Worker* worker) {
+	for(;;) {
+		int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if(fd < 0) {
+			if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+				perror("accept");
+			}
+			return;
+		}
+		Session* session = slab_alloc(&worker->slab);
+		if(!session) {
+			close(fd);
+			continue;
+		}
+		if(!unix_path) {
+			// answers are single small writes
+			int one = 1;
+			setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+		}
+		memset(session, 0, sizeof(*session));
+		session->fd = fd;
+		count_session();
+		// the worker serving it is woken once it is in that worker's set
+		Worker* server = &workers[worker->next_worker++ % thread_count];
+		struct epoll_event event = { .events = EPOLLIN | EPOLLRDHUP, .data.ptr = session };
+		if(epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+			perror("epoll_ctl");
+			close_session(worker, session);
+			continue;
+		}
+		worker->accepted++;
+	}
+}
+
+static void* worker_main(void* argument) {
+	Worker* worker = argument;
+	struct epoll_event events[64];
+	while(!stopping) {
+		int count = epoll_wait(worker->epoll_fd, events, 64, 200);
+		for(int i = 0; i < count; i++) {
+			Session* session = events[i].data.ptr;
+			if(!session) {
+				accept_sessions(worker);
+			} else if(!serve(worker, session) ||
+					(events[i].events & (EPOLLHUP | EPOLLERR))) {
+				close_session(worker, session);
+			}
+		}
+	}
+	return NULL;
+}
+
+static int open_listener(void) {
+	int fd;
+	if(unix_path) {
+		struct sockaddr_un address = { .sun_family = AF_UNIX };
+		if(strlen(unix_path) >= sizeof(address.sun_path)) {
+			fprintf(stderr, "socket path too long\n");
+			return -1;
+		}
+		strcpy(address.sun_path, unix_path);
+		unlink(unix_path);
+		fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if(fd < 0 || bind(fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+			perror(unix_path);
+			return -1;
+		}
+	} else {
+		struct sockaddr_in address = {
+			.sin_family = AF_INET,
+			.sin_port = htons(port),
+			.sin_addr.s_addr = htonl(INADDR_LOOPBACK)
+		};
+		fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		int one = 1;
+		if(fd < 0 || setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0 ||
+				bind(fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+			perror("bind");
+			return -1;
+		}
+	}
+	if(listen(fd, SOMAXCONN) < 0) {
+		perror("listen");
+		return -1;
+	}
+	return fd;
+}
+
+// allow as many sockets as the system will let us
+static void raise_file_limit(void) {
+	struct rlimit limit;
+	if(getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+}
+
+static void stop(int signal) {
+	(void)signal;
+	stopping = 1;
+}
+
+static void usage(const char* program) {
+	fprintf(stderr, "usage: %s [options]\n"
+			"  --port N       TCP port on 127.0.0.1 (default %d)\n"
+			"  --unix PATH    listen on a Unix socket instead\n"
+			"  --threads N    worker threads (default 4)\n"
+			"  --depth N      computer's search depth (default 4)\n"
+			"  --nodes N      computer's node limit per move (default 5000)\n"
+			"  --seconds N    stop after N seconds (default: when interrupted)\n",
+			program, DEFAULT_PORT);
+}
+
+int main(int argc, char** argv) {
+	for(int i = 1; i < argc; i++) {
+		const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+		if(!value) {
+			usage(argv[0]);
+			return 2;
+		}
+		if(strcmp(argv[i], "--port") == 0) {
+			port = atoi(value);
+		} else if(strcmp(argv[i], "--unix") == 0) {
+			unix_path = value;
+		} else if(strcmp(argv[i], "--threads") == 0) {
+			thread_count = atoi(value);
+		} else if(strcmp(argv[i], "--depth") == 0) {
+			engine_limits.max_depth = atoi(value);
+		} else if(strcmp(argv[i], "--nodes") == 0) {
+			engine_limits.max_nodes = strtoul(value, NULL, 10);
+		} else if(strcmp(argv[i], "--seconds") == 0) {
+			seconds = atoi(value);
+		} else {
+			usage(argv[0]);
+			return 2;
+		}
+		i++;
+	}
+	if(thread_count == 0) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	raise_file_limit();
+	listen_fd = open_listener();
+	if(listen_fd < 0) {
+		return 1;
+	}
+	signal(SIGINT, stop);
+	signal(SIGTERM, stop);
+	if(seconds) {
+		signal(SIGALRM, stop);
+		alarm(seconds);
+	}
+
+	workers = calloc(thread_count, sizeof(Worker));
+	for(unsigned w = 0; w < thread_count; w++) {
+		Worker* worker = &workers[w];
+		worker->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+		// the connections accepted by each worker are dealt starting
+		// with a different one
+		worker->next_worker = w;
+		// only one worker is woken for each new connection
+		struct epoll_event event = { .events = EPOLLIN | EPOLLEXCLUSIVE, .data.ptr = NULL };
+		if(worker->epoll_fd < 0 ||
+				epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, listen_fd, &event) < 0) {
+			perror("epoll");
+			return 1;
+		}
+	}
+	// all the epoll sets exist before any worker can deal a connection
+	for(unsigned w = 0; w < thread_count; w++) {
+		pthread_create(&workers[w].thread, NULL, worker_main, &workers[w]);
+	}
+	if(unix_path) {
+		printf("listening on %s with %u threads\n", unix_path, thread_count);
+	} else {
+		printf("listening on 127.0.0.1:%d with %u threads\n", port, thread_count);
+	}
+	printf("session %zu bytes\n", sizeof(Session));
+	fflush(stdout);
+
+	uint64_t accepted = 0, moves = 0, engine_moves = 0, engine_us = 0;
+	for(unsigned w = 0; w < thread_count; w++) {
+		pthread_join(workers[w].thread, NULL);
+	}
+	for(unsigned w = 0; w < thread_count; w++) {
+		Worker* worker = &workers[w];
+		accepted += worker->accepted;
+		moves += worker->moves;
+		engine_moves += worker->engine_moves;
+		engine_us += worker->engine_us;
+		close(worker->epoll_fd);
+		slab_destroy(&worker->slab);
+	}
+	close(listen_fd);
+	if(unix_path) {
+		unlink(unix_path);
+	}
+
+	printf("sessions %llu accepted, peak %llu open at once\n",
+			(unsigned long long)accepted, (unsigned long long)peak_sessions);
+	printf("moves %llu, computer moves %llu averaging %.0f us\n",
+			(unsigned long long)moves, (unsigned long long)engine_moves,
+			engine_moves ? (double)engine_us / engine_moves : 0.0);
+	free(workers);
+	return 0;
+}
@@ -0,0 +1,384 @@
+/*
+ * tournament.c
+ *
+ * Engine-versus-engine self-play on the host, for tuning and regression
+ * testing the computer player. Games use the same rules (teeko.c) and
+ * search (engine.c) as the firmware, compiled natively.
+ *
+ * Games are played in pairs from the same randomised opening with the
+ * engines swapping sides, and are spread over a work-stealing pool of
+ * threads (one per core by default). Each engine has its own depth, node
+ * and time limits per move. At the end the results for engine A are
+ * summarised (win/draw/loss rates and score with 95% confidence
+ * intervals, Elo difference, nodes/sec and games/sec), and each game can
+ * be logged to a CSV file.
+ *
+ * Either engine can be the Monte Carlo tree search (mcts.c) instead of
+ * alpha-beta, with a pool of nodes of the given size kept for the whole
+ * game. Its node limit counts playouts.
+ *
+ *     ./build/tournament --games 2000 --nodes-a 20000 --nodes-b 10000
+ *     ./build/tournament --games 200 --mcts-a 100000 --time 100
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "teeko.h"
+#include "engine.h"
+#include "mcts.h"
+#include "random.h"
+
+typedef struct {
+	SearchLimits limits;
+	uint32_t mcts_nodes;	// pool size for MCTS, 0 for alpha-beta
+	const char* name;
+} Player;
+
+typedef struct {
+	uint32_t game;
+	uint8_t a_is_player_1;
+	int8_t result;		// +1 engine A won, 0 draw, -1 engine B won
+	uint16_t plies;
+	uint64_t nodes[2];	// searched by A and B
+	uint64_t time_us[2];	// spent searching by A and B
+} GameRecord;
+
+/* Options */
+static uint32_t game_count = 1000;
+static unsigned thread_count;
+static uint32_t seed = 1;
+static uint8_t random_plies = 4;
+static uint16_t max_plies = 200;
+static const char* log_path;
+static Player players[2] = {
+	{ { .max_depth = 4 }, 0, "A" },
+	{ { .max_depth = 4 }, 0, "B" }
+};
+
+static GameRecord* records;
+
+static uint64_t now_us(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+static uint32_t now_ms(void) {
+	return now_us() / 1000;
+}
+
+static void play_game(uint32_t game, GameRecord* record) {
+	// both games of a pair start from the same opening
+	uint32_t random_state = (seed + game / 2) * 2654435761u | 1;
+	Position position;
+	teeko_init(&position);
+
+	record->game = game;
+	record->a_is_player_1 = (game % 2 == 0);
+	record->result = 0;
+	record->nodes[0] = record->nodes[1] = 0;
+	record->time_us[0] = record->time_us[1] = 0;
+
+	// each MCTS engine keeps its tree from move to move
+	MctsTree trees[2];
+	MctsNode* pools[2] = { NULL, NULL };
+	for(int e = 0; e < 2; e++) {
+		if(players[e].mcts_nodes) {
+			pools[e] = malloc(players[e].mcts_nodes * sizeof(MctsNode));
+			mcts_init(&trees[e], pools[e], players[e].mcts_nodes, random_state + e);
+		}
+	}
+
+	uint16_t ply;
+	for(ply = 0; ply < max_plies; ply++) {
+		uint8_t winner = teeko_winner(&position);
+		if(winner) {
+			uint8_t a_won = (winner == PLAYER_1) == record->a_is_player_1;
+			record->result = a_won ? 1 : -1;
+			break;
+		}
+
+		Move moves[MAX_MOVES];
+		uint8_t move_count = teeko_generate_moves(&position, moves);
+		if(move_count == 0) {
+			break;
+		}
+
+		Move move;
+		if(ply < random_plies) {
+			move = moves[next_random(&random_state) % move_count];
+		} else {
+			// engine A moves for player 1 in even games
+			uint8_t engine = (position.to_move == PLAYER_1) != record->a_is_player_1;
+			SearchResult result;
+			uint64_t start = now_us();
+			if(pools[engine]) {
+				mcts_search(&trees[engine], &position, &players[engine].limits, &result);
+			} else {
+				engine_search(&position, &players[engine].limits, &result);
+			}
+			record->time_us[engine] += now_us() - start;
+			record->nodes[engine] += result.nodes;
+			move = result.move;
+		}
+		teeko_make(&position, move);
+	}
+	record->plies = ply;
+	free(pools[0]);
+	free(pools[1]);
+}
+
+/*
+ * Work-stealing pool. Each worker owns a deque of games: it takes work
+ * from the back of its own and, when that runs dry, steals from the front
+ * of the others'. Games are never added once the pool starts, so a worker
+ * which finds every deque empty is finished.
+ */
+typedef struct {
+	pthread_mutex_t lock;
+	uint32_t* games;
+	uint32_t front, back;
+} Deque;
+
+static Deque* deques;
+
+static int take_game(unsigned worker, uint32_t* game) {
+	for(unsigned i = 0; i < thread_count; i++) {
+		Deque* deque = &deques[(worker + i) % thread_count];
+		int found = 0;
+		pthread_mutex_lock(&deque->lock);
+		if(deque->front < deque->back) {
+			// our own from the back, others' from the front
+			*game = (i == 0) ? deque->games[--deque->back]
+					: deque->games[deque->front++];
+			found = 1;
+		}
+		pthread_mutex_unlock(&deque->lock);
+		if(found) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void* worker_main(void* argument) {
+	unsigned worker = (unsigned)(uintptr_t)argument;
+	uint32_t game;
+	while(take_game(worker, &game)) {
+		play_game(game, &records[game]);
+	}
+	return NULL;
+}
+
+static void run_pool(void) {
+	// the most pairs any worker is dealt
+	uint32_t pairs = ((game_count + 1) / 2 + thread_count - 1) / thread_count;
+	deques = calloc(thread_count, sizeof(*deques));
+	for(unsigned w = 0; w < thread_count; w++) {
+		pthread_mutex_init(&deques[w].lock, NULL);
+		deques[w].games = malloc(2 * pairs * sizeof(uint32_t));
+	}
+	// deal the games out round robin, pairs end up on the same worker
+	for(uint32_t game = 0; game < game_count; game++) {
+		Deque* deque = &deques[(game / 2) % thread_count];
+		deque->games[deque->back++] = game;
+	}
+
+	pthread_t* threads = malloc(thread_count * sizeof(*threads));
+	for(unsigned w = 0; w < thread_count; w++) {
+		pthread_create(&threads[w], NULL, worker_main, (void*)(uintptr_t)w);
+	}
+	for(unsigned w = 0; w < thread_count; w++) {
+		pthread_join(threads[w], NULL);
+	}
+
+	for(unsigned w = 0; w < thread_count; w++) {
+		free(deques[w].games);
+		pthread_mutex_destroy(&deques[w].lock);
+	}
+	free(deques);
+	free(threads);
+}
+
+/*
+ * Reporting
+ */
+static double elo(double score) {
+	if(score <= 0) {
+		score = 1e-6;
+	} else if(score >= 1) {
+		score = 1 - 1e-6;
+	}
+	return -400.0 * log10(1.0 / score - 1.0);
+}
+
+static void write_log(void) {
+	FILE* log = fopen(log_path, "w");
+	if(!log) {
+		perror(log_path);
+		return;
+	}
+	fprintf(log, "game,a_is_player_1,result,plies,nodes_a,nodes_b,time_us_a,time_us_b\n");
+	for(uint32_t g = 0; g < game_count; g++) {
+		const GameRecord* r = &records[g];
+		fprintf(log, "%u,%u,%d,%u,%llu,%llu,%llu,%llu\n", r->game, r->a_is_player_1,
+				r->result, r->plies, (unsigned long long)r->nodes[0],
+				(unsigned long long)r->nodes[1], (unsigned long long)r->time_us[0],
+				(unsigned long long)r->time_us[1]);
+	}
+	fclose(log);
+}
+
+static void report(double wall_seconds) {
+	uint32_t wins = 0, draws = 0, losses = 0;
+	uint64_t nodes = 0, search_us = 0, plies = 0;
+	for(uint32_t g = 0; g < game_count; g++) {
+		const GameRecord* r = &records[g];
+		wins += (r->result > 0);
+		draws += (r->result == 0);
+		losses += (r->result < 0);
+		nodes += r->nodes[0] + r->nodes[1];
+		search_us += r->time_us[0] + r->time_us[1];
+		plies += r->plies;
+	}
+
+	double n = game_count;
+	double w = wins / n, d = draws / n, l = losses / n;
+	double score = w + d / 2;
+	// variance of a single game's score (1, 1/2 or 0)
+	double variance = w * (1 - score) * (1 - score) + d * (0.5 - score) * (0.5 - score)
+			+ l * score * score;
+	double score_error = 1.96 * sqrt(variance / n);
+
+	for(int e = 0; e < 2; e++) {
+		const SearchLimits* limits = &players[e].limits;
+		if(players[e].mcts_nodes) {
+			printf("engine %s: mcts pool %u, playouts %u, time %u ms\n", players[e].name,
+					players[e].mcts_nodes, limits->max_nodes, limits->max_time);
+			continue;
+		}
+		printf("engine %s: depth %u, nodes %u, time %u ms\n", players[e].name,
+				limits->max_depth, limits->max_nodes, limits->max_time);
+	}
+	printf("games %u on %u threads, %.1f plies/game\n", game_count, thread_count,
+			plies / n);
+	printf("A wins   %6u  %5.1f%% +/- %.1f%%\n", wins, 100 * w,
+			196 * sqrt(w * (1 - w) / n));
+	printf("draws    %6u  %5.1f%% +/- %.1f%%\n", draws, 100 * d,
+			196 * sqrt(d * (1 - d) / n));
+	printf("A losses %6u  %5.1f%% +/- %.1f%%\n", losses, 100 * l,
+			196 * sqrt(l * (1 - l) / n));
+	printf("A score  %5.1f%% +/- %.1f%%, Elo %+.0f (%+.0f to %+.0f)\n", 100 * score,
+			100 * score_error, elo(score), elo(score - score_error),
+			elo(score + score_error));
+	printf("%.0f nodes/sec per thread, %.1f games/sec, %.2f s\n",
+			search_us ? nodes * 1e6 / search_us : 0.0, n / wall_seconds, wall_seconds);
+}
+
+static void usage(const char* program) {
+	fprintf(stderr, "usage: %s [options]\n"
+			"  --games N          games to play (default 1000, rounded up to pairs)\n"
+			"  --threads N        worker threads (default: one per core)\n"
+			"  --seed N           seed for the random openings (default 1)\n"
+			"  --random-plies N   random moves at the start of each game (default 4)\n"
+			"  --max-plies N      plies before a game is drawn (default 200)\n"
+			"  --depth[-a|-b] N   search depth per move (default 4)\n"
+			"  --nodes[-a|-b] N   node limit per move (default none)\n"
+			"  --time[-a|-b] MS   time limit per move (default none)\n"
+			"  --mcts[-a|-b] N    search by MCTS with a pool of N nodes (at most 65534)\n"
+			"  --log FILE         write a CSV line per game to FILE\n", program);
+}
+
+// set a search limit for engine A, B or both from an option like --nodes-a
+static int set_limit(const char* option, const char* suffix, const char* value) {
+	size_t length = strlen(suffix);
+	if(strncmp(option, suffix, length) != 0) {
+		return 0;
+	}
+	int first = 0, last = 1;
+	if(strcmp(option + length, "-a") == 0) {
+		last = 0;
+	} else if(strcmp(option + length, "-b") == 0) {
+		first = 1;
+	} else if(option[length] != '\0') {
+		return 0;
+	}
+	for(int e = first; e <= last; e++) {
+		SearchLimits* limits = &players[e].limits;
+		if(strcmp(suffix, "--mcts") == 0) {
+			players[e].mcts_nodes = strtoul(value, NULL, 10);
+			if(players[e].mcts_nodes >= MCTS_NONE) {
+				players[e].mcts_nodes = MCTS_NONE - 1;
+			}
+		} else if(strcmp(suffix, "--depth") == 0) {
+			limits->max_depth = atoi(value);
+		} else if(strcmp(suffix, "--nodes") == 0) {
+			limits->max_nodes = strtoul(value, NULL, 10);
+		} else {
+			limits->max_time = strtoul(value, NULL, 10);
+		}
+	}
+	return 1;
+}
+
+int main(int argc, char** argv) {
+	for(int i = 1; i < argc; i++) {
+		const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+		if(!value) {
+			usage(argv[0]);
+			return 2;
+		}
+		if(strcmp(argv[i], "--games") == 0) {
+			game_count = strtoul(value, NULL, 10);
+		} else if(strcmp(argv[i], "--threads") == 0) {
+			thread_count = atoi(value);
+		} else if(strcmp(argv[i], "--seed") == 0) {
+			seed = strtoul(value, NULL, 10);
+		} else if(strcmp(argv[i], "--random-plies") == 0) {
+			random_plies = atoi(value);
+		} else if(strcmp(argv[i], "--max-plies") == 0) {
+			max_plies = atoi(value);
+		} else if(strcmp(argv[i], "--log") == 0) {
+			log_path = value;
+		} else if(!set_limit(argv[i], "--depth", value) &&
+				!set_limit(argv[i], "--nodes", value) &&
+				!set_limit(argv[i], "--time", value) &&
+				!set_limit(argv[i], "--mcts", value)) {
+			usage(argv[0]);
+			return 2;
+		}
+		i++;
+	}
+
+	game_count += game_count % 2;
+	if(game_count == 0) {
+		usage(argv[0]);
+		return 2;
+	}
+	if(thread_count == 0) {
+		long cores = sysconf(_SC_NPROCESSORS_ONLN);
+		thread_count = cores > 0 ? cores : 1;
+	}
+	for(int e = 0; e < 2; e++) {
+		players[e].limits.clock = now_ms;
+	}
+
+	records = calloc(game_count, sizeof(*records));
+	uint64_t start = now_us();
+	run_pool();
+	double wall_seconds = (now_us() - start) / 1e6;
+
+	report(wall_seconds);
+	if(log_path) {
+		write_log();
+	}
+	free(records);
+	return 0;
+}
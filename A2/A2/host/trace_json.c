@@ -0,0 +1,205 @@
+/*
+ * trace_json.c
+ *
+ * Turns a latency trace dumped by the firmware (see trace.h) into a
+ * Chrome trace, to load in chrome://tracing or ui.perfetto.dev. The input
+ * is whatever the terminal received (a screen file from replay or a log
+ * of the serial port), of which the last dump is used.
+ *
+ *     make DEFINES=-DTRACE BUILD=build-trace
+ *     (play, then press 't' to dump the trace)
+ *     ./build/trace_json screen.txt > trace.json
+ *
+ * The trace shows the interrupts (input and the UART emptying), the
+ * stages of the main loop, and a bar from each input to the UART sending
+ * the last of the first repaint which followed it (if there was one
+ * before the next input). An input which changes nothing on the board is
+ * measured to the next flash of the cursor.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "trace.h"
+
+#define TID_INTERRUPTS 1
+#define TID_MAIN 2
+#define TID_LATENCY 3
+
+typedef struct {
+	uint64_t time;
+	uint8_t event;
+	uint8_t arg;
+} Event;
+
+static const char* const stage_names[STAGE_COUNT] = {
+	"move_display_cursor", "update_piece", "draw_game", "repaint"
+};
+
+static uint8_t first_output = 1;
+
+// one element of the array of events
+static void __attribute__((format(printf, 1, 2))) output(const char* format, ...) {
+	va_list args;
+	printf(first_output ? "\n  " : ",\n  ");
+	first_output = 0;
+	va_start(args, format);
+	vprintf(format, args);
+	va_end(args);
+}
+
+// the name of an input event, safe to put in a JSON string
+static void input_name(const Event* event, char* name, size_t size) {
+	if(event->event == TRACE_BUTTON) {
+		snprintf(name, size, "button B%u", event->arg);
+	} else if(event->arg > ' ' && event->arg < 0x7F && event->arg != '"' && event->arg != '\\') {
+		snprintf(name, size, "rx '%c'", event->arg);
+	} else {
+		snprintf(name, size, "rx 0x%02x", event->arg);
+	}
+}
+
+// read the last dump in file, returns the number of events or -1
+static int read_dump(FILE* file, Event** events) {
+	char line[256];
+	int count = -1;
+	int capacity = 0;
+	uint8_t in_dump = 0;
+	uint64_t high = 0;
+	uint32_t last = 0;
+	while(fgets(line, sizeof(line), file)) {
+		if(strstr(line, TRACE_DUMP_BEGIN)) {
+			// a later dump replaces an earlier one
+			count = 0;
+			high = 0;
+			last = 0;
+			in_dump = 1;
+			continue;
+		}
+		if(!in_dump) {
+			continue;
+		}
+		if(strstr(line, TRACE_DUMP_END)) {
+			in_dump = 0;
+			continue;
+		}
+		unsigned long time;
+		unsigned event, arg;
+		if(sscanf(line, "%lx %x %x", &time, &event, &arg) != 3) {
+			continue;
+		}
+		if(count == capacity) {
+			capacity = capacity ? 2 * capacity : 64;
+			*events = realloc(*events, capacity * sizeof(Event));
+		}
+		// the microsecond clock wraps every 71 minutes
+		if(count > 0 && time < last) {
+			high += (uint64_t)1 << 32;
+		}
+		last = time;
+		(*events)[count].time = high + time;
+		(*events)[count].event = event;
+		(*events)[count].arg = arg;
+		count++;
+	}
+	return count;
+}
+
+static void convert(const Event* events, int count) {
+	uint8_t open[STAGE_COUNT] = { 0 };
+	char name[32];
+
+	printf("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+	output("{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+			"\"args\": {\"name\": \"interrupts\"}}", TID_INTERRUPTS);
+	output("{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+			"\"args\": {\"name\": \"main loop\"}}", TID_MAIN);
+	output("{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+			"\"args\": {\"name\": \"input to output\"}}", TID_LATENCY);
+
+	for(int i = 0; i < count; i++) {
+		const Event* event = &events[i];
+		unsigned long long ts = event->time;
+		uint8_t stage = event->event & 0x0F;
+		switch(event->event & 0xF0) {
+		case TRACE_BEGIN:
+			if(stage < STAGE_COUNT) {
+				output("{\"name\": \"%s\", \"ph\": \"B\", \"ts\": %llu, \"pid\": 1, \"tid\": %d}",
+						stage_names[stage], ts, TID_MAIN);
+				open[stage]++;
+			}
+			continue;
+		case TRACE_END:
+			// (the start of a stage may have gone from the ring)
+			if(stage < STAGE_COUNT && open[stage]) {
+				output("{\"name\": \"%s\", \"ph\": \"E\", \"ts\": %llu, \"pid\": 1, \"tid\": %d}",
+						stage_names[stage], ts, TID_MAIN);
+				open[stage]--;
+			}
+			continue;
+		}
+
+		if(event->event == TRACE_TX_DONE) {
+			output("{\"name\": \"tx done\", \"ph\": \"i\", \"s\": \"t\", \"ts\": %llu, "
+					"\"pid\": 1, \"tid\": %d}", ts, TID_INTERRUPTS);
+			continue;
+		}
+		if(event->event != TRACE_RX && event->event != TRACE_BUTTON) {
+			continue;
+		}
+		input_name(event, name, sizeof(name));
+		output("{\"name\": \"%s\", \"ph\": \"i\", \"s\": \"t\", \"ts\": %llu, "
+				"\"pid\": 1, \"tid\": %d}", name, ts, TID_INTERRUPTS);
+
+		// the input has been seen when the UART last empties after the
+		// repaint starts and before anything else starts
+		const Event* done = NULL;
+		uint8_t repainting = 0;
+		for(int j = i + 1; j < count; j++) {
+			uint8_t next = events[j].event;
+			if(next == TRACE_RX || next == TRACE_BUTTON) {
+				break;
+			}
+			if((next & 0xF0) == TRACE_BEGIN) {
+				if(repainting) {
+					break;
+				}
+				repainting = next == TRACE_BEGIN + STAGE_REPAINT;
+			}
+			if(next == TRACE_TX_DONE && repainting) {
+				done = &events[j];
+			}
+		}
+		if(done) {
+			output("{\"name\": \"%s\", \"ph\": \"X\", \"ts\": %llu, \"dur\": %llu, "
+					"\"pid\": 1, \"tid\": %d}", name, ts,
+					(unsigned long long)(done->time - event->time), TID_LATENCY);
+		}
+	}
+	printf("\n]}\n");
+}
+
+int main(int argc, char** argv) {
+	if(argc != 2) {
+		fprintf(stderr, "usage: %s FILE\n"
+				"  write the last trace dumped in FILE as a Chrome trace\n", argv[0]);
+		return 2;
+	}
+	FILE* file = strcmp(argv[1], "-") == 0 ? stdin : fopen(argv[1], "r");
+	if(!file) {
+		perror(argv[1]);
+		return 1;
+	}
+	Event* events = NULL;
+	int count = read_dump(file, &events);
+	if(count < 0) {
+		fprintf(stderr, "%s: no trace dump found\n", argv[1]);
+		return 1;
+	}
+	convert(events, count);
+	free(events);
+	return 0;
+}
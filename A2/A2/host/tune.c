@@ -0,0 +1,572 @@
+/*
+ * tune.c
+ *
+ * Fits the evaluation weights (EvalWeights in engine.h) to the results of
+ * games by Texel's method. The evaluation of a position, squashed by a
+ * sigmoid, is taken as the expected result for the player to move, and
+ * the weights are moved down the gradient of its mean squared error
+ * against the results the games actually reached. The fitted weights are
+ * written as engine_weights.h, which engine.c compiles into flash.
+ *
+ * The positions come from self-play with the current weights, each game
+ * starting with a few random moves so that the games differ, and with the
+ * odd random move later on so that fewer of them are drawn, or from a
+ * file written by an earlier run (--save) or by some other program:
+ * one position a line, as analyse reads them (NUM_SQUARES characters '.',
+ * '1' or '2', a space and the player to move), then a space and the result
+ * for the player to move, 1 for a win, 0 for a loss and 0.5 for a game
+ * drawn at the ply limit.
+ *
+ * Only quiet positions are used, where the player to move can't win with
+ * their next move, as finding wins is the search's job rather than the
+ * evaluation's. The evaluation is linear in the weights, so the terms of
+ * each position are counted once (the line terms 8 positions at a time,
+ * see batch_eval.h) and each step of the descent is a pass of dot products
+ * over them, shared out between the threads.
+ *
+ *     ./build/tune --games 20000 --depth 3 --save positions.txt > engine_weights.h
+ *     ./build/tune --positions positions.txt --out engine_weights.h
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "teeko.h"
+#include "engine.h"
+#include "batch_eval.h"
+#include "random.h"
+
+// the weights fitted, line[0] cancels out of the evaluation so stays 0
+#define TERM_COUNT (BATCH_LINE_TERMS + 2)
+#define TERM_CENTRE BATCH_LINE_TERMS
+#define TERM_MOBILITY (BATCH_LINE_TERMS + 1)
+
+static const char* const term_names[TERM_COUNT] = {
+	"line[1]", "line[2]", "line[3]", "centre", "mobility"
+};
+
+// the 3x3 squares in the middle of the board, as in engine.c
+#define CENTRE (teeko_neighbours(SQUARE_BIT(NUM_SQUARES / 2)) | \
+		SQUARE_BIT(NUM_SQUARES / 2))
+
+/* Options */
+static uint32_t game_count = 10000;
+static unsigned thread_count;
+static uint32_t seed = 1;
+static uint8_t random_plies = 8;
+static uint8_t random_percent = 10;
+static uint16_t max_plies = 200;
+static SearchLimits limits = { .max_depth = 2 };
+static const char* positions_path;
+static const char* save_path;
+static const char* out_path = "-";
+static uint32_t iterations = 2000;
+static double rate = 0.5;
+
+/* The positions, from the player to move's point of view */
+typedef struct {
+	Bitboard mine, theirs;
+	uint8_t to_move;
+	float result;
+} Sample;
+
+static Sample* samples;
+static size_t sample_count, sample_capacity;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* The terms of each sample's evaluation, one array per term so that the
+ * dot products vectorise
+ */
+static float* terms[TERM_COUNT];
+static float* results;
+
+static uint64_t now_us(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+static void add_samples(const Sample* added, size_t count) {
+	pthread_mutex_lock(&lock);
+	if(sample_count + count > sample_capacity) {
+		sample_capacity = 2 * (sample_count + count);
+		samples = realloc(samples, sample_capacity * sizeof(Sample));
+	}
+	memcpy(samples + sample_count, added, count * sizeof(Sample));
+	sample_count += count;
+	pthread_mutex_unlock(&lock);
+}
+
+static uint8_t quiet(const Position* position) {
+	Bitboard from;
+	return teeko_winner(position) == 0 &&
+			teeko_winning_moves(position, position->to_move, &from) == 0;
+}
+
+/*
+ * Self-play. Each game's quiet positions are kept until the game ends and
+ * its result is known.
+ */
+static void play_game(uint32_t game) {
+	// one per game, so the openings don't depend on scheduling
+	uint32_t random_state = (seed + game) * 2654435761u | 1;
+	Sample game_samples[max_plies];
+	size_t count = 0;
+	Position position;
+	teeko_init(&position);
+
+	uint8_t winner = 0;
+	for(uint16_t ply = 0; ply < max_plies; ply++) {
+		winner = teeko_winner(&position);
+		if(winner) {
+			break;
+		}
+		Move moves[MAX_MOVES];
+		uint8_t move_count = teeko_generate_moves(&position, moves);
+		if(move_count == 0) {
+			break;
+		}
+		if(ply >= random_plies && quiet(&position)) {
+			uint8_t me = position.to_move;
+			game_samples[count].mine = position.pieces[me - 1];
+			game_samples[count].theirs = position.pieces[2 - me];
+			game_samples[count].to_move = me;
+			count++;
+		}
+
+		Move move;
+		if(ply < random_plies || next_random(&random_state) % 100 < random_percent) {
+			move = moves[next_random(&random_state) % move_count];
+		} else {
+			SearchResult result;
+			engine_search(&position, &limits, &result);
+			move = result.move;
+		}
+		teeko_make(&position, move);
+	}
+
+	for(size_t i = 0; i < count; i++) {
+		uint8_t won = winner == game_samples[i].to_move;
+		game_samples[i].result = !winner ? 0.5f : won ? 1.0f : 0.0f;
+	}
+	add_samples(game_samples, count);
+}
+
+static uint32_t next_game;
+
+static void* play_main(void* argument) {
+	(void)argument;
+	for(;;) {
+		pthread_mutex_lock(&lock);
+		uint32_t game = next_game++;
+		pthread_mutex_unlock(&lock);
+		if(game >= game_count) {
+			return NULL;
+		}
+		play_game(game);
+	}
+}
+
+static void self_play(void) {
+	pthread_t* threads = malloc(thread_count * sizeof(*threads));
+	for(unsigned t = 0; t < thread_count; t++) {
+		pthread_create(&threads[t], NULL, play_main, NULL);
+	}
+	for(unsigned t = 0; t < thread_count; t++) {
+		pthread_join(threads[t], NULL);
+	}
+	free(threads);
+}
+
+static int read_positions(const char* path) {
+	FILE* file = fopen(path, "r");
+	if(!file) {
+		perror(path);
+		return 0;
+	}
+	char line[256];
+	unsigned long number = 0;
+	while(fgets(line, sizeof(line), file)) {
+		number++;
+		if(line[0] == '#' || line[0] == '\n') {
+			continue;
+		}
+		Sample sample = { 0, 0, 0, 0 };
+		uint8_t valid = strlen(line) > NUM_SQUARES + 3 && line[NUM_SQUARES] == ' ' &&
+				(line[NUM_SQUARES + 1] == '1' || line[NUM_SQUARES + 1] == '2') &&
+				line[NUM_SQUARES + 2] == ' ';
+		uint8_t me = sample.to_move = line[NUM_SQUARES + 1] - '0';
+		for(uint8_t square = 0; valid && square < NUM_SQUARES; square++) {
+			if(line[square] == '0' + me) {
+				sample.mine |= SQUARE_BIT(square);
+			} else if(line[square] == '0' + (3 - me)) {
+				sample.theirs |= SQUARE_BIT(square);
+			} else if(line[square] != '.') {
+				valid = 0;
+			}
+		}
+		char* end;
+		if(valid) {
+			sample.result = strtof(line + NUM_SQUARES + 3, &end);
+			valid = end != line + NUM_SQUARES + 3 && sample.result >= 0 && sample.result <= 1;
+		}
+		if(!valid) {
+			fprintf(stderr, "%s:%lu: not a position and result\n", path, number);
+			fclose(file);
+			return 0;
+		}
+		add_samples(&sample, 1);
+	}
+	fclose(file);
+	return 1;
+}
+
+static int save_positions(const char* path) {
+	FILE* file = fopen(path, "w");
+	if(!file) {
+		perror(path);
+		return 0;
+	}
+	char line[NUM_SQUARES + 1];
+	line[NUM_SQUARES] = '\0';
+	for(size_t i = 0; i < sample_count; i++) {
+		uint8_t me = samples[i].to_move;
+		for(uint8_t square = 0; square < NUM_SQUARES; square++) {
+			line[square] = (samples[i].mine & SQUARE_BIT(square)) ? '0' + me :
+					(samples[i].theirs & SQUARE_BIT(square)) ? '0' + (3 - me) : '.';
+		}
+		fprintf(file, "%s %u %g\n", line, me, samples[i].result);
+	}
+	return fclose(file) == 0;
+}
+
+// count the terms of every sample's evaluation, as engine_evaluate() does
+static void extract_terms(void) {
+	Bitboard* mine = malloc(sample_count * sizeof(Bitboard));
+	Bitboard* theirs = malloc(sample_count * sizeof(Bitboard));
+	int8_t (*line_terms)[BATCH_LINE_TERMS] = malloc(sample_count * sizeof(*line_terms));
+	for(size_t i = 0; i < sample_count; i++) {
+		mine[i] = samples[i].mine;
+		theirs[i] = samples[i].theirs;
+	}
+	batch_line_terms(mine, theirs, sample_count, line_terms);
+
+	for(uint8_t k = 0; k < TERM_COUNT; k++) {
+		terms[k] = malloc(sample_count * sizeof(float));
+	}
+	results = malloc(sample_count * sizeof(float));
+	for(size_t i = 0; i < sample_count; i++) {
+		Bitboard empty = ALL_SQUARES & ~(mine[i] | theirs[i]);
+		for(uint8_t n = 0; n < BATCH_LINE_TERMS; n++) {
+			terms[n][i] = line_terms[i][n];
+		}
+		terms[TERM_CENTRE][i] = (int)teeko_count(mine[i] & CENTRE) -
+				(int)teeko_count(theirs[i] & CENTRE);
+		terms[TERM_MOBILITY][i] = (int)teeko_count(teeko_neighbours(mine[i]) & empty) -
+				(int)teeko_count(teeko_neighbours(theirs[i]) & empty);
+		results[i] = samples[i].result;
+	}
+	free(mine);
+	free(theirs);
+	free(line_terms);
+}
+
+/*
+ * The error and its gradient. Each thread sums over its own share of the
+ * samples, between two barriers: the first lets them start once the main
+ * thread has set the weights, the second tells it they have all finished.
+ */
+typedef struct {
+	size_t first, last;
+	double error;
+	double gradient[TERM_COUNT];
+} Share;
+
+static Share* shares;
+static double weights[TERM_COUNT];
+static double scale;		// K, the evaluation is multiplied by it
+static uint8_t finished;
+static pthread_barrier_t start_barrier, done_barrier;
+
+static void sum_share(Share* share) {
+	float w[TERM_COUNT];
+	for(uint8_t k = 0; k < TERM_COUNT; k++) {
+		w[k] = weights[k] * scale;
+	}
+	double error = 0;
+	double gradient[TERM_COUNT] = { 0 };
+	for(size_t i = share->first; i < share->last; i++) {
+		float x = 0;
+		for(uint8_t k = 0; k < TERM_COUNT; k++) {
+			x += w[k] * terms[k][i];
+		}
+		float expected = 1.0f / (1.0f + expf(-x));
+		float difference = expected - results[i];
+		error += difference * difference;
+		float slope = difference * expected * (1.0f - expected);
+		for(uint8_t k = 0; k < TERM_COUNT; k++) {
+			gradient[k] += slope * terms[k][i];
+		}
+	}
+	share->error = error;
+	for(uint8_t k = 0; k < TERM_COUNT; k++) {
+		share->gradient[k] = 2 * scale * gradient[k];
+	}
+}
+
+static void* sum_main(void* argument) {
+	Share* share = argument;
+	for(;;) {
+		pthread_barrier_wait(&start_barrier);
+		if(finished) {
+			return NULL;
+		}
+		sum_share(share);
+		pthread_barrier_wait(&done_barrier);
+	}
+}
+
+// the mean squared error at weights and scale, and its gradient if wanted
+static double error_at(double* gradient) {
+	pthread_barrier_wait(&start_barrier);
+	sum_share(&shares[0]);
+	pthread_barrier_wait(&done_barrier);
+	double error = 0;
+	for(uint8_t k = 0; k < TERM_COUNT && gradient; k++) {
+		gradient[k] = 0;
+	}
+	for(unsigned t = 0; t < thread_count; t++) {
+		error += shares[t].error;
+		for(uint8_t k = 0; k < TERM_COUNT && gradient; k++) {
+			gradient[k] += shares[t].gradient[k] / sample_count;
+		}
+	}
+	return error / sample_count;
+}
+
+// the scale which best fits the starting weights, by golden section
+// search on its logarithm
+static void fit_scale(void) {
+	const double golden = 0.6180339887;
+	double low = log(1e-4), high = log(10.0);
+	double a = high - golden * (high - low), b = low + golden * (high - low);
+	scale = exp(a);
+	double error_a = error_at(NULL);
+	scale = exp(b);
+	double error_b = error_at(NULL);
+	while(high - low > 1e-4) {
+		if(error_a < error_b) {
+			high = b;
+			b = a;
+			error_b = error_a;
+			a = high - golden * (high - low);
+			scale = exp(a);
+			error_a = error_at(NULL);
+		} else {
+			low = a;
+			a = b;
+			error_a = error_b;
+			b = low + golden * (high - low);
+			scale = exp(b);
+			error_b = error_at(NULL);
+		}
+	}
+	scale = exp((low + high) / 2);
+}
+
+// Adam, which copes with terms of very different sizes (there are many
+// more open lines of one than of three)
+static void descend(void) {
+	const double beta1 = 0.9, beta2 = 0.999;
+	double moment[TERM_COUNT] = { 0 }, variance[TERM_COUNT] = { 0 };
+	double gradient[TERM_COUNT];
+	for(uint32_t step = 1; step <= iterations; step++) {
+		double error = error_at(gradient);
+		for(uint8_t k = 0; k < TERM_COUNT; k++) {
+			moment[k] = beta1 * moment[k] + (1 - beta1) * gradient[k];
+			variance[k] = beta2 * variance[k] + (1 - beta2) * gradient[k] * gradient[k];
+			double m = moment[k] / (1 - pow(beta1, step));
+			double v = variance[k] / (1 - pow(beta2, step));
+			weights[k] -= rate * m / (sqrt(v) + 1e-12);
+		}
+		if(step % 500 == 0 || step == iterations) {
+			fprintf(stderr, "step %u: error %.6f\n", step, error);
+		}
+	}
+}
+
+static void start_threads(pthread_t* threads) {
+	shares = calloc(thread_count, sizeof(Share));
+	for(unsigned t = 0; t < thread_count; t++) {
+		shares[t].first = sample_count * t / thread_count;
+		shares[t].last = sample_count * (t + 1) / thread_count;
+	}
+	pthread_barrier_init(&start_barrier, NULL, thread_count);
+	pthread_barrier_init(&done_barrier, NULL, thread_count);
+	// the main thread sums the first share itself
+	for(unsigned t = 1; t < thread_count; t++) {
+		pthread_create(&threads[t], NULL, sum_main, &shares[t]);
+	}
+}
+
+static void stop_threads(pthread_t* threads) {
+	finished = 1;
+	pthread_barrier_wait(&start_barrier);
+	for(unsigned t = 1; t < thread_count; t++) {
+		pthread_join(threads[t], NULL);
+	}
+	pthread_barrier_destroy(&start_barrier);
+	pthread_barrier_destroy(&done_barrier);
+	free(shares);
+}
+
+static int write_weights(const EvalWeights* fitted, double error, double start_error) {
+	FILE* file = strcmp(out_path, "-") == 0 ? stdout : fopen(out_path, "w");
+	if(!file) {
+		perror(out_path);
+		return 0;
+	}
+	fprintf(file, "/*\n"
+			" * engine_weights.h\n"
+			" *\n"
+			" * The default evaluation weights (see EvalWeights in engine.h), kept in\n"
+			" * flash. Included once, by engine.c. Written by build/tune, fitted to\n"
+			" * %zu positions with K = %.5f: error %.6f (%.6f before).\n"
+			" */\n"
+			"\n"
+			"const EvalWeights engine_default_weights PROGMEM = {\n"
+			"\t.line = {%d, %d, %d, %d},\n"
+			"\t.centre = %d,\n"
+			"\t.mobility = %d\n"
+			"};\n", sample_count, scale, error, start_error,
+			fitted->line[0], fitted->line[1], fitted->line[2], fitted->line[3],
+			fitted->centre, fitted->mobility);
+	return file == stdout ? fflush(file) == 0 : fclose(file) == 0;
+}
+
+static void usage(const char* program) {
+	fprintf(stderr, "usage: %s [options]\n"
+			"  --games N          self-play games to take positions from (default 10000)\n"
+			"  --depth N          search depth per move in self-play (default 2)\n"
+			"  --random-plies N   random moves at the start of each game (default 8)\n"
+			"  --random-moves N   percentage of later moves made at random (default 10)\n"
+			"  --max-plies N      plies before a game is drawn (default 200)\n"
+			"  --seed N           seed for the random openings (default 1)\n"
+			"  --positions FILE   take the positions from FILE instead of self-play\n"
+			"  --save FILE        write the positions used to FILE\n"
+			"  --iterations N     steps of gradient descent (default 2000)\n"
+			"  --rate X           step size (default 0.5)\n"
+			"  --threads N        worker threads (default: one per core)\n"
+			"  --out FILE         write the weights header to FILE (default stdout)\n",
+			program);
+}
+
+int main(int argc, char** argv) {
+	for(int i = 1; i < argc; i++) {
+		const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+		if(!value) {
+			usage(argv[0]);
+			return 2;
+		}
+		if(strcmp(argv[i], "--games") == 0) {
+			game_count = strtoul(value, NULL, 10);
+		} else if(strcmp(argv[i], "--depth") == 0) {
+			limits.max_depth = atoi(value);
+		} else if(strcmp(argv[i], "--random-plies") == 0) {
+			random_plies = atoi(value);
+		} else if(strcmp(argv[i], "--random-moves") == 0) {
+			random_percent = atoi(value);
+		} else if(strcmp(argv[i], "--max-plies") == 0) {
+			max_plies = atoi(value);
+		} else if(strcmp(argv[i], "--seed") == 0) {
+			seed = strtoul(value, NULL, 10);
+		} else if(strcmp(argv[i], "--positions") == 0) {
+			positions_path = value;
+		} else if(strcmp(argv[i], "--save") == 0) {
+			save_path = value;
+		} else if(strcmp(argv[i], "--iterations") == 0) {
+			iterations = strtoul(value, NULL, 10);
+		} else if(strcmp(argv[i], "--rate") == 0) {
+			rate = atof(value);
+		} else if(strcmp(argv[i], "--threads") == 0) {
+			thread_count = atoi(value);
+		} else if(strcmp(argv[i], "--out") == 0) {
+			out_path = value;
+		} else {
+			usage(argv[0]);
+			return 2;
+		}
+		i++;
+	}
+	if(max_plies == 0) {
+		usage(argv[0]);
+		return 2;
+	}
+	if(thread_count == 0) {
+		long cores = sysconf(_SC_NPROCESSORS_ONLN);
+		thread_count = cores > 0 ? cores : 1;
+	}
+
+	uint64_t start = now_us();
+	if(positions_path) {
+		if(!read_positions(positions_path)) {
+			return 1;
+		}
+	} else {
+		self_play();
+	}
+	if(sample_count == 0) {
+		fprintf(stderr, "no positions to fit\n");
+		return 1;
+	}
+	fprintf(stderr, "%zu positions in %.2f s\n", sample_count, (now_us() - start) / 1e6);
+	if(save_path && !save_positions(save_path)) {
+		return 1;
+	}
+
+	start = now_us();
+	extract_terms();
+	fprintf(stderr, "terms counted in %.3f s (%s)\n", (now_us() - start) / 1e6,
+			batch_isa_name(batch_best_isa()));
+
+	EvalWeights fitted;
+	memcpy(&fitted, &engine_default_weights, sizeof(fitted));
+	for(uint8_t n = 0; n < BATCH_LINE_TERMS; n++) {
+		weights[n] = fitted.line[n + 1];
+	}
+	weights[TERM_CENTRE] = fitted.centre;
+	weights[TERM_MOBILITY] = fitted.mobility;
+
+	start = now_us();
+	pthread_t* threads = malloc(thread_count * sizeof(*threads));
+	start_threads(threads);
+	fit_scale();
+	double start_error = error_at(NULL);
+	fprintf(stderr, "K = %.5f, error %.6f\n", scale, start_error);
+	descend();
+
+	for(uint8_t n = 0; n < BATCH_LINE_TERMS; n++) {
+		fitted.line[n + 1] = lround(weights[n]);
+		weights[n] = fitted.line[n + 1];
+	}
+	fitted.centre = lround(weights[TERM_CENTRE]);
+	fitted.mobility = lround(weights[TERM_MOBILITY]);
+	weights[TERM_CENTRE] = fitted.centre;
+	weights[TERM_MOBILITY] = fitted.mobility;
+	double error = error_at(NULL);
+	stop_threads(threads);
+	free(threads);
+
+	for(uint8_t k = 0; k < TERM_COUNT; k++) {
+		fprintf(stderr, "%-9s %6.0f\n", term_names[k], weights[k]);
+	}
+	fprintf(stderr, "error %.6f with the weights rounded, %.2f s\n", error,
+			(now_us() - start) / 1e6);
+	return write_weights(&fitted, error, start_error) ? 0 : 1;
+}
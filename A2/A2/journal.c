@@ -0,0 +1,179 @@
+/*
+ * journal.c
+ *
+ * EEPROM journal of the game in progress (see journal.h for the format)
+ */
+
+#include "journal.h"
+#include "game.h"
+#include "hal.h"
+#include "teeko.h"
+
+// squares must fit in the 5 bit values of an entry
+#define JOURNAL_ENABLED (NUM_SQUARES <= 32)
+
+#define LAP_BIT			0x80
+#define TYPE_MASK		0x60
+#define TYPE_SQUARE		0x00
+#define TYPE_MARKER		0x20
+#define TYPE_MOVE		0x40
+#define VALUE_MASK		0x1F
+#define MARKER_START	(TYPE_MARKER | 0x01)
+#define MARKER_OVER		(TYPE_MARKER | 0x02)
+#define MARKER_UNDO		(TYPE_MARKER | 0x03)
+// plus the player the computer plays
+#define MARKER_COMPUTER	(TYPE_MARKER | 0x04)
+
+// next EEPROM offset (0 to JOURNAL_SIZE-1) to write, and the lap bit to
+// write it with
+static uint16_t write_pos;
+static uint8_t write_lap;
+
+// bytes waiting to be written to EEPROM. A move is always queued whole;
+// if there isn't room the oldest bytes are written first, waiting for the
+// EEPROM, so nothing is lost.
+#ifndef JOURNAL_QUEUE_SIZE
+#define JOURNAL_QUEUE_SIZE 8
+#endif
+#define QUEUE_SIZE JOURNAL_QUEUE_SIZE
+static uint8_t queue[QUEUE_SIZE];
+static uint8_t queue_head;
+static uint8_t queue_length;
+
+// offset of the first byte after the start marker of an unfinished game,
+// or JOURNAL_SIZE if there isn't one, and the player the computer plays in
+// it (0 if nobody)
+static uint16_t resume_pos;
+static uint8_t resume_computer;
+
+static uint8_t read_entry(uint16_t pos) {
+	return hal_eeprom_read(JOURNAL_START + pos);
+}
+
+static uint16_t next_pos(uint16_t pos) {
+	return (pos + 1 == JOURNAL_SIZE) ? 0 : pos + 1;
+}
+
+void init_journal(void) {
+	// The write position is the first byte whose lap bit differs from
+	// the first byte's. If they all match the ring has just been filled
+	// and we start the next lap from the beginning.
+	uint8_t lap = read_entry(0) & LAP_BIT;
+	write_pos = 0;
+	write_lap = lap ^ LAP_BIT;
+	for(uint16_t pos = 1; pos < JOURNAL_SIZE; pos++) {
+		if((read_entry(pos) & LAP_BIT) != lap) {
+			write_pos = pos;
+			write_lap = lap;
+			break;
+		}
+	}
+	queue_length = 0;
+
+	// Look backwards from the write position for the latest start or end
+	// marker. If it is the start of a game then that game can be resumed.
+	resume_pos = JOURNAL_SIZE;
+	resume_computer = 0;
+	uint16_t pos = write_pos;
+	for(uint16_t i = 0; i < JOURNAL_SIZE; i++) {
+		pos = (pos == 0) ? JOURNAL_SIZE - 1 : pos - 1;
+		uint8_t entry = read_entry(pos) & ~LAP_BIT;
+		if(entry == MARKER_START || entry == MARKER_COMPUTER + PLAYER_1 ||
+				entry == MARKER_COMPUTER + PLAYER_2) {
+			resume_pos = next_pos(pos);
+			resume_computer = (entry == MARKER_START) ? 0 : entry - MARKER_COMPUTER;
+			break;
+		} else if((entry & TYPE_MASK) == TYPE_MARKER && entry != MARKER_UNDO) {
+			break;
+		}
+	}
+}
+
+uint8_t journal_can_resume(void) {
+	return JOURNAL_ENABLED && resume_pos != JOURNAL_SIZE;
+}
+
+uint8_t journal_computer_player(void) {
+	return resume_computer;
+}
+
+uint8_t journal_resume(void) {
+	uint8_t replayed = 0;
+	uint16_t pos = resume_pos;
+
+	while(pos != write_pos) {
+		uint8_t entry = read_entry(pos) & ~LAP_BIT;
+		pos = next_pos(pos);
+		if((entry & TYPE_MASK) == TYPE_SQUARE) {
+			if(!game_place_piece(entry)) {
+				break;
+			}
+		} else if((entry & TYPE_MASK) == TYPE_MOVE && pos != write_pos) {
+			uint8_t to = read_entry(pos) & ~LAP_BIT;
+			pos = next_pos(pos);
+			if((to & TYPE_MASK) != TYPE_SQUARE ||
+					!game_move_piece(entry & VALUE_MASK, to)) {
+				break;
+			}
+		} else if(entry == MARKER_UNDO) {
+			if(!game_undo()) {
+				break;
+			}
+		} else {
+			// a move cut short by a reset, or something unexpected
+			break;
+		}
+		replayed++;
+	}
+	resume_pos = JOURNAL_SIZE;
+	return replayed;
+}
+
+static void queue_bytes(uint8_t count, uint8_t first, uint8_t second) {
+	if(!JOURNAL_ENABLED) {
+		return;
+	}
+	while(queue_length + count > QUEUE_SIZE) {
+		journal_service();
+	}
+	queue[(queue_head + queue_length++) % QUEUE_SIZE] = first;
+	if(count == 2) {
+		queue[(queue_head + queue_length++) % QUEUE_SIZE] = second;
+	}
+}
+
+void journal_new_game(uint8_t computer_player) {
+	resume_pos = JOURNAL_SIZE;
+	queue_bytes(1, computer_player ? MARKER_COMPUTER + computer_player : MARKER_START, 0);
+}
+
+void journal_game_over(void) {
+	resume_pos = JOURNAL_SIZE;
+	queue_bytes(1, MARKER_OVER, 0);
+}
+
+void journal_placement(uint8_t square) {
+	queue_bytes(1, TYPE_SQUARE | square, 0);
+}
+
+void journal_move(uint8_t from, uint8_t to) {
+	queue_bytes(2, TYPE_MOVE | from, TYPE_SQUARE | to);
+}
+
+void journal_undo(void) {
+	queue_bytes(1, MARKER_UNDO, 0);
+}
+
+void journal_service(void) {
+	if(queue_length == 0 || !hal_eeprom_ready()) {
+		return;
+	}
+	hal_eeprom_write(JOURNAL_START + write_pos, queue[queue_head] | write_lap);
+	queue_head = (queue_head + 1) % QUEUE_SIZE;
+	queue_length--;
+
+	write_pos = next_pos(write_pos);
+	if(write_pos == 0) {
+		write_lap ^= LAP_BIT;
+	}
+}
@@ -0,0 +1,81 @@
+/*
+ * journal.h
+ *
+ * Journal of the game in progress, kept in EEPROM so that a game
+ * survives a reset or power loss and can be resumed.
+ *
+ * Every placement is recorded as 1 byte and every move as 2. The journal
+ * is a ring spread over JOURNAL_SIZE bytes of EEPROM which is written
+ * straight through from one game to the next, so each byte is only
+ * written once per trip around the ring (wear levelling). Bytes are
+ * queued in RAM and written one at a time in the background by
+ * journal_service() as the EEPROM becomes ready, so recording only blocks
+ * the game (for about 3.4 ms a byte) when a burst of commands fills the
+ * queue.
+ *
+ * A game longer than the ring (about 380 moves in phase 2) writes over
+ * its own start marker, and can no longer be resumed.
+ *
+ * Each byte is one of
+ *     L00sssss    piece placed on square s (s = y*WIDTH + x)
+ *     L10fffff    piece moved from square f, the next byte
+ *     L00ttttt    gives the square t it moved to
+ *     L0100001    start of a game
+ *     L01001pp    start of a game against the computer, which plays
+ *                 player p
+ *     L0100010    end of a game
+ *     L0100011    the last placement or move was undone
+ *     L11xxxxx    unused (erased EEPROM)
+ * where L is the parity of the trip around the ring in which the byte
+ * was written. The write position is found at start up as the point
+ * where L changes, so no end marker (and no extra write) is needed.
+ *
+ * Squares take 5 bits, so games on boards of more than 32 squares are
+ * not journalled.
+ */
+
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+#include <stdint.h>
+
+// EEPROM bytes used by the journal
+#define JOURNAL_START 0
+#define JOURNAL_SIZE 768
+
+// find the write position in EEPROM, call once at start up
+void init_journal(void);
+
+// returns 1 if the journal holds a game which was not finished
+uint8_t journal_can_resume(void);
+
+// the player the computer plays in the unfinished game, or 0 if it is a
+// two player game
+uint8_t journal_computer_player(void);
+
+// fast-forward the unfinished game into the game state (without drawing
+// anything) and continue journalling it. initialise_game() must have been
+// called first. Returns the number of placements and moves replayed.
+uint8_t journal_resume(void);
+
+// record the start of a new game, in which the computer plays
+// computer_player (0 for a two player game)
+void journal_new_game(uint8_t computer_player);
+
+// record that the game has finished (so it won't be offered for resume).
+// A game over the link starts with this too, as the other board can't
+// resume it with us.
+void journal_game_over(void);
+
+// record a placement on, or a move between, squares (y*WIDTH + x)
+void journal_placement(uint8_t square);
+void journal_move(uint8_t from, uint8_t to);
+
+// record that the last placement or move was undone (a redo is recorded
+// as the placement or move again)
+void journal_undo(void);
+
+// write queued bytes to EEPROM, call this regularly
+void journal_service(void);
+
+#endif /* JOURNAL_H_ */
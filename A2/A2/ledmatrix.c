@@ -0,0 +1,148 @@
+/*
+ * ledmatrix.c
+ *
+ * Interrupt driven LED matrix driver (see ledmatrix.h)
+ */
+
+#include <string.h>
+#include "ledmatrix.h"
+#include "display.h"
+#include "hal.h"
+
+#define MATRIX_COLUMNS 16
+#define MATRIX_ROWS 8
+
+// the part of the board shown
+#define LED_COLUMNS (WIDTH < MATRIX_COLUMNS ? WIDTH : MATRIX_COLUMNS)
+#define LED_ROWS (HEIGHT < MATRIX_ROWS ? HEIGHT : MATRIX_ROWS)
+
+// commands understood by the matrix
+#define CMD_UPDATE_COLUMN 0x01	// then the column and a colour for each row
+#define CMD_CLEAR 0x0F
+
+// colours have green in the high nibble and red in the low one
+#define COLOUR_BLACK		0x00
+#define COLOUR_RED			0x0F
+#define COLOUR_GREEN		0xF0
+#define COLOUR_YELLOW		0xFF
+#define COLOUR_ORANGE		0x3C
+#define COLOUR_LIGHT_ORANGE	0x13
+#define COLOUR_LIGHT_YELLOW	0x35
+#define COLOUR_LIGHT_GREEN	0x11
+
+// colour of each object (display.h), a hinted piece shows as the piece
+static const uint8_t object_colours[] PROGMEM = {
+	[EMPTY_SQUARE] = COLOUR_BLACK,
+	[PLAYER_1] = COLOUR_GREEN,
+	[PLAYER_2] = COLOUR_RED,
+	[CURSOR] = COLOUR_YELLOW,
+	[CURSOR_PICKER] = COLOUR_ORANGE,
+	[SQUARE_PICKER] = COLOUR_LIGHT_YELLOW,
+	[THREAT_SQUARE] = COLOUR_LIGHT_ORANGE,
+	[HINT_SQUARE] = COLOUR_LIGHT_GREEN
+};
+
+// colour of each LED, drawn by the game and sent by the interrupt
+static uint8_t drawing[LED_COLUMNS][LED_ROWS];
+static uint8_t sending[LED_COLUMNS][LED_ROWS];
+
+// The transfer in progress. The interrupt owns these (and the sending
+// frame) while busy is set.
+static volatile uint8_t busy;
+static uint8_t clear_first;			// send CMD_CLEAR before the columns
+static uint16_t columns_to_send;	// bit per column
+static uint8_t column;
+static uint8_t byte_index;			// of the column's update command
+
+// send the next byte of the transfer, or finish it
+static void send_next_byte(void) {
+	if(byte_index == 0) {
+		if(clear_first) {
+			clear_first = 0;
+			hal_spi_write_byte(CMD_CLEAR);
+			return;
+		}
+		while(column < LED_COLUMNS && !(columns_to_send & (1 << column))) {
+			column++;
+		}
+		if(column == LED_COLUMNS) {
+			busy = 0;
+			return;
+		}
+		hal_spi_write_byte(CMD_UPDATE_COLUMN);
+	} else if(byte_index == 1) {
+		hal_spi_write_byte(column);
+	} else {
+		// rows beyond the board are black
+		uint8_t row = byte_index - 2;
+		hal_spi_write_byte(row < LED_ROWS ? sending[column][row] : COLOUR_BLACK);
+	}
+	if(++byte_index == 2 + MATRIX_ROWS) {
+		byte_index = 0;
+		columns_to_send &= ~(1 << column);
+		column++;
+	}
+}
+
+HAL_ISR(SPI_STC_vect) {
+	send_next_byte();
+}
+
+void init_led_matrix(void) {
+	hal_spi_init();
+}
+
+static void led_matrix_init(void) {
+	memset(drawing, COLOUR_BLACK, sizeof(drawing));
+	if(busy) {
+		// the next flush after the frame has gone sends the black one
+		return;
+	}
+	memset(sending, COLOUR_BLACK, sizeof(sending));
+	uint8_t interrupts_were_on = hal_disable_interrupts();
+	clear_first = 1;
+	columns_to_send = 0;
+	column = 0;
+	byte_index = 0;
+	busy = 1;
+	send_next_byte();
+	hal_restore_interrupts(interrupts_were_on);
+}
+
+static void led_matrix_set_cell(uint8_t x, uint8_t y, uint8_t object) {
+	if(x < LED_COLUMNS && y < LED_ROWS) {
+		if(object & CURSOR_MARK) {
+			object = CURSOR;
+		} else if(object & CURSOR_PICKER_MARK) {
+			object = CURSOR_PICKER;
+		}
+		drawing[x][y] = pgm_read_byte(&object_colours[OBJECT(object)]);
+	}
+}
+
+static void led_matrix_flush(void) {
+	if(busy) {
+		return;
+	}
+	uint16_t changed = 0;
+	for(uint8_t x = 0; x < LED_COLUMNS; x++) {
+		if(memcmp(sending[x], drawing[x], LED_ROWS) != 0) {
+			memcpy(sending[x], drawing[x], LED_ROWS);
+			changed |= 1 << x;
+		}
+	}
+	if(!changed) {
+		return;
+	}
+	uint8_t interrupts_were_on = hal_disable_interrupts();
+	columns_to_send = changed;
+	column = 0;
+	byte_index = 0;
+	busy = 1;
+	send_next_byte();
+	hal_restore_interrupts(interrupts_were_on);
+}
+
+const DisplayBackend led_matrix_display = {
+	led_matrix_init, led_matrix_set_cell, led_matrix_flush
+};
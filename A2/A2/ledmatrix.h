@@ -0,0 +1,23 @@
+/*
+ * ledmatrix.h
+ *
+ * Driver for the 16x8 LED matrix, which shows the board one LED per
+ * square (squares beyond the matrix are not shown). It is drawn through
+ * the display backend led_matrix_display (see display.h).
+ *
+ * The matrix is sent columns of colours over the SPI by the transfer
+ * complete interrupt, a byte at a time, so the game loop never waits for
+ * it. Frames are double buffered: the board is drawn into one frame while
+ * the interrupt sends the other, and a flush copies across and sends only
+ * the columns which have changed. A flush while a frame is still being
+ * sent does nothing, and the next one sends the latest frame.
+ */
+
+#ifndef LEDMATRIX_H_
+#define LEDMATRIX_H_
+
+// set up the SPI for the matrix, call once at start up (the display is
+// cleared by initialise_display())
+void init_led_matrix(void);
+
+#endif /* LEDMATRIX_H_ */
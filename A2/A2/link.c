@@ -0,0 +1,318 @@
+/*
+ * link.c
+ *
+ * A game between two boards over the link port (see link.h)
+ *
+ * The board's own moves aren't passed in: link_service() compares the
+ * game with the position both boards last agreed on (synced), and when
+ * this board has moved it works out the move from the pieces which
+ * changed. Moves from the other board are checked against synced and
+ * made with play_move(), as the computer player's are.
+ */
+
+#include "link.h"
+#include "hal.h"
+#include "game.h"
+#include "display.h"
+#include "terminalio.h"
+#include "timer0.h"
+
+#if NUM_SQUARES > 63
+#error "link frames have room for square numbers up to 62"
+#endif
+
+#define FRAME_MOVE 0x80
+#define FRAME_NEW_GAME 0x50
+#define FRAME_ACK 0x60
+#define FRAME_PLACE 63
+
+// moves (and new games, as MOVE_NONE) waiting to be sent, the first in
+// flight if in_flight is set
+#define LINK_QUEUE_SIZE 4
+static Move queue[LINK_QUEUE_SIZE];
+static uint8_t queue_head, queue_count;
+static uint8_t in_flight;
+static uint8_t send_seq;
+static uint32_t first_sent, last_sent;
+
+// the frame being transmitted by the interrupt, and an ack to go out
+// between frames (0 if none)
+static volatile uint8_t tx_frame[2];
+static volatile uint8_t tx_length, tx_pos;
+static volatile uint8_t tx_ack;
+
+// bytes received by the interrupt, waiting for link_service()
+#define LINK_BUFFER_SIZE 16
+static volatile uint8_t rx_buffer[LINK_BUFFER_SIZE];
+static volatile uint8_t rx_head, bytes_in_rx_buffer;
+static uint8_t first_byte;		// of a move frame, 0 if none
+static uint8_t receive_seq;		// of the next new frame
+static uint8_t invite_repeatable;	// a new game frame may arrive again
+
+static uint8_t local_player;	// 0 if not playing over the link
+static uint8_t local_game;		// a game on this board alone is in progress
+static uint8_t invited;
+static Position synced;
+
+static LinkStats stats;
+static uint8_t stats_changed;
+
+static void received(uint8_t byte) {
+	if(bytes_in_rx_buffer < LINK_BUFFER_SIZE) {
+		rx_buffer[(rx_head + bytes_in_rx_buffer) % LINK_BUFFER_SIZE] = byte;
+		bytes_in_rx_buffer++;
+	} else {
+		stats.rx_overruns++;
+	}
+}
+
+static int16_t next_byte(void) {
+	if(tx_ack && (tx_pos == 0 || tx_pos == tx_length)) {
+		uint8_t ack = tx_ack;
+		tx_ack = 0;
+		return ack;
+	}
+	if(tx_pos < tx_length) {
+		return tx_frame[tx_pos++];
+	}
+	return -1;
+}
+
+void init_link(void) {
+	hal_link_init(received, next_byte);
+}
+
+// (re)send the frame at the head of the queue
+static void transmit(void) {
+	Move move = queue[queue_head];
+	uint8_t interrupts_on = hal_disable_interrupts();
+	if(move == MOVE_NONE) {
+		tx_frame[0] = FRAME_NEW_GAME | send_seq;
+		tx_length = 1;
+	} else {
+		uint8_t from = MOVE_FROM(move) == MOVE_PLACE ? FRAME_PLACE : MOVE_FROM(move);
+		tx_frame[0] = FRAME_MOVE | send_seq << 6 | from;
+		tx_frame[1] = MOVE_TO(move);
+		tx_length = 2;
+	}
+	tx_pos = 0;
+	hal_restore_interrupts(interrupts_on);
+	hal_link_start();
+	last_sent = get_current_time();
+}
+
+static void send_ack(uint8_t seq) {
+	uint8_t interrupts_on = hal_disable_interrupts();
+	tx_ack = FRAME_ACK | seq;
+	hal_restore_interrupts(interrupts_on);
+	hal_link_start();
+}
+
+static void send(Move move) {
+	if(queue_count < LINK_QUEUE_SIZE) {
+		queue[(queue_head + queue_count) % LINK_QUEUE_SIZE] = move;
+		queue_count++;
+	}
+}
+
+// forget anything still to be sent
+static void clear_queue(void) {
+	uint8_t interrupts_on = hal_disable_interrupts();
+	tx_length = tx_pos = 0;
+	hal_restore_interrupts(interrupts_on);
+	queue_count = 0;
+	in_flight = 0;
+}
+
+void link_new_game(uint8_t player) {
+	local_player = player;
+	invited = 0;
+	synced = *game_position();
+	// A game on this board alone doesn't listen to the link, and an
+	// invite from the other board waits (unacknowledged) until it ends
+	local_game = !player;
+	hal_link_enable(player);
+	if(!player) {
+		clear_queue();
+	}
+	if(player == PLAYER_1) {
+		clear_queue();
+		receive_seq = 0;
+		invite_repeatable = 0;
+		send(MOVE_NONE);
+	}
+	stats_changed = 1;
+}
+
+void link_game_over(void) {
+	if(local_game) {
+		local_game = 0;
+		hal_link_enable(1);
+	}
+}
+
+uint8_t link_invited(void) {
+	return invited;
+}
+
+uint8_t link_playing(void) {
+	return local_player != 0;
+}
+
+uint8_t link_remote_to_move(void) {
+	return local_player && game_position()->to_move != local_player;
+}
+
+static uint8_t square_of(Bitboard bit) {
+	uint8_t square = 0;
+	while(bit > 1) {
+		bit >>= 1;
+		square++;
+	}
+	return square;
+}
+
+// the move this board has made since synced, or MOVE_NONE
+static Move local_move(void) {
+	const Position* position = game_position();
+	if(synced.to_move != local_player || position->to_move == local_player) {
+		return MOVE_NONE;
+	}
+	Bitboard before = synced.pieces[local_player - 1];
+	Bitboard after = position->pieces[local_player - 1];
+	uint8_t to = square_of(after & ~before);
+	if(teeko_placing(&synced)) {
+		return MAKE_MOVE(MOVE_PLACE, to);
+	}
+	return MAKE_MOVE(square_of(before & ~after), to);
+}
+
+static void move_received(uint8_t first, uint8_t second) {
+	uint8_t seq = (first >> 6) & 1;
+	uint8_t from = first & 0x3F;
+	Move move = MAKE_MOVE(from == FRAME_PLACE ? MOVE_PLACE : from, second);
+	if(!local_player) {
+		return;
+	}
+	if(seq != receive_seq) {
+		// seen before, its ack was lost
+		send_ack(seq);
+		return;
+	}
+	// Anything else which isn't a legal move for the other board is left
+	// unacknowledged. It is from an earlier game, and will stop when the
+	// other board takes up the new one.
+	if(synced.to_move == local_player || !teeko_is_legal(&synced, move)) {
+		return;
+	}
+	teeko_make(&synced, move);
+	play_move(move);
+	receive_seq ^= 1;
+	invite_repeatable = 0;
+	send_ack(seq);
+}
+
+static void new_game_received(uint8_t seq) {
+	if(local_game) {
+		return;
+	}
+	send_ack(seq);
+	if(invite_repeatable && seq != receive_seq) {
+		return;
+	}
+	// the other board has started again, drop whatever we were sending
+	clear_queue();
+	send_seq = 0;
+	receive_seq = seq ^ 1;
+	invite_repeatable = 1;
+	invited = 1;
+}
+
+static void ack_received(uint8_t seq) {
+	if(!in_flight || seq != send_seq) {
+		return;
+	}
+	uint32_t latency = get_current_time() - first_sent;
+	stats.acked++;
+	stats.last_latency = latency;
+	stats.total_latency += latency;
+	if(latency > stats.max_latency) {
+		stats.max_latency = latency;
+	}
+	stats_changed = 1;
+	in_flight = 0;
+	queue_head = (queue_head + 1) % LINK_QUEUE_SIZE;
+	queue_count--;
+	send_seq ^= 1;
+}
+
+static void frame_byte(uint8_t byte) {
+	if(byte & FRAME_MOVE) {
+		first_byte = byte;
+	} else if(!(byte & 0x40)) {
+		// the second byte of a move, unless the first was lost
+		if(first_byte) {
+			move_received(first_byte, byte);
+		}
+		first_byte = 0;
+	} else {
+		first_byte = 0;
+		if((byte & ~1) == FRAME_ACK) {
+			ack_received(byte & 1);
+		} else if((byte & ~1) == FRAME_NEW_GAME) {
+			new_game_received(byte & 1);
+		}
+	}
+}
+
+void link_service(void) {
+	if(local_player) {
+		Move move = local_move();
+		if(move != MOVE_NONE) {
+			teeko_make(&synced, move);
+			send(move);
+		}
+	}
+
+	while(bytes_in_rx_buffer) {
+		uint8_t interrupts_on = hal_disable_interrupts();
+		uint8_t byte = rx_buffer[rx_head];
+		rx_head = (rx_head + 1) % LINK_BUFFER_SIZE;
+		bytes_in_rx_buffer--;
+		hal_restore_interrupts(interrupts_on);
+		frame_byte(byte);
+	}
+
+	if(!in_flight && queue_count) {
+		in_flight = 1;
+		stats.frames++;
+		transmit();
+		first_sent = last_sent;
+	} else if(in_flight && get_current_time() - last_sent >= LINK_RETRY_TIME) {
+		stats.retransmits++;
+		stats_changed = 1;
+		transmit();
+	}
+}
+
+const LinkStats* link_stats(void) {
+	return &stats;
+}
+
+void link_reset_stats(void) {
+	uint8_t interrupts_on = hal_disable_interrupts();
+	stats = (LinkStats){ 0 };
+	hal_restore_interrupts(interrupts_on);
+	stats_changed = 1;
+}
+
+void draw_link_stats(void) {
+	if(!local_player || !stats_changed) {
+		return;
+	}
+	stats_changed = 0;
+	move_terminal_cursor(10, TERMINAL_BOARD_Y + 2 * HEIGHT + 2);
+	normal_display_mode();
+	printf_P(PSTR("linked as player %u: sync %ums (max %ums), %u retransmits  "),
+			local_player, stats.last_latency, stats.max_latency, stats.retransmits);
+}
@@ -0,0 +1,71 @@
+/*
+ * link.h
+ *
+ * A game between two boards joined by the link port (see hal.h). Each
+ * board has its own display and buttons and only the moves go over the
+ * link, in frames of one or two bytes:
+ *
+ *   move      1sffffff 00tttttt   from square f (63 for a placement) to t
+ *   new game  0101000s
+ *   ack       0110000s            the frame with sequence bit s arrived
+ *
+ * A board has one frame at a time in flight and sends it again every
+ * LINK_RETRY_TIME ms until it is acknowledged. The sequence bit
+ * alternates from frame to frame, so a frame which arrives twice (because
+ * its ack was lost) is acknowledged again but acted on only once. Moves
+ * wait in a queue behind the frame in flight, so play never waits for
+ * the other board.
+ */
+
+#ifndef LINK_H_
+#define LINK_H_
+
+#include <stdint.h>
+
+// how long to wait for an ack before sending a frame again (ms)
+#define LINK_RETRY_TIME 250
+
+typedef struct {
+	uint16_t frames;		// sent, not counting retransmissions
+	uint16_t retransmits;
+	uint16_t acked;
+	uint16_t last_latency;	// ms from first sending a frame to its ack
+	uint16_t max_latency;
+	uint32_t total_latency;	// of all the acked frames
+	uint16_t rx_overruns;	// bytes lost because the receive buffer was full
+} LinkStats;
+
+// set up the link port, call once at start up
+void init_link(void);
+
+// Start a new game played over the link, where this board plays player
+// (PLAYER_1 or PLAYER_2), or 0 for a game on this board alone. Player 1
+// asks the other board to start the game too.
+void link_new_game(uint8_t player);
+
+// A game on this board alone has ended, so the other board may start
+// one. (Invites aren't taken during a game on this board alone.)
+void link_game_over(void);
+
+// returns 1 if the other board has started a new game, in which this
+// board plays player 2
+uint8_t link_invited(void);
+
+// returns 1 if this game is played over the link
+uint8_t link_playing(void);
+
+// returns 1 while it is the other board's turn (this one can't move)
+uint8_t link_remote_to_move(void);
+
+// send this board's moves, make the other board's and look after
+// retransmission. Call this regularly from the main loop.
+void link_service(void);
+
+const LinkStats* link_stats(void);
+void link_reset_stats(void);
+
+// show the sync latency and retransmissions under the board if they have
+// changed
+void draw_link_stats(void);
+
+#endif /* LINK_H_ */
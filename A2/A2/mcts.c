@@ -0,0 +1,329 @@
+/*
+ * mcts.c
+ *
+ * Monte Carlo tree search (see mcts.h)
+ *
+ * The free list is a stack of chains of siblings. Each chain runs through
+ * the sibling links and the first node of a chain keeps the next chain in
+ * next_chain, so a whole subtree is freed by pushing its root as a chain
+ * of one. Taking a node pops it from the top chain and pushes its children
+ * (if it had any) as a new chain, which is constant time either way.
+ */
+
+#include <math.h>
+#include "mcts.h"
+
+// exploration constant of UCB1
+#define EXPLORATION 1.4f
+
+// stop before the 16-bit counters of the root could overflow
+#define MAX_VISITS 32000
+
+// Children are added in a fixed order which strides across the move list
+// (251 is prime and larger than any move list), so a small tree spreads
+// over the board rather than filling in the first few squares.
+#define EXPAND_STRIDE 251
+
+static uint32_t next_random(MctsTree* tree) {
+	uint32_t x = tree->random;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return tree->random = x;
+}
+
+static MctsIndex take_node(MctsTree* tree) {
+	MctsIndex index = tree->free;
+	if(index == MCTS_NONE) {
+		return MCTS_NONE;
+	}
+	MctsNode* node = &tree->pool[index];
+	if(node->sibling != MCTS_NONE) {
+		// the rest of the chain stays on top
+		tree->free = node->sibling;
+		tree->pool[node->sibling].next_chain = node->next_chain;
+	} else {
+		tree->free = node->next_chain;
+	}
+	if(node->child != MCTS_NONE) {
+		tree->pool[node->child].next_chain = tree->free;
+		tree->free = node->child;
+	}
+	return index;
+}
+
+static void free_subtree(MctsTree* tree, MctsIndex index) {
+	MctsNode* node = &tree->pool[index];
+	node->sibling = MCTS_NONE;
+	node->next_chain = tree->free;
+	tree->free = index;
+}
+
+// a node for the position reached by move, or MCTS_NONE if the pool is
+// used up
+static MctsIndex new_node(MctsTree* tree, const Position* position, Move move) {
+	MctsIndex index = take_node(tree);
+	if(index == MCTS_NONE) {
+		return MCTS_NONE;
+	}
+	MctsNode* node = &tree->pool[index];
+	Move moves[MAX_MOVES];
+	node->move = move;
+	node->child = MCTS_NONE;
+	node->sibling = MCTS_NONE;
+	node->visits = 0;
+	node->score = 0;
+	node->tried = 0;
+	node->move_count = teeko_winner(position) ? 0 : teeko_generate_moves(position, moves);
+	return index;
+}
+
+void mcts_init(MctsTree* tree, MctsNode* pool, MctsIndex pool_size, uint32_t seed) {
+	tree->pool = pool;
+	tree->pool_size = pool_size;
+	for(MctsIndex i = 0; i < pool_size; i++) {
+		pool[i].child = MCTS_NONE;
+		pool[i].sibling = (i + 1 < pool_size) ? i + 1 : MCTS_NONE;
+	}
+	if(pool_size) {
+		pool[0].next_chain = MCTS_NONE;
+	}
+	tree->free = pool_size ? 0 : MCTS_NONE;
+	tree->root = MCTS_NONE;
+	tree->random = seed ? seed : 1;
+}
+
+static uint8_t same_position(const Position* a, const Position* b) {
+	return a->pieces[0] == b->pieces[0] && a->pieces[1] == b->pieces[1] &&
+			a->to_move == b->to_move;
+}
+
+// take child out of its parent's list of children
+static void detach(MctsTree* tree, MctsIndex parent, MctsIndex child) {
+	MctsIndex* link = &tree->pool[parent].child;
+	while(*link != child) {
+		link = &tree->pool[*link].sibling;
+	}
+	*link = tree->pool[child].sibling;
+	tree->pool[child].sibling = MCTS_NONE;
+}
+
+// the node below parent for the position one move on, or MCTS_NONE
+static MctsIndex find_child(MctsTree* tree, MctsIndex parent, const Position* from,
+		const Position* target) {
+	for(MctsIndex c = tree->pool[parent].child; c != MCTS_NONE; c = tree->pool[c].sibling) {
+		Position next = *from;
+		teeko_make(&next, tree->pool[c].move);
+		if(same_position(&next, target)) {
+			return c;
+		}
+	}
+	return MCTS_NONE;
+}
+
+// Move the root down to the position if it is one or two moves on,
+// freeing the rest of the tree. Returns 0 if it isn't.
+static uint8_t reroot(MctsTree* tree, const Position* position) {
+	MctsIndex root = tree->root;
+	if(same_position(&tree->position, position)) {
+		return 1;
+	}
+	MctsIndex parent = root;
+	MctsIndex found = find_child(tree, root, &tree->position, position);
+	for(MctsIndex c = tree->pool[root].child; found == MCTS_NONE && c != MCTS_NONE;
+			c = tree->pool[c].sibling) {
+		Position next = tree->position;
+		teeko_make(&next, tree->pool[c].move);
+		found = find_child(tree, c, &next, position);
+		parent = c;
+	}
+	if(found == MCTS_NONE) {
+		return 0;
+	}
+	detach(tree, parent, found);
+	free_subtree(tree, root);
+	tree->root = found;
+	tree->position = *position;
+	return 1;
+}
+
+void mcts_start(MctsTree* tree, const Position* position, const SearchLimits* limits) {
+	if(tree->root != MCTS_NONE && !reroot(tree, position)) {
+		free_subtree(tree, tree->root);
+		tree->root = MCTS_NONE;
+	}
+	if(tree->root == MCTS_NONE) {
+		tree->position = *position;
+		tree->root = new_node(tree, position, MOVE_NONE);
+	}
+	tree->iterations = 0;
+	tree->start_time = limits->clock ? limits->clock() : 0;
+}
+
+// the child to walk down to by UCB1
+static MctsIndex select_child(const MctsTree* tree, const MctsNode* parent) {
+	float log_visits = logf(parent->visits);
+	float best_value = -1;
+	MctsIndex best = MCTS_NONE;
+	for(MctsIndex c = parent->child; c != MCTS_NONE; c = tree->pool[c].sibling) {
+		const MctsNode* child = &tree->pool[c];
+		float value = child->score / (2.0f * child->visits) +
+				EXPLORATION * sqrtf(log_visits / child->visits);
+		if(value > best_value) {
+			best_value = value;
+			best = c;
+		}
+	}
+	return best;
+}
+
+// play random moves to the end of the game, returns the winner or 0
+static uint8_t playout(MctsTree* tree, Position* position) {
+	for(uint8_t ply = 0; ply < MCTS_PLAYOUT_PLIES; ply++) {
+		uint8_t winner = teeko_winner(position);
+		if(winner) {
+			return winner;
+		}
+		Move move;
+		if(teeko_placing(position)) {
+			// a random empty square
+			Bitboard empty = ALL_SQUARES & ~(position->pieces[0] | position->pieces[1]);
+			uint8_t skip = next_random(tree) % teeko_count(empty);
+			while(skip--) {
+				empty &= empty - 1;
+			}
+			uint8_t square = 0;
+			while(!(empty & SQUARE_BIT(square))) {
+				square++;
+			}
+			move = MAKE_MOVE(MOVE_PLACE, square);
+		} else {
+			Move moves[MAX_MOVES];
+			uint8_t count = teeko_generate_moves(position, moves);
+			if(count == 0) {
+				return 0;
+			}
+			move = moves[next_random(tree) % count];
+		}
+		teeko_make(position, move);
+	}
+	return teeko_winner(position);
+}
+
+static void iterate(MctsTree* tree) {
+	MctsIndex path[MCTS_MAX_PATH];
+	uint8_t length = 0;
+	Position position = tree->position;
+	MctsIndex index = tree->root;
+	path[length++] = index;
+
+	// down the tree while every move has a node, or the pool has run out
+	// and there is a node below
+	MctsNode* node = &tree->pool[index];
+	while(node->child != MCTS_NONE && length < MCTS_MAX_PATH &&
+			(node->tried == node->move_count || tree->free == MCTS_NONE)) {
+		index = select_child(tree, node);
+		node = &tree->pool[index];
+		teeko_make(&position, node->move);
+		path[length++] = index;
+	}
+
+	// add a node for the next untried move
+	if(node->move_count && node->tried < node->move_count && length < MCTS_MAX_PATH) {
+		Move moves[MAX_MOVES];
+		teeko_generate_moves(&position, moves);
+		Move move = moves[(uint16_t)node->tried * EXPAND_STRIDE % node->move_count];
+		teeko_make(&position, move);
+		MctsIndex child = new_node(tree, &position, move);
+		if(child != MCTS_NONE) {
+			node->tried++;
+			tree->pool[child].sibling = node->child;
+			node->child = child;
+			path[length++] = child;
+		}
+	}
+
+	uint8_t winner = playout(tree, &position);
+
+	// count the result for the player who made each move on the path
+	uint8_t mover = tree->position.to_move;	// moved into path[1]
+	for(uint8_t i = 0; i < length; i++) {
+		MctsNode* visited = &tree->pool[path[i]];
+		visited->visits++;
+		if(i > 0) {
+			visited->score += !winner ? 1 : (winner == mover) ? 2 : 0;
+			mover = 3 - mover;
+		}
+	}
+	tree->iterations++;
+}
+
+uint8_t mcts_run(MctsTree* tree, const SearchLimits* limits, uint16_t iterations) {
+	if(tree->root == MCTS_NONE) {
+		// no pool to search with
+		return 1;
+	}
+	const MctsNode* root = &tree->pool[tree->root];
+	while(1) {
+		if(root->move_count == 0 || root->visits >= MAX_VISITS) {
+			return 1;
+		}
+		if(limits->max_nodes && tree->iterations >= limits->max_nodes) {
+			return 1;
+		}
+		if(limits->max_time && limits->clock &&
+				limits->clock() - tree->start_time >= limits->max_time) {
+			return 1;
+		}
+		if(iterations-- == 0) {
+			return 0;
+		}
+		iterate(tree);
+	}
+}
+
+// the most visited child of a node
+static MctsIndex most_visited(const MctsTree* tree, MctsIndex parent) {
+	MctsIndex best = MCTS_NONE;
+	for(MctsIndex c = tree->pool[parent].child; c != MCTS_NONE; c = tree->pool[c].sibling) {
+		if(best == MCTS_NONE || tree->pool[c].visits > tree->pool[best].visits) {
+			best = c;
+		}
+	}
+	return best;
+}
+
+void mcts_result(const MctsTree* tree, SearchResult* result) {
+	result->move = MOVE_NONE;
+	result->reply = MOVE_NONE;
+	result->score = 0;
+	result->depth = 0;
+	result->nodes = tree->iterations;
+	if(tree->root == MCTS_NONE) {
+		return;
+	}
+	MctsIndex best = most_visited(tree, tree->root);
+	if(best != MCTS_NONE) {
+		const MctsNode* node = &tree->pool[best];
+		result->move = node->move;
+		result->score = node->visits ? (int32_t)node->score * 500 / node->visits : 0;
+		MctsIndex reply = most_visited(tree, best);
+		if(reply != MCTS_NONE) {
+			result->reply = tree->pool[reply].move;
+		}
+	} else if(tree->pool[tree->root].move_count) {
+		// no time to try anything, take the first legal move
+		Move moves[MAX_MOVES];
+		teeko_generate_moves(&tree->position, moves);
+		result->move = moves[0];
+	}
+}
+
+void mcts_search(MctsTree* tree, const Position* position, const SearchLimits* limits,
+		SearchResult* result) {
+	mcts_start(tree, position, limits);
+	while(!mcts_run(tree, limits, UINT16_MAX)) {
+		continue;
+	}
+	mcts_result(tree, result);
+}
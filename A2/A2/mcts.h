@@ -0,0 +1,85 @@
+/*
+ * mcts.h
+ *
+ * Computer player by Monte Carlo tree search (UCT), an alternative to the
+ * alpha-beta search in engine.h. Each iteration walks down the tree by
+ * the UCB1 rule, adds one node, plays random moves to the end of the game
+ * (or MCTS_PLAYOUT_PLIES) and counts the result back up the path.
+ *
+ * Nodes come from a pool the caller provides, a few hundred bytes on the
+ * AVR or millions of nodes on the host, and nothing is allocated. When
+ * the game moves on, the subtree under the new position is kept and the
+ * rest of the tree is freed in one step: a freed subtree goes on the free
+ * list whole, and its children are put back on the list only as the node
+ * above them is reused. When the pool runs out the tree stops growing and
+ * the search carries on with playouts from its leaves.
+ */
+
+#ifndef MCTS_H_
+#define MCTS_H_
+
+#include <stdint.h>
+#include "teeko.h"
+#include "engine.h"
+
+// moves in a playout before it is scored as a draw
+#ifndef MCTS_PLAYOUT_PLIES
+#define MCTS_PLAYOUT_PLIES 40
+#endif
+
+// deepest path walked down the tree in one iteration
+#define MCTS_MAX_PATH 24
+
+typedef uint16_t MctsIndex;
+#define MCTS_NONE 0xFFFF
+
+// 12 bytes on the AVR
+typedef struct {
+	Move move;			// the move made to reach this node
+	MctsIndex child;	// first child, or MCTS_NONE
+	MctsIndex sibling;	// next child of the same parent, or MCTS_NONE
+	union {
+		uint16_t visits;
+		MctsIndex next_chain;	// on the free list, see mcts.c
+	};
+	uint16_t score;		// half points (2 a win, 1 a draw) for the player
+						// who made the move
+	uint8_t tried;		// children added so far
+	uint8_t move_count;	// legal moves from here, 0 if the game is won
+} MctsNode;
+
+typedef struct {
+	MctsNode* pool;
+	MctsIndex pool_size;
+	MctsIndex free;		// free list
+	MctsIndex root;		// MCTS_NONE before the first search
+	Position position;	// at the root
+	uint32_t random;	// playout random number state
+	uint32_t iterations;	// since the search started
+	uint32_t start_time;
+} MctsTree;
+
+// set up a tree using pool (of up to 65534 nodes), with a random seed. With
+// no nodes at all every search returns MOVE_NONE.
+void mcts_init(MctsTree* tree, MctsNode* pool, MctsIndex pool_size, uint32_t seed);
+
+// Make the tree a search of position. If position is a child or a
+// grandchild of the old root that part of the tree is kept, otherwise the
+// search starts again. The clock in limits starts the time limit.
+void mcts_start(MctsTree* tree, const Position* position, const SearchLimits* limits);
+
+// Run up to iterations more iterations. Returns 1 once a limit (max_nodes
+// counts iterations, max_time in ms) is reached, or the root has been
+// visited as often as its counters allow.
+uint8_t mcts_run(MctsTree* tree, const SearchLimits* limits, uint16_t iterations);
+
+// the most visited move at the root and the most visited reply to it.
+// score is the per mille win rate for the player to move and nodes the
+// iterations run.
+void mcts_result(const MctsTree* tree, SearchResult* result);
+
+// mcts_start(), then mcts_run() until a limit is reached
+void mcts_search(MctsTree* tree, const Position* position, const SearchLimits* limits,
+		SearchResult* result);
+
+#endif /* MCTS_H_ */
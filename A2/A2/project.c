@@ -9,19 +9,22 @@
 
 #include <stdio.h>
 #include <stdint.h>
-#include <avr/io.h>
-#include <avr/interrupt.h>
-#include <avr/pgmspace.h>
-
-#define F_CPU 16000000L
-#include <util/delay.h>
 
+#include "hal.h"
 #include "game.h"
 #include "display.h"
 #include "buttons.h"
 #include "serialio.h"
 #include "terminalio.h"
 #include "timer0.h"
+#include "journal.h"
+#include "computer.h"
+#include "ledmatrix.h"
+#include "sound.h"
+#include "clock.h"
+#include "link.h"
+#include "health.h"
+#include "trace.h"
 
 // Function prototypes - these are defined below (after main()) in the order
 // given here
@@ -33,6 +36,18 @@ void handle_game_over(void);
 
 #define ESCAPE_CHAR 27
 
+// the cursor move (dx, dy) of each button
+static const int8_t button_moves[NUM_BUTTONS][2] = {
+	{ 0, -1 }, { 0, 1 }, { 1, 0 }, { -1, 0 }
+};
+
+// set by the start screen if the game saved in the journal is to be resumed
+static uint8_t resume_requested;
+// set by the start screen for a game against the computer
+static uint8_t computer_requested;
+// the player this board plays in a game over the link, or 0
+static uint8_t link_player;
+
 /////////////////////////////// main //////////////////////////////////
 int main(void) {
 	// Setup hardware and call backs. This will turn on 
@@ -59,8 +74,16 @@ void initialise_hardware(void) {
 	
 	init_timer0();
 	
+	init_led_matrix();
+	
+	init_sound();
+	
+	init_journal();
+	
+	init_link();
+	
 	// Turn on global interrupts
-	sei();
+	hal_enable_interrupts();
 }
 
 void start_screen(void) {
@@ -79,6 +102,20 @@ void start_screen(void) {
 	// to be pushed or a serial input of 's'
 	start_display();
 	
+	move_terminal_cursor(10,14);
+	printf_P(PSTR("Press 'c' to play against the computer"));
+	move_terminal_cursor(10,16);
+	printf_P(PSTR("Press 't' to change the time control: "));
+	clock_print_control();
+	move_terminal_cursor(10,17);
+	printf_P(PSTR("Press 'l' to play against another board over the link"));
+	
+	// Offer to resume a game which was cut short by a reset
+	if(journal_can_resume()) {
+		move_terminal_cursor(10,15);
+		printf_P(PSTR("Press 'r' to resume the unfinished game"));
+	}
+	
 	// Wait until a button is pressed, or 's' is pressed on the terminal
 	while(1) {
 		// First check for if a 's' is pressed
@@ -93,6 +130,35 @@ void start_screen(void) {
 		if (serial_input == 's' || serial_input == 'S') {
 			break;
 		}
+		// or 'c' to play against the computer (which plays player 2)
+		if (serial_input == 'c' || serial_input == 'C') {
+			computer_requested = 1;
+			break;
+		}
+		// or 'l' to play against the other board (this one plays
+		// player 1), or the other board may start the game
+		if (serial_input == 'l' || serial_input == 'L') {
+			link_player = PLAYER_1;
+			break;
+		}
+		link_service();
+		if (link_invited()) {
+			link_player = PLAYER_2;
+			break;
+		}
+		// or 't' for the next time control
+		if (serial_input == 't' || serial_input == 'T') {
+			clock_next_control();
+			move_terminal_cursor(48,16);
+			clock_print_control();
+		}
+		// or 'r' to resume the unfinished game
+		if ((serial_input == 'r' || serial_input == 'R') && journal_can_resume()) {
+			resume_requested = 1;
+			// against the computer if the saved game was
+			computer_requested = (journal_computer_player() != 0);
+			break;
+		}
 		// Next check for any button presses
 		int8_t btn = button_pushed();
 		if (btn != NO_BUTTON_PUSHED) {
@@ -107,100 +173,230 @@ void new_game(void) {
 	
 	// Initialise the game and display
 	initialise_game();
+	computer_new_game(computer_requested ? PLAYER_2 : 0);
+	link_new_game(link_player);
+	
+	if(resume_requested) {
+		// Fast-forward the saved game into the game state, then draw it
+		// once. The journal carries on recording the same game.
+		journal_resume();
+		resume_requested = 0;
+		draw_game();
+		draw_turn_indicator();
+	} else if(link_player) {
+		// never offered for resume, as the other board couldn't carry
+		// on with it
+		journal_game_over();
+	} else {
+		journal_new_game(computer_requested ? PLAYER_2 : 0);
+	}
+	
+	// Set the clocks, which start when play does
+	clock_new_game();
 	
 	// Clear a button push or serial input if any are waiting
 	// (The cast to void means the return value is ignored.)
 	(void)button_pushed();
+	for(uint8_t button = 0; button < NUM_BUTTONS; button++) {
+		(void)button_repeats(button);
+	}
 	clear_serial_input_buffer();
 }
 
 void play_game(void) {
 	
-	uint32_t last_flash_time, current_time;
-	uint8_t btn; //the button pushed
+	uint32_t last_flash_time;
+	int8_t btn; //the button pushed
 	
 	char escape_sequence_char;
 	uint8_t chars_in_escape_sequence = 0;
 	
 	last_flash_time = get_current_time();
 	
-	// We play the game until it's over
-	while(!is_game_over()) {
+	clock_start(game_position()->to_move);
+	health_start_loop();
+	
+	// We play the game until it's over (or the other board starts another)
+	while(!is_game_over() && !(link_playing() && link_invited())) {
+		
+		// Time this pass of the loop for the health page
+		health_loop();
+		
+		// Write any journal entries to EEPROM in the background
+		journal_service();
+		
+		// Let the computer think (or ponder) for a moment
+		computer_service();
+		
+		// Send and receive moves over the link
+		link_service();
 		
 		// We need to check if any button has been pushed, this will be
 		// NO_BUTTON_PUSHED if no button has been pushed
 		btn = button_pushed();
 		
-		char serial_input = 1;
-		escape_sequence_char = -1;
-		
-		if (serial_input_available()) {
-			serial_input = fgetc(stdin);
-			if (chars_in_escape_sequence == 0 && serial_input == ESCAPE_CHAR) {
-				chars_in_escape_sequence ++;
-				serial_input = -1;
-			} else if (chars_in_escape_sequence == 1 && serial_input == '[') {
-				chars_in_escape_sequence ++;
-				serial_input = -1;
-			} else if (chars_in_escape_sequence == 2) {
-				escape_sequence_char = serial_input;
-				serial_input = -1;
-				chars_in_escape_sequence = 0;
-			} else {
-				chars_in_escape_sequence = 0;
-			}
-		}
 		/*======================================================
 		3) Move Cursor with Buttons (Level 1  12 marks)
-		========================================================
-		4) Move Cursor with Terminal Input (Level 1  5 marks) 
 		=======================================================*/
+		uint8_t moved = 0;
+		if (btn != NO_BUTTON_PUSHED) {
+			step_display_cursor(button_moves[btn][0], button_moves[btn][1]);
+			moved = 1;
+		}
 		
-		if (serial_input == 'w' || serial_input == 'W' || escape_sequence_char == 'A' || btn == BUTTON1_PUSHED) {
-			// move the cursor upwards			
-			move_display_cursor(0, 1);
-			//flush the cursor
-			last_flash_time-= 500;
-		} else if (serial_input == 'a' || serial_input == 'A' || escape_sequence_char == 'D' || btn == BUTTON3_PUSHED) {
-			// Move the cursor to the left			
-			move_display_cursor(-1, 0);
-			//flush the cursor
-			last_flash_time-= 500;
-		} else if (serial_input == 's' || serial_input == 'S' || escape_sequence_char == 'B' || btn == BUTTON0_PUSHED) {
-			// Move the cursor downwards			
-			move_display_cursor(0, -1);
-			//flush the cursor
-			last_flash_time-= 500;
-		} else if (serial_input == 'd' || serial_input == 'D' || escape_sequence_char == 'C' || btn == BUTTON2_PUSHED) {
-			// Move the cursor to the right			
-			move_display_cursor(1, 0);
+		// Take all the serial input which is waiting. Cursor moves are
+		// made without drawing them, and a run of them is shown once: when
+		// the input runs out, or before anything else (which then happens
+		// where the cursor is by then, after which the rest of the input
+		// waits for the next pass). A paste or a key repeating faster than
+		// the board can be drawn costs one redraw.
+		uint8_t more_input = 1;
+		while (more_input) {
+			char serial_input = 1;
+			escape_sequence_char = -1;
+			
+			more_input = serial_input_available();
+			if (more_input) {
+				serial_input = fgetc(stdin);
+				if (chars_in_escape_sequence == 0 && serial_input == ESCAPE_CHAR) {
+					chars_in_escape_sequence ++;
+					serial_input = -1;
+				} else if (chars_in_escape_sequence == 1 && serial_input == '[') {
+					chars_in_escape_sequence ++;
+					serial_input = -1;
+				} else if (chars_in_escape_sequence == 2) {
+					escape_sequence_char = serial_input;
+					serial_input = -1;
+					chars_in_escape_sequence = 0;
+				} else {
+					chars_in_escape_sequence = 0;
+				}
+			}
+			/*======================================================
+			4) Move Cursor with Terminal Input (Level 1  5 marks) 
+			=======================================================*/
+			int8_t dx = 0, dy = 0;
+			if (serial_input == 'w' || serial_input == 'W' || escape_sequence_char == 'A') {
+				// move the cursor upwards
+				dy = 1;
+			} else if (serial_input == 'a' || serial_input == 'A' || escape_sequence_char == 'D') {
+				// Move the cursor to the left
+				dx = -1;
+			} else if (serial_input == 's' || serial_input == 'S' || escape_sequence_char == 'B') {
+				// Move the cursor downwards
+				dy = -1;
+			} else if (serial_input == 'd' || serial_input == 'D' || escape_sequence_char == 'C') {
+				// Move the cursor to the right
+				dx = 1;
+			}
+			if (dx || dy) {
+				step_display_cursor(dx, dy);
+				moved = 1;
+				continue;
+			}
+			if (serial_input == 1 || serial_input == (char)-1) {
+				// no input, or part of an escape sequence
+				continue;
+			}
+			
+			if (moved) {
+				show_display_cursor();
+				//flush the cursor
+				last_flash_time-= CURSOR_FLASH_MS;
+				moved = 0;
+			}
+			if (serial_input == ' ' && !computer_to_move() && !link_remote_to_move()) {
+				//update the pieces (place, move, and pick handeling)
+				update_piece();
+			} else if ((serial_input == 'u' || serial_input == 'U') && !link_playing()) {
+				// take back the last placement or move (and the computer's
+				// reply to it)
+				undo_move();
+				if (computer_to_move()) {
+					undo_move();
+				}
+			} else if ((serial_input == 'r' || serial_input == 'R') && !link_playing()) {
+				// make the last undone placement or move again
+				redo_move();
+				if (computer_to_move()) {
+					redo_move();
+				}
+			} else if (serial_input == 'h' || serial_input == 'H') {
+				// show or hide where each player can win next move
+				toggle_overlay();
+			} else if (serial_input == 'i' || serial_input == 'I') {
+				// show or hide the health page
+				toggle_health();
+			} else if ((serial_input == 'x' || serial_input == 'X') && health_shown()) {
+				// start the health page's counters again
+				health_reset();
+			} else if (serial_input == 't' || serial_input == 'T') {
+				// print the latency trace (if it is built in)
+				trace_dump();
+			}
+			break;
+		}
+		
+		// Held buttons repeat their moves. If the loop has fallen behind,
+		// all the repeats since the last pass are shown as one move.
+		for(uint8_t button = 0; button < NUM_BUTTONS; button++) {
+			for(uint8_t n = button_repeats(button); n > 0; n--) {
+				step_display_cursor(button_moves[button][0], button_moves[button][1]);
+				moved = 1;
+			}
+		}
+		if (moved) {
+			show_display_cursor();
 			//flush the cursor
-			last_flash_time-= 500;
-		}else if (serial_input == ' ') {
-			//update the pieces (place, move, and pick handeling)
-			update_piece();
+			last_flash_time-= CURSOR_FLASH_MS;
 		}
-
-		current_time = get_current_time();
-		if(current_time >= last_flash_time + 500) {
-			// 500ms (0.5 second) has passed since the last time we
-			// flashed the cursor, so flash the cursor
+#ifndef CURSOR_BLINK
+		uint32_t current_time = get_current_time();
+		if(current_time >= last_flash_time + CURSOR_FLASH_MS &&
+				serial_output_pending() <= CURSOR_FLASH_BUSY_BYTES) {
+			// CURSOR_FLASH_MS has passed since the last time we
+			// flashed the cursor, and the serial port isn't busy with
+			// anything more important, so flash the cursor
 			flash_cursor();			
 			// Update the most recent time the cursor was flashed
 			last_flash_time = current_time;
 		}
+#endif
+		
+		// Show whatever has changed on the board
+		display_flush();
+		draw_clocks();
+		draw_link_stats();
+		draw_health();
 	}
 	// We get here if the game is over.
 }
 
 void handle_game_over() {
+	clock_stop();
+	link_game_over();
+	display_flush();
+	// (the game also ends when the other board starts a new one)
+	if(game_winner()) {
+		play_sound(SOUND_WIN);
+	}
+	journal_game_over();
+	
 	move_terminal_cursor(10,14);
 	printf_P(PSTR("GAME OVER"));
 	move_terminal_cursor(10,15);
 	printf_P(PSTR("Press a button to start again"));
 	
-	while(button_pushed() == NO_BUTTON_PUSHED) {
-		; // wait
+	while(button_pushed() == NO_BUTTON_PUSHED && !link_invited()) {
+		journal_service(); // finish writing the journal while we wait
+		link_service(); // and send the last move
+	}
+	
+	// Whoever starts the next game over the link plays player 1
+	if(link_invited()) {
+		link_player = PLAYER_2;
+	} else if(link_player) {
+		link_player = PLAYER_1;
 	}
 	
 }
@@ -23,11 +23,8 @@
 #include <stdio.h>
 #include <stdint.h>
 
-#include <avr/io.h>
-#include <avr/interrupt.h>
-
-/* System clock rate in Hz. (L at the end indicates this is a long constant) */
-#define SYSCLK 16000000L
+#include "hal.h"
+#include "trace.h"
 
 /* Global variables */
 /* Circular buffer to hold outgoing characters. The insert_pos variable
@@ -40,8 +37,12 @@
  * to the beginning (assuming those bytes have been output).
  * NOTE - OUTPUT_BUFFER_SIZE can not be larger than 255 without changing
  * the type of the variables below (currently defined as 8 bit unsigned ints).
+ * Both buffer sizes can be set at build time (e.g. -DOUTPUT_BUFFER_SIZE=128)
+ * to trade RAM against how often printing has to wait for the UART.
  */
+#ifndef OUTPUT_BUFFER_SIZE
 #define OUTPUT_BUFFER_SIZE 255
+#endif
 volatile char out_buffer[OUTPUT_BUFFER_SIZE];
 volatile uint8_t out_insert_pos;
 volatile uint8_t bytes_in_out_buffer;
@@ -49,12 +50,20 @@ volatile uint8_t bytes_in_out_buffer;
 /* Circular buffer to hold incoming characters. Works on same principle
  * as output buffer
  */
+#ifndef INPUT_BUFFER_SIZE
 #define INPUT_BUFFER_SIZE 16
+#endif
 volatile char input_buffer[INPUT_BUFFER_SIZE];
 volatile uint8_t input_insert_pos;
 volatile uint8_t bytes_in_input_buffer;
 volatile uint8_t input_overrun;
 
+/* The most bytes there have been in each buffer, to see how close they
+ * come to filling up
+ */
+volatile uint8_t out_high_water;
+volatile uint8_t input_high_water;
+
 /* Variable to keep track of whether incoming characters are to be echoed
  * back or not.
  */
@@ -63,17 +72,11 @@ static int8_t do_echo;
 /* Function prototypes 
  */
 void init_serial_stdio(long baudrate, int8_t echo);
+void serial_reset_stats(void);
 static int uart_put_char(char, FILE*);
 static int uart_get_char(FILE*);
 
-/* Setup a stream that uses the uart get and put functions. We will
- * make standard input and output use this stream below.
- */
-static FILE myStream = FDEV_SETUP_STREAM(uart_put_char, uart_get_char,
-		_FDEV_SETUP_RW);
-
 void init_serial_stdio(long baudrate, int8_t echo) {
-	uint16_t ubrr;
 	/*
 	 * Initialise our buffers
 	*/
@@ -81,47 +84,58 @@ void init_serial_stdio(long baudrate, int8_t echo) {
 	bytes_in_out_buffer = 0;
 	input_insert_pos = 0;
 	bytes_in_input_buffer = 0;
-	input_overrun = 0;
+	serial_reset_stats();
 	
 	/*
 	 * Record whether we're going to echo characters or not
 	*/
 	do_echo = echo;
 	
-	/* Configure the serial port baud rate */
-	/* (This differs from the datasheet formula so that we get 
-	 * rounding to the nearest integer while using integer division
-	 * (which truncates)).
-	*/
-	ubrr = ((SYSCLK / (8 * baudrate)) + 1)/2 - 1;
-	UBRR0 = ubrr;
-	
-	/*
-	 * Enable transmission and receiving via UART. We don't enable
-	 * the UDR empty interrupt here (we wait until we've got a
-	 * character to transmit).
+	/* Configure the baud rate and enable the UART (and its receive
+	 * complete interrupt). The UDR empty interrupt is only enabled
+	 * once we've got a character to transmit.
 	 * NOTE: Interrupts must be enabled globally for this
 	 * library to work, but we do not do this here.
 	*/
-	UCSR0B = (1<<RXEN0)|(1<<TXEN0);
-	
-	/*
-	 * Enable receive complete interrupt 
-	*/
-	UCSR0B  |= (1 <<RXCIE0);
+	hal_uart_init(baudrate);
 
 	/* Set up our stream so the put and get functions below are used 
 	 * to write/read characters via the serial port when we use
 	 * stdio functions
 	*/
-	stdout = &myStream;
-	stdin = &myStream;
+	hal_stdio_init(uart_put_char, uart_get_char);
 }
 
 int8_t serial_input_available(void) {
+	/* This is polled in busy-wait loops */
+	hal_idle();
 	return (bytes_in_input_buffer != 0);
 }
 
+uint8_t serial_output_pending(void) {
+	return bytes_in_out_buffer;
+}
+
+uint8_t serial_output_high_water(void) {
+	return out_high_water;
+}
+
+uint8_t serial_input_high_water(void) {
+	return input_high_water;
+}
+
+uint8_t serial_input_overruns(void) {
+	return input_overrun;
+}
+
+void serial_reset_stats(void) {
+	uint8_t interrupts_enabled = hal_disable_interrupts();
+	out_high_water = bytes_in_out_buffer;
+	input_high_water = bytes_in_input_buffer;
+	input_overrun = 0;
+	hal_restore_interrupts(interrupts_enabled);
+}
+
 void clear_serial_input_buffer(void) {
 	/* Just adjust our buffer data so it looks empty */
 	input_insert_pos = 0;
@@ -147,12 +161,13 @@ static int uart_put_char(char c, FILE* stream) {
 	 * enough space. The bytes_in_buffer variable will get modified by the
 	 * ISR which extracts bytes from the buffer.
 	*/
-	interrupts_enabled = bit_is_set(SREG, SREG_I);
+	interrupts_enabled = hal_interrupts_enabled();
 	while(bytes_in_out_buffer >= OUTPUT_BUFFER_SIZE) {
 		if(!interrupts_enabled) {
 			return 1;
 		}		
-		/* else do nothing */
+		/* else wait for the ISR to make room */
+		hal_idle();
 	}
 	
 	/* Add the character to the buffer for transmission if there
@@ -164,9 +179,12 @@ static int uart_put_char(char c, FILE* stream) {
 	 * We reenable them if they were enabled when we entered the
 	 * function.
 	*/	
-	cli();
+	hal_disable_interrupts();
 	out_buffer[out_insert_pos++] = c;
 	bytes_in_out_buffer++;
+	if(bytes_in_out_buffer > out_high_water) {
+		out_high_water = bytes_in_out_buffer;
+	}
 	if(out_insert_pos == OUTPUT_BUFFER_SIZE) {
 		/* Wrap around buffer pointer if necessary */
 		out_insert_pos = 0;
@@ -174,17 +192,15 @@ static int uart_put_char(char c, FILE* stream) {
 	/* Reenable interrupts (UDR Empty interrupt may have been
 	 * disabled) - we ensure it is now enabled so that it will
 	 * fire and deal with the next character in the buffer. */
-	UCSR0B |= (1 << UDRIE0);
-	if(interrupts_enabled) {
-		sei();
-	}
+	hal_uart_tx_interrupt(1);
+	hal_restore_interrupts(interrupts_enabled);
 	return 0;
 }
 
-int uart_get_char(FILE* stream) {
+static int uart_get_char(FILE* stream) {
 	/* Wait until we've received a character */
 	while(bytes_in_input_buffer == 0) {
-		/* do nothing */
+		hal_idle();
 	}
 	
 	/*
@@ -194,8 +210,7 @@ int uart_get_char(FILE* stream) {
 	 * characters before the insert position (taking into account
 	 * that we may need to wrap around).
 	 */
-	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
-	cli();
+	uint8_t interrupts_enabled = hal_disable_interrupts();
 	char c;
 	if(input_insert_pos - bytes_in_input_buffer < 0) {
 		/* Need to wrap around */
@@ -207,9 +222,7 @@ int uart_get_char(FILE* stream) {
 	
 	/* Decrement our count of bytes in the input buffer */
 	bytes_in_input_buffer--;
-	if(interrupts_enabled) {
-		sei();
-	}	
+	hal_restore_interrupts(interrupts_enabled);
 	return c;
 }
 
@@ -217,7 +230,7 @@ int uart_get_char(FILE* stream) {
  * Define the interrupt handler for UART Data Register Empty (i.e. 
  * another character can be taken from our buffer and written out)
  */
-ISR(USART_UDRE_vect) 
+HAL_ISR(USART_UDRE_vect) 
 {
 	/* Check if we have data in our buffer */
 	if(bytes_in_out_buffer > 0) {
@@ -241,7 +254,7 @@ ISR(USART_UDRE_vect)
 		bytes_in_out_buffer--;
 		
 		/* Output the character via the UART */
-		UDR0 = c;
+		hal_uart_write_byte(c);
 	} else {
 		/* No data in the buffer. We disable the UART Data
 		 * Register Empty interrupt because otherwise it 
@@ -249,7 +262,8 @@ ISR(USART_UDRE_vect)
 		 * The interrupt is reenabled when a character is
 		 * placed in the buffer.
 		 */
-		UCSR0B &= ~(1<<UDRIE0);
+		hal_uart_tx_interrupt(0);
+		trace(TRACE_TX_DONE, 0);
 	}
 }
 
@@ -259,11 +273,12 @@ ISR(USART_UDRE_vect)
  * the input buffer.
  */
 
-ISR(USART_RX_vect) 
+HAL_ISR(USART_RX_vect) 
 {
 	/* Read the character - we ignore the possibility of overrun. */
 	char c;
-	c = UDR0;
+	c = hal_uart_read_byte();
+	trace(TRACE_RX, c);
 		
 	if(do_echo && bytes_in_out_buffer < OUTPUT_BUFFER_SIZE) {
 		/* If echoing is enabled and there is output buffer
@@ -275,13 +290,14 @@ ISR(USART_RX_vect)
 	}
 	
 	/* 
-	 * Check if we have space in our buffer. If not, set the overrun
-	 * flag and throw away the character. (We never clear the 
-	 * overrun flag - it's up to the programmer to check/clear
-	 * this flag if desired.)
+	 * Check if we have space in our buffer. If not, count the
+	 * overrun (up to 255) and throw away the character. (The count
+	 * is only cleared by serial_reset_stats().)
 	 */
 	if(bytes_in_input_buffer >= INPUT_BUFFER_SIZE) {
-		input_overrun = 1;
+		if(input_overrun < 255) {
+			input_overrun++;
+		}
 	} else {
 		/* If the character is a carriage return, turn it into a
 		 * linefeed 
@@ -295,6 +311,9 @@ ISR(USART_RX_vect)
 		 */
 		input_buffer[input_insert_pos++] = c;
 		bytes_in_input_buffer++;
+		if(bytes_in_input_buffer > input_high_water) {
+			input_high_water = bytes_in_input_buffer;
+		}
 		if(input_insert_pos == INPUT_BUFFER_SIZE) {
 			/* Wrap around buffer pointer if necessary */
 			input_insert_pos = 0;
@@ -36,4 +36,17 @@ int8_t serial_input_available(void);
  */
 void clear_serial_input_buffer(void);
 
+/* The number of bytes waiting in the output buffer to be sent
+ */
+uint8_t serial_output_pending(void);
+
+/* The most bytes there have been in the output and input buffers, and the
+ * number of characters received (up to 255) which were lost because the
+ * input buffer was full, since start up or serial_reset_stats()
+ */
+uint8_t serial_output_high_water(void);
+uint8_t serial_input_high_water(void);
+uint8_t serial_input_overruns(void);
+void serial_reset_stats(void);
+
 #endif /* SERIALIO_H_ */
\ No newline at end of file
@@ -0,0 +1,89 @@
+/*
+ * sound.c
+ *
+ * Sound effects (see sound.h)
+ */
+
+#include <string.h>
+#include "sound.h"
+#include "hal.h"
+
+// notes waiting to be played (including the one playing), a power of 2
+#ifndef SOUND_QUEUE_SIZE
+#define SOUND_QUEUE_SIZE 16
+#endif
+
+typedef struct {
+	uint16_t frequency;	// Hz, 0 for a rest
+	uint8_t duration;	// ms
+} Note;
+
+// Each effect is a list of notes ending with a zero duration
+#define END { 0, 0 }
+static const Note illegal_notes[] PROGMEM = { {220, 60}, {0, 20}, {165, 120}, END };
+static const Note place_notes[] PROGMEM = { {880, 30}, END };
+static const Note pickup_notes[] PROGMEM = { {660, 20}, {990, 20}, END };
+static const Note win_notes[] PROGMEM = {
+	{523, 120}, {659, 120}, {784, 120}, {0, 40}, {1047, 250}, END
+};
+
+static const Note* const effects[] PROGMEM = {
+	[SOUND_ILLEGAL] = illegal_notes,
+	[SOUND_PLACE] = place_notes,
+	[SOUND_PICKUP] = pickup_notes,
+	[SOUND_WIN] = win_notes
+};
+
+// The queue. play_sound() adds at the tail, the interrupt takes from the
+// head.
+static Note queue[SOUND_QUEUE_SIZE];
+static volatile uint8_t head, count;
+// milliseconds left of the note at the head, 0 if none has started
+static uint8_t remaining;
+
+void init_sound(void) {
+	head = 0;
+	count = 0;
+	remaining = 0;
+	hal_tone_init();
+}
+
+void play_sound(uint8_t effect) {
+	const Note* notes = pgm_read_ptr(&effects[effect]);
+	for(;; notes++) {
+		Note note;
+		memcpy_P(&note, notes, sizeof(Note));
+		if(note.duration == 0) {
+			break;
+		}
+		uint8_t interrupts_were_on = hal_disable_interrupts();
+		uint8_t full = (count == SOUND_QUEUE_SIZE);
+		if(!full) {
+			queue[(head + count) & (SOUND_QUEUE_SIZE - 1)] = note;
+			count++;
+		}
+		hal_restore_interrupts(interrupts_were_on);
+		if(full) {
+			break;
+		}
+	}
+}
+
+void sound_tick(void) {
+	if(remaining) {
+		if(--remaining) {
+			return;
+		}
+		// the note at the head has finished
+		head = (head + 1) & (SOUND_QUEUE_SIZE - 1);
+		count--;
+		if(count == 0) {
+			hal_tone(0);
+			return;
+		}
+	}
+	if(count) {
+		remaining = queue[head].duration;
+		hal_tone(queue[head].frequency);
+	}
+}
@@ -0,0 +1,32 @@
+/*
+ * sound.h
+ *
+ * Sound effects on a piezo buzzer. Tones are generated in hardware by
+ * timer 1 (see hal_tone()), so the CPU does nothing while a note plays.
+ * An effect is a short tune which is put on a queue of notes; the timer 0
+ * interrupt counts down the current note each millisecond and starts the
+ * next, so playing an effect costs the game loop nothing but queueing it.
+ * If the queue is full the rest of the effect is dropped.
+ */
+
+#ifndef SOUND_H_
+#define SOUND_H_
+
+#include <stdint.h>
+
+// effects
+#define SOUND_ILLEGAL 0		// a placement or move which isn't allowed
+#define SOUND_PLACE 1		// a piece placed or put down
+#define SOUND_PICKUP 2		// a piece picked up
+#define SOUND_WIN 3			// the game has been won
+
+// set up the tone generator, call once at start up
+void init_sound(void);
+
+// queue an effect to play after anything already queued
+void play_sound(uint8_t effect);
+
+// called by the timer 0 interrupt every millisecond
+void sound_tick(void);
+
+#endif /* SOUND_H_ */
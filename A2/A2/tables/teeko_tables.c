@@ -0,0 +1,96 @@
+/*
+ * teeko_tables.c
+ *
+ * Board tables for a 5x5 board without square wins.
+ * Generated by host/gen_tables.c, do not edit.
+ */
+
+#include "teeko_tables.h"
+
+const Bitboard win_masks[POS_WINS] PROGMEM = {
+	0x0000000F, 0x0000001E, 0x000001E0, 0x000003C0,
+	0x00003C00, 0x00007800, 0x00078000, 0x000F0000,
+	0x00F00000, 0x01E00000, 0x00008421, 0x00010842,
+	0x00021084, 0x00042108, 0x00084210, 0x00108420,
+	0x00210840, 0x00421080, 0x00842100, 0x01084200,
+	0x00041041, 0x00082082, 0x00820820, 0x01041040,
+	0x00008888, 0x00011110, 0x00111100, 0x00222200,
+};
+
+const uint8_t square_lines[NUM_SQUARES][MAX_SQUARE_LINES] PROGMEM = {
+	{0, 10, 20, 0, 0, 0, 0, 0},
+	{0, 1, 11, 21, 0, 0, 0, 0},
+	{0, 1, 12, 0, 0, 0, 0, 0},
+	{0, 1, 13, 24, 0, 0, 0, 0},
+	{1, 14, 25, 0, 0, 0, 0, 0},
+	{2, 10, 15, 22, 0, 0, 0, 0},
+	{2, 3, 11, 16, 20, 23, 0, 0},
+	{2, 3, 12, 17, 21, 24, 0, 0},
+	{2, 3, 13, 18, 25, 26, 0, 0},
+	{3, 14, 19, 27, 0, 0, 0, 0},
+	{4, 10, 15, 0, 0, 0, 0, 0},
+	{4, 5, 11, 16, 22, 24, 0, 0},
+	{4, 5, 12, 17, 20, 23, 25, 26},
+	{4, 5, 13, 18, 21, 27, 0, 0},
+	{5, 14, 19, 0, 0, 0, 0, 0},
+	{6, 10, 15, 24, 0, 0, 0, 0},
+	{6, 7, 11, 16, 25, 26, 0, 0},
+	{6, 7, 12, 17, 22, 27, 0, 0},
+	{6, 7, 13, 18, 20, 23, 0, 0},
+	{7, 14, 19, 21, 0, 0, 0, 0},
+	{8, 15, 26, 0, 0, 0, 0, 0},
+	{8, 9, 16, 27, 0, 0, 0, 0},
+	{8, 9, 17, 0, 0, 0, 0, 0},
+	{8, 9, 18, 22, 0, 0, 0, 0},
+	{9, 19, 23, 0, 0, 0, 0, 0},
+};
+
+const uint8_t square_line_count[NUM_SQUARES] PROGMEM = {
+	3, 4, 3, 4, 3, 4, 6, 6, 6, 4,
+	3, 6, 8, 6, 3, 4, 6, 6, 6, 4,
+	3, 4, 3, 4, 3,
+};
+
+const Bitboard neighbour_masks[NUM_SQUARES] PROGMEM = {
+	0x00000062, 0x000000E5, 0x000001CA, 0x00000394,
+	0x00000308, 0x00000C43, 0x00001CA7, 0x0000394E,
+	0x0000729C, 0x00006118, 0x00018860, 0x000394E0,
+	0x000729C0, 0x000E5380, 0x000C2300, 0x00310C00,
+	0x00729C00, 0x00E53800, 0x01CA7000, 0x01846000,
+	0x00218000, 0x00538000, 0x00A70000, 0x014E0000,
+	0x008C0000,
+};
+
+const uint8_t square_x[NUM_SQUARES] PROGMEM = {
+	0, 1, 2, 3, 4, 0, 1, 2, 3, 4,
+	0, 1, 2, 3, 4, 0, 1, 2, 3, 4,
+	0, 1, 2, 3, 4,
+};
+
+const uint8_t square_y[NUM_SQUARES] PROGMEM = {
+	0, 0, 0, 0, 0, 1, 1, 1, 1, 1,
+	2, 2, 2, 2, 2, 3, 3, 3, 3, 3,
+	4, 4, 4, 4, 4,
+};
+
+const int8_t win_shapes[NUM_WIN_SHAPES][WIN_SHAPE_SQUARES][2] PROGMEM = {
+	{{0, 0}, {1, 0}, {2, 0}, {3, 0}},
+	{{0, 0}, {0, 1}, {0, 2}, {0, 3}},
+	{{0, 0}, {1, 1}, {2, 2}, {3, 3}},
+	{{0, 0}, {1, -1}, {2, -2}, {3, -3}},
+};
+
+const uint32_t set_numbers[WIN_SHAPE_SQUARES][NUM_SQUARES] PROGMEM = {
+	{0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
+	 10, 11, 12, 13, 14, 15, 16, 17, 18, 19,
+	 20, 21, 22, 23, 24},
+	{0, 0, 1, 3, 6, 10, 15, 21, 28, 36,
+	 45, 55, 66, 78, 91, 105, 120, 136, 153, 171,
+	 190, 210, 231, 253, 276},
+	{0, 0, 0, 1, 4, 10, 20, 35, 56, 84,
+	 120, 165, 220, 286, 364, 455, 560, 680, 816, 969,
+	 1140, 1330, 1540, 1771, 2024},
+	{0, 0, 0, 0, 1, 5, 15, 35, 70, 126,
+	 210, 330, 495, 715, 1001, 1365, 1820, 2380, 3060, 3876,
+	 4845, 5985, 7315, 8855, 10626},
+};
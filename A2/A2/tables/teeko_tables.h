@@ -0,0 +1,60 @@
+/*
+ * teeko_tables.h
+ *
+ * Board tables for a 5x5 board without square wins.
+ * Generated by host/gen_tables.c, do not edit.
+ */
+
+#ifndef TEEKO_TABLES_H_
+#define TEEKO_TABLES_H_
+
+#include <stdint.h>
+#include "hal.h"
+
+// board dimensions
+#define WIDTH 5
+#define HEIGHT 5
+#define NUM_SQUARES 25
+
+// winning lines (4 in a row, and squares if SQUARE_WINS)
+#define SQUARE_WINS 0
+#define POS_WINS 28
+
+// most winning lines through any one square
+#define MAX_SQUARE_LINES 8
+
+// shapes of winning line, and squares in each
+#define NUM_WIN_SHAPES 4
+#define WIN_SHAPE_SQUARES 4
+
+typedef uint32_t Bitboard;
+
+#define pgm_read_bitboard(addr) pgm_read_dword(addr)
+
+// Tables in flash (read them with pgm_read_byte/bitboard)
+
+// the squares of each winning line
+extern const Bitboard win_masks[POS_WINS] PROGMEM;
+
+// the winning lines through each square (square_line_count[n]
+// entries of square_lines[n] are used)
+extern const uint8_t square_lines[NUM_SQUARES][MAX_SQUARE_LINES] PROGMEM;
+extern const uint8_t square_line_count[NUM_SQUARES] PROGMEM;
+
+// the squares next to (including diagonally) each square
+extern const Bitboard neighbour_masks[NUM_SQUARES] PROGMEM;
+
+// the x and y coordinates of each square
+extern const uint8_t square_x[NUM_SQUARES] PROGMEM;
+extern const uint8_t square_y[NUM_SQUARES] PROGMEM;
+
+// the (x, y) offset of each square of each shape of winning line
+// from its first square, for finding lines with shifts of a whole
+// bitboard
+extern const int8_t win_shapes[NUM_WIN_SHAPES][WIN_SHAPE_SQUARES][2] PROGMEM;
+
+// C(n, k + 1), the number of sets of k + 1 squares below square n,
+// for numbering sets of squares (see endgame.c)
+extern const uint32_t set_numbers[WIN_SHAPE_SQUARES][NUM_SQUARES] PROGMEM;
+
+#endif /* TEEKO_TABLES_H_ */
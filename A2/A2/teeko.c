@@ -0,0 +1,385 @@
+/*
+ * teeko.c
+ *
+ * The rules of Teeko (see teeko.h)
+ */
+
+#include <string.h>
+#include "teeko.h"
+
+// squares not in the first or last column, so shifting left or right
+// doesn't wrap onto the next row
+#define ROW_0 (((Bitboard)1 << WIDTH) - 1)
+#define COLUMN_0 (ALL_SQUARES / ROW_0)
+#define NOT_FIRST_COLUMN (ALL_SQUARES & ~COLUMN_0)
+#define NOT_LAST_COLUMN (ALL_SQUARES & ~(COLUMN_0 << (WIDTH - 1)))
+
+// Zobrist key for the player to move being PLAYER_2
+#define SIDE_KEY 0x5BD1E995u
+
+// Zobrist key for a piece of player (1 or 2) on a square. Keys are mixed
+// from the square number rather than kept in a table.
+static uint32_t piece_key(uint8_t player, uint8_t square) {
+	uint32_t x = (uint32_t)(player * NUM_SQUARES + square + 1) * 0x9E3779B1u;
+	x ^= x >> 15;
+	x *= 0x85EBCA77u;
+	x ^= x >> 13;
+	return x;
+}
+
+void teeko_init(Position* position) {
+	position->pieces[0] = 0;
+	position->pieces[1] = 0;
+	position->to_move = PLAYER_1;
+	position->placed = 0;
+	position->hash = 0;
+	memset(position->lines, 0, sizeof(position->lines));
+}
+
+uint8_t teeko_count(Bitboard squares) {
+#ifdef __AVR__
+	uint8_t count = 0;
+	while(squares) {
+		squares &= squares - 1;
+		count++;
+	}
+	return count;
+#else
+	return __builtin_popcountll(squares);
+#endif
+}
+
+Bitboard teeko_neighbours(Bitboard squares) {
+	// spread sideways first, then up and down
+	Bitboard row = squares | ((squares << 1) & NOT_FIRST_COLUMN) |
+			((squares >> 1) & NOT_LAST_COLUMN);
+	return (row | (row << WIDTH) | (row >> WIDTH)) & ALL_SQUARES & ~squares;
+}
+
+// the squares whose square dx columns right and dy rows up is in squares
+// (the whole board moves at once, and nothing wraps round the edges)
+static Bitboard shift_squares(Bitboard squares, int8_t dx, int8_t dy) {
+	int8_t offset = dx + dy * WIDTH;
+	// the columns which have a column dx across on the board
+	Bitboard row = (dx >= 0) ? ROW_0 >> dx : (ROW_0 << -dx) & ROW_0;
+	squares = (offset >= 0) ? squares >> offset : squares << -offset;
+	return squares & ALL_SQUARES & (COLUMN_0 * row);
+}
+
+Bitboard teeko_completing_squares(Bitboard pieces, Bitboard empty) {
+	Bitboard found = 0;
+	for(uint8_t shape = 0; shape < NUM_WIN_SHAPES; shape++) {
+		const int8_t (*offsets)[2] = win_shapes[shape];
+		// the empty square can be any square k of the shape, with pieces
+		// on all the others
+		for(uint8_t k = 0; k < WIN_SHAPE_SQUARES; k++) {
+			int8_t kx = pgm_read_byte(&offsets[k][0]);
+			int8_t ky = pgm_read_byte(&offsets[k][1]);
+			Bitboard squares = empty;
+			for(uint8_t i = 0; i < WIN_SHAPE_SQUARES && squares; i++) {
+				if(i != k) {
+					squares &= shift_squares(pieces,
+							(int8_t)pgm_read_byte(&offsets[i][0]) - kx,
+							(int8_t)pgm_read_byte(&offsets[i][1]) - ky);
+				}
+			}
+			found |= squares;
+		}
+	}
+	return found;
+}
+
+Bitboard teeko_winning_moves(const Position* position, uint8_t player,
+		Bitboard* from) {
+	Bitboard mine = position->pieces[player - 1];
+	Bitboard empty = ALL_SQUARES & ~(position->pieces[0] | position->pieces[1]);
+	*from = 0;
+	if(teeko_count(mine) < PIECES_PER_PLAYER) {
+		// placing the last piece
+		return teeko_completing_squares(mine, empty);
+	}
+
+	// a line of all the pieces but one, next to the square it can move to
+	Bitboard to = 0;
+	for(Bitboard rest = mine; rest; rest &= rest - 1) {
+		Bitboard piece = rest & ~(rest - 1);
+		Bitboard squares = teeko_completing_squares(mine & ~piece, empty) &
+				teeko_neighbours(piece);
+		if(squares) {
+			to |= squares;
+			*from |= piece;
+		}
+	}
+	return to;
+}
+
+uint8_t teeko_is_win(Bitboard squares) {
+	for(uint8_t m = 0; m < POS_WINS; m++) {
+		Bitboard line = pgm_read_bitboard(&win_masks[m]);
+		if((squares & line) == line) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+uint8_t teeko_longest_line(Bitboard squares) {
+	uint8_t longest = 0;
+	for(uint8_t m = 0; m < POS_WINS; m++) {
+		uint8_t length = teeko_count(squares & pgm_read_bitboard(&win_masks[m]));
+		if(length > longest) {
+			longest = length;
+		}
+	}
+	return longest;
+}
+
+uint8_t teeko_move_won(const Position* position, Move move) {
+	// the player who made the move is no longer the one to move
+	uint8_t player = 3 - position->to_move;
+	uint8_t to = MOVE_TO(move);
+	uint8_t count = pgm_read_byte(&square_line_count[to]);
+	for(uint8_t i = 0; i < count; i++) {
+		uint8_t m = pgm_read_byte(&square_lines[to][i]);
+		if(LINE_COUNT(position, m, player) == PIECES_PER_PLAYER) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+uint8_t teeko_winner(const Position* position) {
+	if(teeko_is_win(position->pieces[0])) {
+		return PLAYER_1;
+	} else if(teeko_is_win(position->pieces[1])) {
+		return PLAYER_2;
+	}
+	return 0;
+}
+
+uint8_t teeko_generate_moves(const Position* position, Move* moves) {
+	Bitboard mine = position->pieces[position->to_move - 1];
+	Bitboard empty = ALL_SQUARES & ~(position->pieces[0] | position->pieces[1]);
+	uint8_t count = 0;
+
+	if(teeko_placing(position)) {
+		for(uint8_t to = 0; to < NUM_SQUARES; to++) {
+			if(empty & SQUARE_BIT(to)) {
+				moves[count++] = MAKE_MOVE(MOVE_PLACE, to);
+			}
+		}
+		return count;
+	}
+
+	for(uint8_t from = 0; from < NUM_SQUARES; from++) {
+		if(mine & SQUARE_BIT(from)) {
+			Bitboard targets = pgm_read_bitboard(&neighbour_masks[from]) & empty;
+			for(uint8_t to = 0; targets; to++) {
+				if(targets & SQUARE_BIT(to)) {
+					moves[count++] = MAKE_MOVE(from, to);
+					targets &= ~SQUARE_BIT(to);
+				}
+			}
+		}
+	}
+	return count;
+}
+
+uint8_t teeko_is_legal(const Position* position, Move move) {
+	Move moves[MAX_MOVES];
+	uint8_t count = teeko_generate_moves(position, moves);
+	for(uint8_t i = 0; i < count; i++) {
+		if(moves[i] == move) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// add (or remove) a piece of the player to move on a square, keeping the
+// hash and line counts up to date
+static void toggle_piece(Position* position, uint8_t square, int8_t change) {
+	uint8_t player = position->to_move;
+	position->pieces[player - 1] ^= SQUARE_BIT(square);
+	position->hash ^= piece_key(player, square);
+
+	int8_t step = (player == PLAYER_1) ? change : change * 16;
+	uint8_t count = pgm_read_byte(&square_line_count[square]);
+	for(uint8_t i = 0; i < count; i++) {
+		position->lines[pgm_read_byte(&square_lines[square][i])] += step;
+	}
+}
+
+void teeko_make(Position* position, Move move) {
+	if(MOVE_FROM(move) == MOVE_PLACE) {
+		position->placed++;
+	} else {
+		toggle_piece(position, MOVE_FROM(move), -1);
+	}
+	toggle_piece(position, MOVE_TO(move), 1);
+	position->to_move = 3 - position->to_move; //alternate between 1 and 2
+	position->hash ^= SIDE_KEY;
+}
+
+void teeko_unmake(Position* position, Move move) {
+	position->to_move = 3 - position->to_move;
+	position->hash ^= SIDE_KEY;
+	toggle_piece(position, MOVE_TO(move), -1);
+	if(MOVE_FROM(move) == MOVE_PLACE) {
+		position->placed--;
+	} else {
+		toggle_piece(position, MOVE_FROM(move), 1);
+	}
+}
+
+// write the low bits of value into the code starting at bit at
+static void put_bits(uint8_t* code, uint8_t at, Bitboard value, uint8_t bits) {
+	while(bits) {
+		uint8_t shift = at & 7;
+		uint8_t take = 8 - shift;
+		if(take > bits) {
+			take = bits;
+		}
+		code[at >> 3] |= (uint8_t)((value & ((1 << take) - 1)) << shift);
+		value >>= take;
+		at += take;
+		bits -= take;
+	}
+}
+
+static Bitboard get_bits(const uint8_t* code, uint8_t at, uint8_t bits) {
+	Bitboard value = 0;
+	uint8_t got = 0;
+	while(got < bits) {
+		uint8_t shift = at & 7;
+		uint8_t take = 8 - shift;
+		if(take > bits - got) {
+			take = bits - got;
+		}
+		value |= (Bitboard)((code[at >> 3] >> shift) & ((1 << take) - 1)) << got;
+		at += take;
+		got += take;
+	}
+	return value;
+}
+
+// the state after the two boards: player 2 to move, then a piece picked
+// up, then which of the mover's pieces
+#define STATE_BITS 4
+#define STATE_P2 0x01
+#define STATE_PICKUP 0x02
+#define STATE_INDEX_SHIFT 2
+
+void teeko_encode(const Position* position, uint8_t pickup, uint8_t* code) {
+	memset(code, 0, POSITION_CODE_SIZE);
+	put_bits(code, 0, position->pieces[0], NUM_SQUARES);
+	put_bits(code, NUM_SQUARES, position->pieces[1], NUM_SQUARES);
+	uint8_t state = (position->to_move == PLAYER_2) ? STATE_P2 : 0;
+	if(pickup != NO_PICKUP) {
+		// number the piece by the mover's pieces on lower squares
+		Bitboard below = position->pieces[position->to_move - 1] & (SQUARE_BIT(pickup) - 1);
+		state |= STATE_PICKUP | (teeko_count(below) << STATE_INDEX_SHIFT);
+	}
+	put_bits(code, 2 * NUM_SQUARES, state, STATE_BITS);
+}
+
+uint8_t teeko_decode(const uint8_t* code, Position* position, uint8_t* pickup) {
+	Bitboard pieces[2] = {
+		get_bits(code, 0, NUM_SQUARES),
+		get_bits(code, NUM_SQUARES, NUM_SQUARES)
+	};
+	uint8_t state = get_bits(code, 2 * NUM_SQUARES, STATE_BITS);
+	uint8_t to_move = (state & STATE_P2) ? PLAYER_2 : PLAYER_1;
+	uint8_t index = state >> STATE_INDEX_SHIFT;
+
+	// unused bits must be zero, and the pieces must be ones a game can have
+	for(uint8_t bit = POSITION_CODE_BITS; bit < 8 * POSITION_CODE_SIZE; bit++) {
+		if(code[bit >> 3] & (1 << (bit & 7))) {
+			return 0;
+		}
+	}
+	uint8_t counts[2] = { teeko_count(pieces[0]), teeko_count(pieces[1]) };
+	if((pieces[0] & pieces[1]) || counts[0] > PIECES_PER_PLAYER ||
+			counts[1] > PIECES_PER_PLAYER) {
+		return 0;
+	}
+	// a game stops at the first line, so only one player can have one
+	if(teeko_is_win(pieces[0]) && teeko_is_win(pieces[1])) {
+		return 0;
+	}
+	uint8_t placed = counts[0] + counts[1];
+	if(placed < 2 * PIECES_PER_PLAYER) {
+		// placing: player 1 is to move when both have placed as many, and
+		// nothing can be picked up
+		if(counts[0] - counts[1] != (to_move == PLAYER_2) || (state & STATE_PICKUP)) {
+			return 0;
+		}
+	}
+	if(!(state & STATE_PICKUP) && index) {
+		return 0;
+	}
+
+	uint8_t square = NO_PICKUP;
+	if(state & STATE_PICKUP) {
+		// the index-th lowest of the mover's pieces
+		Bitboard mine = pieces[to_move - 1];
+		while(index--) {
+			mine &= mine - 1;
+		}
+		for(square = 0; !(mine & SQUARE_BIT(square)); square++) {
+		}
+	}
+
+	// add the pieces one at a time to set up the line counts and hash
+	teeko_init(position);
+	for(uint8_t player = PLAYER_1; player <= PLAYER_2; player++) {
+		position->to_move = player;
+		for(uint8_t s = 0; s < NUM_SQUARES; s++) {
+			if(pieces[player - 1] & SQUARE_BIT(s)) {
+				toggle_piece(position, s, 1);
+			}
+		}
+	}
+	position->to_move = to_move;
+	if(to_move == PLAYER_2) {
+		position->hash ^= SIDE_KEY;
+	}
+	position->placed = placed;
+	*pickup = square;
+	return 1;
+}
+
+void history_init(MoveHistory* history) {
+	history->length = 0;
+	history->redo_length = 0;
+}
+
+void history_make(MoveHistory* history, Position* position, Move move) {
+	if(history->length == HISTORY_SIZE) {
+		// forget the oldest move
+		memmove(history->moves, history->moves + 1,
+				(HISTORY_SIZE - 1) * sizeof(Move));
+		history->length--;
+	}
+	teeko_make(position, move);
+	history->moves[history->length++] = move;
+	history->redo_length = history->length;
+}
+
+Move history_undo(MoveHistory* history, Position* position) {
+	if(history->length == 0) {
+		return MOVE_NONE;
+	}
+	Move move = history->moves[--history->length];
+	teeko_unmake(position, move);
+	return move;
+}
+
+Move history_redo(MoveHistory* history, Position* position) {
+	if(history->length == history->redo_length) {
+		return MOVE_NONE;
+	}
+	Move move = history->moves[history->length++];
+	teeko_make(position, move);
+	return move;
+}
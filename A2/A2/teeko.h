@@ -0,0 +1,151 @@
+/*
+ * teeko.h
+ *
+ * The rules of Teeko on a compact position representation, with no
+ * display or input code, so that they can be shared by the game, the
+ * computer player and the host tools (and used from several threads).
+ *
+ * Squares are numbered y*WIDTH + x as in game.c and a set of squares is
+ * a Bitboard with bit n set for square n. The board size, the winning
+ * lines and the other board tables are generated for the variant being
+ * built (see teeko_tables.h and host/gen_tables.c).
+ *
+ * Moves are made and unmade in place (teeko_make(), teeko_unmake()), so
+ * a search or an undo history needs to keep only the 2-byte moves rather
+ * than copies of the position.
+ */
+
+#ifndef TEEKO_H_
+#define TEEKO_H_
+
+#include <stdint.h>
+#include "display.h"
+#include "teeko_tables.h"
+
+#define PIECES_PER_PLAYER 4
+
+#define SQUARE_BIT(square) ((Bitboard)1 << (square))
+#define ALL_SQUARES (SQUARE_BIT(NUM_SQUARES) - 1)
+
+typedef struct {
+	Bitboard pieces[2];	// squares held by PLAYER_1 and PLAYER_2
+	uint8_t to_move;	// PLAYER_1 or PLAYER_2
+	uint8_t placed;		// pieces placed so far, phase 2 starts at 8
+	uint32_t hash;		// Zobrist hash of the pieces and player to move
+	// pieces of player 1 (low 4 bits) and player 2 (high 4 bits) on each
+	// winning line, kept up to date by teeko_make() and teeko_unmake()
+	uint8_t lines[POS_WINS];
+} Position;
+
+#define LINE_COUNT(position, m, player) \
+	(((position)->lines[m] >> (((player) - 1) * 4)) & 0x0F)
+
+// A move is 2 bytes: the square moved from (MOVE_PLACE for a placement
+// in phase 1) in the high byte and the square moved to in the low byte.
+typedef uint16_t Move;
+#define MOVE_PLACE 0xFF
+#define MOVE_NONE 0xFFFF
+#define MAKE_MOVE(from, to) ((Move)(((from) << 8) | (to)))
+#define MOVE_FROM(move) ((uint8_t)((move) >> 8))
+#define MOVE_TO(move) ((uint8_t)(move))
+
+// enough room for any list of legal moves: a placement on every square,
+// or a move to all 8 neighbours of every piece
+#define MAX_MOVES (NUM_SQUARES > 8 * PIECES_PER_PLAYER ? NUM_SQUARES : \
+		8 * PIECES_PER_PLAYER)
+
+// set up the starting position
+void teeko_init(Position* position);
+
+// returns 1 while pieces are still being placed
+static inline uint8_t teeko_placing(const Position* position) {
+	return position->placed < 2 * PIECES_PER_PLAYER;
+}
+
+// number of squares in a bitboard
+uint8_t teeko_count(Bitboard squares);
+
+// squares next to (including diagonally) any of the given squares
+Bitboard teeko_neighbours(Bitboard squares);
+
+// returns 1 if the squares include a complete winning line
+uint8_t teeko_is_win(Bitboard squares);
+
+// length of the longest part of a winning line made by the squares
+uint8_t teeko_longest_line(Bitboard squares);
+
+// the empty squares which would complete a winning line with the pieces
+// (found by shifting whole bitboards, not square by square)
+Bitboard teeko_completing_squares(Bitboard pieces, Bitboard empty);
+
+// the squares where the player could win with their next placement or
+// move, whether or not it is their turn. For moves, the pieces which can
+// move to win are put in *from.
+Bitboard teeko_winning_moves(const Position* position, uint8_t player,
+		Bitboard* from);
+
+// returns PLAYER_1 or PLAYER_2 if that player has won, else 0
+uint8_t teeko_winner(const Position* position);
+
+// returns 1 if the move just made with teeko_make() won the game
+uint8_t teeko_move_won(const Position* position, Move move);
+
+// fill moves[] with the legal moves for the player to move and return
+// how many there are
+uint8_t teeko_generate_moves(const Position* position, Move* moves);
+
+// returns 1 if the move is legal for the player to move
+uint8_t teeko_is_legal(const Position* position, Move move);
+
+// make a legal move for the player to move, and take it back again
+// (the move must be the last one made)
+void teeko_make(Position* position, Move move);
+void teeko_unmake(Position* position, Move move);
+
+/* A position, and the piece picked up to be moved if there is one, packed
+ * into POSITION_CODE_SIZE bytes (7 on the 5x5 board): player 1's squares
+ * in the low NUM_SQUARES bits, then player 2's, then whether player 2 is
+ * to move, whether a piece is picked up and which of the mover's pieces it
+ * is (counting from the lowest square), all least significant bit first.
+ * The phase follows from the number of pieces. Every state has exactly
+ * one code, with unused bits zero, so codes can be compared and hashed as
+ * they are, and it is the same on the AVR and the host.
+ */
+#define POSITION_CODE_BITS (2 * NUM_SQUARES + 4)
+#define POSITION_CODE_SIZE ((POSITION_CODE_BITS + 7) / 8)
+#define NO_PICKUP 0xFF
+
+// pack a position, with the square of the picked up piece (one of the
+// player to move's) or NO_PICKUP
+void teeko_encode(const Position* position, uint8_t pickup, uint8_t* code);
+
+// unpack a code into a position (with its line counts and hash) and the
+// square of the picked up piece or NO_PICKUP. Returns 0, leaving them
+// unchanged, if the code isn't of a position which can come up in a game.
+uint8_t teeko_decode(const uint8_t* code, Position* position, uint8_t* pickup);
+
+/* A history of moves made, for undo and redo. Moves beyond length have
+ * been undone and can be redone until a different move is made. If the
+ * history fills up the oldest moves are forgotten. Each move kept costs 2
+ * bytes of RAM.
+ */
+#ifndef HISTORY_SIZE
+#define HISTORY_SIZE 32
+#endif
+typedef struct {
+	Move moves[HISTORY_SIZE];
+	uint8_t length;		// moves made
+	uint8_t redo_length;	// moves made or undone
+} MoveHistory;
+
+void history_init(MoveHistory* history);
+
+// make a move and record it, forgetting any moves which could be redone
+void history_make(MoveHistory* history, Position* position, Move move);
+
+// undo the last move or redo the last undone move. Returns the move, or
+// MOVE_NONE if there is nothing to undo or redo.
+Move history_undo(MoveHistory* history, Position* position);
+Move history_redo(MoveHistory* history, Position* position);
+
+#endif /* TEEKO_H_ */
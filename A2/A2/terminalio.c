@@ -7,7 +7,7 @@
 #include <stdio.h>
 #include <stdint.h>
 
-#include <avr/pgmspace.h>
+#include "hal.h"
 
 #include "terminalio.h"
 
@@ -8,22 +8,18 @@
  * can be retrieved using the get_clock_ticks() function.
  */
 
-#include <avr/io.h>
-#include <avr/interrupt.h>
-
 #include "timer0.h"
+#include "hal.h"
+#include "buttons.h"
+#include "clock.h"
+#include "sound.h"
 
 /* Our internal clock tick count - incremented every 
  * millisecond. Will overflow every ~49 days. */
 static volatile uint32_t clockTicks;
 
-/* Set up timer 0 to generate an interrupt every 1ms. 
- * We will divide the clock by 64 and count up to 249.
- * We will therefore get an interrupt every 64 x 250
- * clock cycles, i.e. every 1 milliseconds with a 16MHz
- * clock. 
- * The counter will be reset to 0 when it reaches it's
- * output compare value.
+/* Set up timer 0 to generate an interrupt every 1ms (see hal_timer0_init())
+ * and reset our tick count.
  */
 void init_timer0(void) {
 	/* Reset clock tick count. L indicates a long (32 bit) 
@@ -31,29 +27,8 @@ void init_timer0(void) {
 	 */
 	clockTicks = 0L;
 	
-	/* Clear the timer */
-	TCNT0 = 0;
-
-	/* Set the output compare value to be 124 */
-	OCR0A = 249;
-	
-	/* Set the timer to clear on compare match (CTC mode)
-	 * and to divide the clock by 64. This starts the timer
-	 * running.
-	 */
-	TCCR0A = (1<<WGM01);
-	TCCR0B = (1<<CS01)|(1<<CS00);
-
-	/* Enable an interrupt on output compare match. 
-	 * Note that interrupts have to be enabled globally
-	 * before the interrupts will fire.
-	 */
-	TIMSK0 |= (1<<OCIE0A);
-	
-	/* Make sure the interrupt flag is cleared by writing a 
-	 * 1 to it.
-	 */
-	TIFR0 &= (1<<OCF0A);
+	/* Start the timer running */
+	hal_timer0_init();
 }
 
 uint32_t get_current_time(void) {
@@ -64,16 +39,36 @@ uint32_t get_current_time(void) {
 	 * of the value. Interrupts are re-enabled if they were
 	 * enabled at the start.
 	 */
-	uint8_t interruptsOn = bit_is_set(SREG, SREG_I);
-	cli();
+	uint8_t interruptsOn = hal_disable_interrupts();
 	returnValue = clockTicks;
-	if(interruptsOn) {
-		sei();
-	}
+	hal_restore_interrupts(interruptsOn);
 	return returnValue;
 }
 
-ISR(TIMER0_COMPA_vect) {
+uint32_t get_current_time_us(void) {
+	uint8_t interruptsOn = hal_disable_interrupts();
+	uint32_t ticks = clockTicks;
+	uint8_t count = hal_timer0_count();
+	/* If the count has wrapped while interrupts were off the tick
+	 * hasn't been counted yet (a small count is after the wrap)
+	 */
+	if(hal_timer0_tick_pending() && count < 125) {
+		ticks++;
+	}
+	hal_restore_interrupts(interruptsOn);
+	return ticks * 1000 + count * 4;
+}
+
+HAL_ISR(TIMER0_COMPA_vect) {
 	/* Increment our clock tick count */
 	clockTicks++;
+	
+	/* Run the game clock of the player to move */
+	clock_tick();
+	
+	/* Move the sound effects on by a millisecond */
+	sound_tick();
+	
+	/* Repeat any buttons held down */
+	button_tick();
 }
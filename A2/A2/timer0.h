@@ -30,4 +30,10 @@ void init_timer0(void);
  */
 uint32_t get_current_time(void);
 
+/* Return the time in microseconds (to 4us) since the timer was
+ * initialised. This wraps around every 71 minutes so is only good for
+ * timing short intervals.
+ */
+uint32_t get_current_time_us(void);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,64 @@
+/*
+ * trace.c
+ *
+ * Input to display latency tracing (see trace.h)
+ */
+
+#include "trace.h"
+
+#ifdef TRACE
+
+#include <stdio.h>
+#include "hal.h"
+#include "timer0.h"
+
+typedef struct {
+	uint32_t time;
+	uint8_t event;
+	uint8_t arg;
+} TraceEvent;
+
+static TraceEvent ring[TRACE_SIZE];
+static uint8_t ring_next;		// where the next event goes
+static uint8_t ring_count;
+static volatile uint8_t dumping;	// nothing is recorded while dumping
+
+void trace(uint8_t event, uint8_t arg) {
+	if(dumping) {
+		return;
+	}
+	uint8_t interrupts_on = hal_disable_interrupts();
+	uint8_t last = (ring_next + TRACE_SIZE - 1) % TRACE_SIZE;
+	if(event == TRACE_TX_DONE && ring_count && ring[last].event == TRACE_TX_DONE) {
+		// nothing happened since the UART last emptied, only the time
+		// it finally did matters
+		ring[last].time = get_current_time_us();
+	} else {
+		TraceEvent* entry = &ring[ring_next];
+		entry->time = get_current_time_us();
+		entry->event = event;
+		entry->arg = arg;
+		ring_next = (ring_next + 1) % TRACE_SIZE;
+		if(ring_count < TRACE_SIZE) {
+			ring_count++;
+		}
+	}
+	hal_restore_interrupts(interrupts_on);
+}
+
+void trace_dump(void) {
+	dumping = 1;
+	printf_P(PSTR("\n" TRACE_DUMP_BEGIN " %u\n"), ring_count);
+	uint8_t index = (ring_next + TRACE_SIZE - ring_count) % TRACE_SIZE;
+	for(uint8_t i = 0; i < ring_count; i++) {
+		const TraceEvent* entry = &ring[index];
+		printf_P(PSTR("%08lx %02x %02x\n"), (unsigned long)entry->time, entry->event,
+				entry->arg);
+		index = (index + 1) % TRACE_SIZE;
+	}
+	printf_P(PSTR(TRACE_DUMP_END "\n"));
+	ring_count = 0;
+	dumping = 0;
+}
+
+#endif /* TRACE */
@@ -0,0 +1,60 @@
+/*
+ * trace.h
+ *
+ * Optional tracing of where the time goes between an input and the
+ * terminal showing its effect. Built with TRACE defined, events are time
+ * stamped (in microseconds) into a ring holding the last TRACE_SIZE of
+ * them: each byte received and button pushed (from their interrupt
+ * handlers), the start and end of each stage of handling it, and the
+ * UART emptying its output buffer (the last time only, if nothing else
+ * happens in between). trace_dump() prints the ring on the
+ * terminal as text, which build/trace_json turns into a Chrome trace
+ * (for chrome://tracing or Perfetto).
+ *
+ * Without TRACE the calls compile to nothing.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stdint.h>
+
+#ifndef TRACE_SIZE
+#define TRACE_SIZE 32
+#endif
+
+// events, and their argument
+#define TRACE_RX 1			// the byte received
+#define TRACE_BUTTON 2		// the button pushed
+#define TRACE_TX_DONE 3		// the last byte in the buffer has gone
+#define TRACE_BEGIN 0x10	// plus the stage
+#define TRACE_END 0x20		// plus the stage
+
+// stages of handling an input
+#define STAGE_MOVE_CURSOR 0	// move_display_cursor()
+#define STAGE_UPDATE_PIECE 1	// update_piece()
+#define STAGE_DRAW_GAME 2	// draw_game()
+#define STAGE_REPAINT 3	// the terminal repainting changed squares
+#define STAGE_COUNT 4
+
+// The dump is a line "trace begin <events>", a line "<time> <event> <arg>"
+// in hex for each event, oldest first, and a line "trace end"
+#define TRACE_DUMP_BEGIN "trace begin"
+#define TRACE_DUMP_END "trace end"
+
+#ifdef TRACE
+
+// record an event, from anywhere (interrupt handlers included)
+void trace(uint8_t event, uint8_t arg);
+
+// print the ring on the terminal and empty it
+void trace_dump(void);
+
+#else
+
+#define trace(event, arg) ((void)0)
+#define trace_dump() ((void)0)
+
+#endif /* TRACE */
+
+#endif /* TRACE_H_ */